@@ -0,0 +1,5306 @@
+// Definiciones del núcleo de la agenda de contactos (ver AgendaContactos.h)
+#include "AgendaContactos.h"
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h> // Instrucciones SSE2 para la validación por lotes
+#endif
+#ifdef __AVX2__
+#include <immintrin.h> // Instrucciones AVX2 para buscar en el email de a 32 bytes
+#endif
+
+// Función para empaquetar un número de celular de 10 dígitos en un entero
+uint64_t empaquetarNumeroCelular(string_view numero)
+{
+    uint64_t valor = 0;
+    for (char c : numero)
+    {
+        valor = valor * 10 + static_cast<uint64_t>(c - '0');
+    }
+    return valor;
+}
+
+// Función para recuperar los 10 dígitos de un número de celular empaquetado (con ceros a la izquierda)
+string desempaquetarNumeroCelular(uint64_t valor)
+{
+    string numero(10, '0');
+    for (int i = 9; i >= 0; --i)
+    {
+        numero[i] = static_cast<char>('0' + valor % 10);
+        valor /= 10;
+    }
+    return numero;
+}
+
+// Función para validar el número de celular (10 dígitos)
+bool validarNumeroCelular(string_view numero)
+{
+    // Se comprueba que el número tenga exactamente 10 caracteres
+    if (numero.size() != 10)
+    {
+        return false;
+    }
+
+    // Se recorre cada caracter en el número
+    for (char c : numero)
+    {
+        //  Se compueba si el carácter no es un dígito (debe estar entre '0' y '9')
+        if (c < '0' || c > '9')
+        {
+            return false;
+        }
+    }
+    // Retorna 'true' si todos los caracteres son dígitos  y la longitud es correcta
+    return true;
+}
+
+// Función para validar un email
+bool validarEmail(string_view email)
+{
+    // Varibale para verificar si se encuentra el símbolo '@'.
+    bool tieneArroba = false;
+    // Variable para verificar si se encuentra el símbolo '.'.
+    bool tienePunto = false;
+    // Verifica si '@' aparece antes de '.'
+    bool arrobaAntesDePunto = false;
+
+    // Se recorre cada caracter del email
+    for (size_t i = 0; i < email.size(); i++)
+    {
+        // Si se encuentra el símbolo '@', retorna true.
+        if (email[i] == '@')
+        {
+            tieneArroba = true;
+            // Si ya se encontró un punto antes, se marca que '@' está antes de '.'
+            if (tienePunto)
+                arrobaAntesDePunto = true;
+        }
+
+        // Si se encuentra el punto, se marca que se encontró y la posible relación con el '@'
+        if (email[i] == '.')
+        {
+            tienePunto = true;
+            // Si ya se encontró un '@' antes, se marca que '@' está antes de '.'
+            if (tieneArroba)
+                arrobaAntesDePunto = true;
+        }
+    }
+
+    // Se verifica que estén ambos símbolos y que '@' aparezca antes de '.'
+    return tieneArroba && tienePunto && arrobaAntesDePunto;
+}
+
+// Función para calcular la clave de orden de un nombre
+string calcularClaveOrden(string_view nombre)
+{
+    string clave;
+    clave.reserve(nombre.size());
+    for (size_t posicion = 0; posicion < nombre.size();)
+    {
+        clave.push_back(static_cast<char>(leerPesoOrden(nombre, posicion)));
+    }
+    return clave;
+}
+
+// Función para calcular el grupo (0 = 'A',...,25 = 'Z') de un nombre
+int calcularLetraInicial(string_view nombre)
+{
+    if (nombre.empty())
+    {
+        return -1;
+    }
+    size_t posicion = 0;
+    unsigned char peso = leerPesoOrden(nombre, posicion);
+    if (peso == PESO_ENIE)
+    {
+        return 'n' - 'a';
+    }
+    // De la 'o' en adelante los pesos están corridos un lugar por la ñ
+    int letraInicial = peso < PESO_ENIE ? peso - 'a' : peso - 'a' - 1;
+    return (letraInicial >= 0 && letraInicial < 26) ? letraInicial : -1;
+}
+
+// Función para comparar dos nombres en orden alfabético español
+int compararNombres(string_view a, string_view b)
+{
+    size_t posicionA = 0, posicionB = 0;
+    while (posicionA < a.size() && posicionB < b.size())
+    {
+        unsigned char pesoA = leerPesoOrden(a, posicionA), pesoB = leerPesoOrden(b, posicionB);
+        if (pesoA != pesoB)
+        {
+            return pesoA < pesoB ? -1 : 1;
+        }
+    }
+    // Una clave que es el comienzo de la otra va antes; si son iguales se desempata por los bytes
+    bool terminoA = posicionA == a.size(), terminoB = posicionB == b.size();
+    if (terminoA != terminoB)
+    {
+        return terminoA ? -1 : 1;
+    }
+    int comparacion = a.compare(b);
+    return comparacion < 0 ? -1 : (comparacion > 0 ? 1 : 0);
+}
+
+// Función para comparar el comienzo de un nombre con un prefijo, en orden alfabético español
+int compararConPrefijo(string_view nombre, string_view prefijo)
+{
+    size_t posicionNombre = 0, posicionPrefijo = 0;
+    while (posicionNombre < nombre.size() && posicionPrefijo < prefijo.size())
+    {
+        unsigned char pesoNombre = leerPesoOrden(nombre, posicionNombre), pesoPrefijo = leerPesoOrden(prefijo, posicionPrefijo);
+        if (pesoNombre != pesoPrefijo)
+        {
+            return pesoNombre < pesoPrefijo ? -1 : 1;
+        }
+    }
+    // Un nombre más corto que el prefijo (y que coincide hasta donde llega) va antes
+    return posicionPrefijo < prefijo.size() ? -1 : 0;
+}
+
+// Función de búsqueda binaria (calcula la clave de orden del nombre buscado una sola vez)
+bool busquedaBinaria(const AlmacenContactos &almacen, const vector<uint32_t> &contactos, string_view nombre, int &index)
+{
+    return busquedaBinaria(almacen, contactos, ClaveOrden(nombre), index);
+}
+
+// Función de búsqueda binaria
+bool busquedaBinaria(const AlmacenContactos &almacen, const vector<uint32_t> &contactos, const ClaveOrden &buscada, int &index)
+{
+    // Inicializa los índices de búsqueda
+    int inicioRango = 0, finRango = contactos.size() - 1;
+
+    // Mientras el rango de búsqueda no esté vacío
+    while (inicioRango <= finRango)
+    {
+        // Calcula el índice del punto medio del rango de búsqueda
+        int indiceMedio = inicioRango + (finRango - inicioRango) / 2;
+
+        // Si el contacto en el punto medio tiene el nombre que buscamos
+        // Se compara con la clave guardada en el almacén (casi siempre alcanza con sus primeros 8 bytes)
+        int comparacion = almacen.compararConClave(contactos[indiceMedio], buscada);
+        if (comparacion == 0 && !almacen.estaActivo(contactos[indiceMedio]))
+        {
+            // Es una lápida (un contacto borrado que sigue en su lugar): se busca uno activo entre los que
+            // tienen el mismo nombre, que están todos juntos a su alrededor
+            int cantidad = static_cast<int>(contactos.size());
+            for (int paso : {-1, 1})
+            {
+                for (int vecino = indiceMedio + paso;
+                     vecino >= 0 && vecino < cantidad && almacen.compararConClave(contactos[vecino], buscada) == 0;
+                     vecino += paso)
+                {
+                    if (almacen.estaActivo(contactos[vecino]))
+                    {
+                        index = vecino;
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+        if (comparacion == 0)
+        {
+            // Guarda el índice donde se encuentra el contacto
+            index = indiceMedio;
+            // Retorna que se encontró el contacto
+            return true;
+        }
+        // Si el nombre que buscamos es mayor que el nombre del contacto en el medio, busca en la mitad derecha
+        else if (comparacion < 0)
+        {
+            // Actualiza el límite izquierdo para buscar en la mitad derecha
+            inicioRango = indiceMedio + 1;
+        }
+        // Si el nombre que buscamos es menor, busca en la mitad izquierda
+        else
+        {
+            // Actualiza el límite derecho para buscar en la mitad izquierda
+            finRango = indiceMedio - 1;
+        }
+    }
+    // Si no se encuentra el contacto, retorna false
+    return false;
+}
+
+// Método para descartar las lápidas de una partición y liberar sus registros en el almacén
+void ParticionesContactos::compactar(AlmacenContactos &almacen, size_t particion)
+{
+    Particion &actual = particiones[particion];
+    auto fin = remove_if(actual.contactos.begin(), actual.contactos.end(), [&](uint32_t contacto)
+                         {
+                             if (almacen.estaActivo(contacto))
+                             {
+                                 return false;
+                             }
+                             almacen.liberar(contacto);
+                             return true;
+                         });
+    actual.contactos.erase(fin, actual.contactos.end());
+    actual.borrados = 0;
+}
+
+// Método para dividir una partición demasiado grande en partes de alrededor de 'tamanoObjetivo' contactos
+void ParticionesContactos::dividir(AlmacenContactos &almacen, size_t particion)
+{
+    // Las lápidas se descartan antes, así las partes quedan parejas en contactos activos
+    compactar(almacen, particion);
+    vector<uint32_t> grupo = move(particiones[particion].contactos);
+    size_t cantidad = grupo.size();
+    size_t partes = (cantidad + tamanoObjetivo - 1) / tamanoObjetivo;
+    CompararContactosPorNombre comparar{&almacen};
+
+    // Los cortes se toman en los cuantiles del grupo (que ya está ordenado)
+    vector<Particion> nuevas(1);
+    nuevas[0].limiteInferior = move(particiones[particion].limiteInferior);
+    nuevas[0].claveLimite = move(particiones[particion].claveLimite);
+    size_t inicio = 0;
+    for (size_t parte = 1; parte < partes; ++parte)
+    {
+        size_t corte = cantidad * parte / partes;
+        if (corte <= inicio)
+        {
+            continue;
+        }
+        // El corte se corre al primero de los nombres iguales al del corte, para no separarlos
+        uint32_t contactoCorte = grupo[corte];
+        corte = static_cast<size_t>(lower_bound(grupo.begin() + inicio, grupo.begin() + corte, contactoCorte, comparar) -
+                                    grupo.begin());
+        if (corte == inicio)
+        {
+            // Desde el inicio son todos iguales: el corte pasa después del último de ellos
+            corte = static_cast<size_t>(upper_bound(grupo.begin() + corte, grupo.end(), contactoCorte, comparar) -
+                                        grupo.begin());
+            if (corte == cantidad)
+            {
+                break;
+            }
+        }
+        nuevas.back().contactos.assign(grupo.begin() + inicio, grupo.begin() + corte);
+        nuevas.emplace_back();
+        nuevas.back().limiteInferior = string(almacen.getNombre(grupo[corte]));
+        nuevas.back().claveLimite = string(almacen.getClave(grupo[corte]));
+        inicio = corte;
+    }
+    nuevas.back().contactos.assign(grupo.begin() + inicio, grupo.end());
+
+    particiones[particion] = move(nuevas[0]);
+    particiones.insert(particiones.begin() + static_cast<ptrdiff_t>(particion) + 1, make_move_iterator(nuevas.begin() + 1),
+                       make_move_iterator(nuevas.end()));
+}
+
+// Método para unir una partición demasiado chica con su vecina más chica
+void ParticionesContactos::unirConVecina(AlmacenContactos &almacen, size_t particion)
+{
+    // Se une la de la izquierda con la de la derecha: el rango unido conserva el límite de la izquierda
+    size_t izquierda = particion;
+    if (particion + 1 == particiones.size() ||
+        (particion > 0 && particiones[particion - 1].getActivos() < particiones[particion + 1].getActivos()))
+    {
+        izquierda = particion - 1;
+    }
+    Particion &destino = particiones[izquierda];
+    Particion &origen = particiones[izquierda + 1];
+    destino.contactos.insert(destino.contactos.end(), origen.contactos.begin(), origen.contactos.end());
+    destino.borrados += origen.borrados;
+    particiones.erase(particiones.begin() + static_cast<ptrdiff_t>(izquierda) + 1);
+
+    // Si la vecina ya era grande, la unión se vuelve a dividir en partes parejas
+    if (particiones[izquierda].getActivos() > 2 * tamanoObjetivo)
+    {
+        dividir(almacen, izquierda);
+    }
+}
+
+// Método para incorporar muchos contactos nuevos, ya ordenados por nombre (ver 'LoteDeContactos')
+// Cada partición recibe un tramo contiguo de los nuevos y lo mezcla con los suyos; las que quedan demasiado
+// grandes se dividen al final (por ejemplo, al cargar el archivo la única partición se divide en todas las demás).
+void ParticionesContactos::incorporar(AlmacenContactos &almacen, const vector<uint32_t> &nuevos)
+{
+    CompararContactosPorNombre comparar{&almacen};
+    vector<size_t> tocadas;
+    auto actual = nuevos.begin();
+    while (actual != nuevos.end())
+    {
+        size_t particion = ubicar(almacen.getClave(*actual), almacen.getNombre(*actual));
+        auto finTramo = nuevos.end();
+        if (particion + 1 < particiones.size())
+        {
+            const Particion &siguiente = particiones[particion + 1];
+            finTramo = partition_point(actual, nuevos.end(), [&](uint32_t contacto)
+                                       { return compararClaves(almacen.getClave(contacto), almacen.getNombre(contacto),
+                                                               siguiente.claveLimite, siguiente.limiteInferior) < 0; });
+        }
+
+        // 'inplace_merge' deja los que ya estaban antes que los nuevos con el mismo nombre
+        // La mezcla recorre toda la partición, así que de paso se descartan sus lápidas
+        if (particiones[particion].borrados > 0)
+        {
+            compactar(almacen, particion);
+        }
+        vector<uint32_t> &grupo = particiones[particion].contactos;
+        size_t anteriores = grupo.size();
+        grupo.insert(grupo.end(), actual, finTramo);
+        inplace_merge(grupo.begin(), grupo.begin() + static_cast<ptrdiff_t>(anteriores), grupo.end(), comparar);
+        tocadas.push_back(particion);
+        actual = finTramo;
+    }
+
+    // Se dividen de la última a la primera, así dividir una no cambia la posición de las anteriores
+    for (auto particion = tocadas.rbegin(); particion != tocadas.rend(); ++particion)
+    {
+        if (particiones[*particion].getActivos() > 2 * tamanoObjetivo)
+        {
+            dividir(almacen, *particion);
+        }
+    }
+}
+
+// Método para calcular las estadísticas del tamaño de las particiones
+EstadisticasParticiones ParticionesContactos::calcularEstadisticas() const
+{
+    EstadisticasParticiones estadisticas;
+    estadisticas.cantidad = particiones.size();
+    estadisticas.minimo = numeric_limits<size_t>::max();
+    for (const Particion &particion : particiones)
+    {
+        estadisticas.contactos += particion.getActivos();
+        estadisticas.borrados += particion.borrados;
+        estadisticas.minimo = min(estadisticas.minimo, particion.getActivos());
+        estadisticas.maximo = max(estadisticas.maximo, particion.getActivos());
+    }
+    estadisticas.promedio = static_cast<double>(estadisticas.contactos) / static_cast<double>(estadisticas.cantidad);
+    double suma = 0.0;
+    for (const Particion &particion : particiones)
+    {
+        double diferencia = static_cast<double>(particion.getActivos()) - estadisticas.promedio;
+        suma += diferencia * diferencia;
+    }
+    estadisticas.desviacion = sqrt(suma / static_cast<double>(estadisticas.cantidad));
+    return estadisticas;
+}
+
+// Función para insertar un contacto del almacén en su partición sin reordenar toda la agenda
+bool insertarContactoOrdenado(AgendaContactos &agenda, uint32_t contacto)
+{
+    if (calcularLetraInicial(agenda.almacen.getNombre(contacto)) < 0)
+    {
+        return false;
+    }
+    agenda.particiones.insertar(agenda.almacen, contacto);
+    return true;
+}
+
+// Función para ubicar la partición y la posición de un contacto del almacén (por su nombre y su índice)
+bool ubicarEnParticion(const AgendaContactos &agenda, uint32_t contacto, size_t &particion, size_t &posicion)
+{
+    string_view nombre = agenda.almacen.getNombre(contacto);
+    particion = agenda.particiones.ubicar(agenda.almacen.getClave(contacto), nombre);
+    const vector<uint32_t> &grupo = agenda.particiones.getContactos(particion);
+    auto primero = lower_bound(grupo.begin(), grupo.end(), contacto, CompararContactosPorNombre{&agenda.almacen});
+    for (auto actual = primero; actual != grupo.end() && agenda.almacen.getNombre(*actual) == nombre; ++actual)
+    {
+        if (*actual == contacto)
+        {
+            posicion = static_cast<size_t>(actual - grupo.begin());
+            return true;
+        }
+    }
+    return false;
+}
+
+// Reservas de memoria contadas por los programas que enlazan Conteo_Memoria.cpp (ver 'reservasMemoria')
+atomic<uint64_t> reservasMemoria{0};
+
+#ifdef AGENDA_ESTADISTICAS
+// Contadores de toda la agenda (ver 'EstadisticasAgenda')
+EstadisticasAgenda estadisticasAgenda;
+
+// Método para obtener el mayor valor que cae en una casilla (la inversa de 'calcularCasilla')
+uint64_t HistogramaLatencias::calcularLimiteSuperior(int casilla)
+{
+    if (casilla < SUBRANGOS)
+    {
+        return static_cast<uint64_t>(casilla);
+    }
+    int corrimiento = casilla / SUBRANGOS - 1;
+    uint64_t inicio = static_cast<uint64_t>(SUBRANGOS + casilla % SUBRANGOS) << corrimiento;
+    return inicio + ((1ULL << corrimiento) - 1);
+}
+
+// Método para calcular un percentil (0-100) recorriendo las casillas hasta juntar esa parte de los valores
+uint64_t HistogramaLatencias::calcularPercentil(double percentil) const
+{
+    // Se cuentan las casillas (y no 'cantidad') para que el total coincida con lo que se recorre aunque
+    // otro hilo esté registrando a la vez
+    uint64_t total = 0;
+    for (const atomic<uint64_t> &casilla : casillas)
+    {
+        total += casilla.load(memory_order_relaxed);
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+    uint64_t objetivo = max<uint64_t>(1, static_cast<uint64_t>(ceil(percentil / 100.0 * static_cast<double>(total))));
+    uint64_t acumulado = 0;
+    for (int casilla = 0; casilla < CASILLAS; ++casilla)
+    {
+        acumulado += casillas[casilla].load(memory_order_relaxed);
+        if (acumulado >= objetivo)
+        {
+            return min(calcularLimiteSuperior(casilla), getMaximo());
+        }
+    }
+    return getMaximo();
+}
+#endif
+
+// Función para registrar un contacto nuevo en la agenda (almacén, partición por nombre e índice por número)
+uint32_t registrarContacto(AgendaContactos &agenda, string_view nombre, string_view apellido,
+                           string_view numeroDeCelular, string_view email)
+{
+    if (calcularLetraInicial(nombre) < 0)
+    {
+        return numeric_limits<uint32_t>::max();
+    }
+    uint32_t contacto = agenda.almacen.agregar(nombre, apellido, numeroDeCelular, email);
+    insertarContactoOrdenado(agenda, contacto);
+    agenda.indiceTelefonos.agregar(agenda.almacen.getNumeroEmpaquetado(contacto), contacto);
+    agenda.indicesGrupos.agregar(agenda.almacen, contacto);
+    if (agenda.diario != nullptr)
+    {
+        agenda.diario->registrarAlta(agenda.almacen, contacto);
+    }
+    return contacto;
+}
+
+// Función para aplicar los cambios de un contacto (ver 'actualizarContacto')
+// Si cambia el nombre lo saca de su partición; si 'reinsertar' es verdadero lo vuelve a insertar enseguida y,
+// si no, lo agrega a 'reubicados' para que lo inserte quien llama. Retorna 'false' si no cambió nada.
+bool aplicarCambios(AgendaContactos &agenda, uint32_t contacto, const CambiosContacto &cambios, bool reinsertar,
+                    vector<uint32_t> &reubicados)
+{
+    AlmacenContactos &almacen = agenda.almacen;
+    bool cambiaNombre = cambios.nombre && *cambios.nombre != almacen.getNombre(contacto);
+    bool cambiaApellido = cambios.apellido && *cambios.apellido != almacen.getApellido(contacto);
+    bool cambiaEmail = cambios.email && *cambios.email != almacen.getEmail(contacto);
+    bool cambiaNumero = cambios.numero && *cambios.numero != almacen.getNumeroEmpaquetado(contacto);
+    if (!cambiaNombre && !cambiaApellido && !cambiaEmail && !cambiaNumero)
+    {
+        return false;
+    }
+
+    // El diario identifica al contacto por sus datos anteriores (se copian antes de reemplazarlos)
+    string nombreAnterior, apellidoAnterior, emailAnterior;
+    if (agenda.diario != nullptr)
+    {
+        nombreAnterior = almacen.getNombre(contacto);
+        apellidoAnterior = almacen.getApellido(contacto);
+        emailAnterior = almacen.getEmail(contacto);
+    }
+    uint64_t numeroAnterior = almacen.getNumeroEmpaquetado(contacto);
+
+    // Si cambia el nombre, se ubica en su partición mientras todavía se lo puede encontrar por el nombre anterior
+    size_t particion, posicion;
+    bool enParticion = cambiaNombre && ubicarEnParticion(agenda, contacto, particion, posicion);
+
+    // Los índices por apellido y por dominio se actualizan antes de reemplazar los textos (que pueden ser los
+    // anteriores, del mismo almacén)
+    if (cambiaApellido)
+    {
+        agenda.indicesGrupos.cambiarApellido(contacto, almacen.getApellido(contacto), *cambios.apellido);
+    }
+    if (cambiaEmail)
+    {
+        agenda.indicesGrupos.cambiarEmail(contacto, almacen.getEmail(contacto), *cambios.email);
+    }
+    if (cambiaNombre || cambiaApellido || cambiaEmail)
+    {
+        almacen.reemplazarTextos(contacto, cambiaNombre ? *cambios.nombre : almacen.getNombre(contacto),
+                                 cambiaApellido ? *cambios.apellido : almacen.getApellido(contacto),
+                                 cambiaEmail ? *cambios.email : almacen.getEmail(contacto));
+    }
+    if (cambiaNumero)
+    {
+        agenda.indiceTelefonos.quitar(numeroAnterior, contacto);
+        almacen.cambiarNumero(contacto, *cambios.numero);
+        agenda.indiceTelefonos.agregar(*cambios.numero, contacto);
+    }
+    if (cambiaNombre)
+    {
+        // Se saca por su posición (no deja una lápida, porque el mismo registro vuelve a insertarse con el nombre nuevo)
+        if (enParticion)
+        {
+            agenda.particiones.extraer(almacen, particion, posicion);
+        }
+        if (reinsertar)
+        {
+            agenda.particiones.insertar(almacen, contacto);
+        }
+        else if (enParticion)
+        {
+            reubicados.push_back(contacto);
+        }
+    }
+    if (agenda.diario != nullptr)
+    {
+        agenda.diario->registrarEdicion(nombreAnterior, apellidoAnterior, numeroAnterior, emailAnterior, almacen, contacto);
+    }
+    return true;
+}
+
+// Función para actualizar los campos de un contacto registrado que realmente cambian
+bool actualizarContacto(AgendaContactos &agenda, uint32_t contacto, const CambiosContacto &cambios)
+{
+    vector<uint32_t> reubicados; // No se usa: el contacto se reinserta enseguida
+    return aplicarCambios(agenda, contacto, cambios, true, reubicados);
+}
+
+// Función para actualizar muchos contactos de una sola vez
+size_t actualizarContactos(AgendaContactos &agenda, const vector<pair<uint32_t, CambiosContacto>> &cambios)
+{
+    vector<uint32_t> reubicados;
+    size_t cambiados = 0;
+    for (const pair<uint32_t, CambiosContacto> &cambio : cambios)
+    {
+        cambiados += aplicarCambios(agenda, cambio.first, cambio.second, false, reubicados);
+    }
+
+    // Los que cambiaron de nombre se ordenan (respetando el orden en que llegaron los repetidos) y se mezclan
+    // con las particiones de una pasada
+    stable_sort(reubicados.begin(), reubicados.end(), CompararContactosPorNombre{&agenda.almacen});
+    agenda.particiones.incorporar(agenda.almacen, reubicados);
+    return cambiados;
+}
+
+// Función para cambiar el dominio de los emails de toda la agenda
+size_t cambiarDominioEmails(AgendaContactos &agenda, string_view dominioViejo, string_view dominioNuevo)
+{
+    AlmacenContactos &almacen = agenda.almacen;
+    CambiosContacto cambios;
+    string emailNuevo;
+    vector<uint32_t> reubicados; // No se usa: el nombre no cambia
+    size_t cambiados = 0;
+    for (uint32_t contacto = 0; contacto < almacen.getTotalRegistros(); ++contacto)
+    {
+        if (!almacen.estaActivo(contacto))
+        {
+            continue;
+        }
+        string_view email = almacen.getEmail(contacto);
+        size_t arroba = email.rfind('@');
+        if (arroba == string_view::npos || email.substr(arroba + 1) != dominioViejo)
+        {
+            continue;
+        }
+        // El email nuevo se arma en el mismo texto en cada vuelta, así no se pide memoria por contacto
+        emailNuevo.assign(email.substr(0, arroba + 1));
+        emailNuevo.append(dominioNuevo);
+        cambios.email = emailNuevo;
+        cambiados += aplicarCambios(agenda, contacto, cambios, true, reubicados);
+    }
+    return cambiados;
+}
+
+// Función para reemplazar todos los datos de un contacto registrado
+void modificarContacto(AgendaContactos &agenda, uint32_t contacto, string_view nombre, string_view apellido,
+                       string_view numeroDeCelular, string_view email)
+{
+    CambiosContacto cambios;
+    cambios.nombre = nombre;
+    cambios.apellido = apellido;
+    cambios.numero = empaquetarNumeroCelular(numeroDeCelular);
+    cambios.email = email;
+    actualizarContacto(agenda, contacto, cambios);
+}
+
+// Función para borrar el contacto que está en la posición 'posicion' de la partición 'particion'
+void borrarContacto(AgendaContactos &agenda, size_t particion, size_t posicion)
+{
+    uint32_t contacto = agenda.particiones.getContactos(particion)[posicion];
+    agenda.indiceTelefonos.quitar(agenda.almacen.getNumeroEmpaquetado(contacto), contacto);
+    agenda.indicesGrupos.quitar(agenda.almacen, contacto);
+    if (agenda.diario != nullptr)
+    {
+        agenda.diario->registrarBaja(agenda.almacen, contacto);
+    }
+
+    // Queda como lápida en su lugar, así la partición sigue ordenada para la búsqueda binaria sin correr los
+    // siguientes; su registro se libera cuando se compacta la partición (ver 'ParticionesContactos::quitar')
+    agenda.particiones.quitar(agenda.almacen, particion, posicion);
+}
+
+// Función para localizar un contacto por su nombre exacto y su número de celular
+bool localizarContacto(const AgendaContactos &agenda, string_view nombre, uint64_t numero, size_t &particion, size_t &posicion)
+{
+    if (calcularLetraInicial(nombre) < 0)
+    {
+        return false;
+    }
+    ClaveOrden buscada(nombre);
+    particion = agenda.particiones.ubicar(buscada);
+    const vector<uint32_t> &grupo = agenda.particiones.getContactos(particion);
+    auto primero = lower_bound(grupo.begin(), grupo.end(), buscada, [&](uint32_t contacto, const ClaveOrden &clave)
+                               { return agenda.almacen.compararConClave(contacto, clave) < 0; });
+    for (auto actual = primero; actual != grupo.end() && agenda.almacen.getNombre(*actual) == nombre; ++actual)
+    {
+        if (agenda.almacen.getNumeroEmpaquetado(*actual) == numero)
+        {
+            posicion = static_cast<size_t>(actual - grupo.begin());
+            return true;
+        }
+    }
+    return false;
+}
+
+// Función para localizar un contacto por su número de celular (búsqueda inversa)
+bool localizarPorNumero(const AgendaContactos &agenda, uint64_t numero, uint32_t &contacto)
+{
+    return agenda.indiceTelefonos.buscar(agenda.almacen, numero, contacto);
+}
+
+// Método para agregar un contacto al final de la parte comprimida (debe ser mayor que el último)
+void ListaContactos::anexarComprimido(uint32_t contacto)
+{
+    if (cantidadComprimidos >= numeric_limits<uint32_t>::max() - 1)
+    {
+        throw runtime_error("Se alcanzó el máximo de contactos de una lista del índice.");
+    }
+    uint32_t diferencia = contacto - (cantidadComprimidos == 0 ? 0 : ultimoComprimido);
+    do
+    {
+        uint8_t byte = diferencia & 0x7F;
+        diferencia >>= 7;
+        comprimidos.push_back(diferencia != 0 ? (byte | 0x80) : byte);
+    } while (diferencia != 0);
+    // El primero no necesita un punto de salto (el cursor comienza ahí), así una lista corta no tiene ninguno
+    if (cantidadComprimidos > 0 && cantidadComprimidos % SALTO_LISTA == 0)
+    {
+        saltos.push_back(SaltoLista{contacto, static_cast<uint32_t>(comprimidos.size())});
+    }
+    cantidadComprimidos++;
+    ultimoComprimido = contacto;
+}
+
+// Método para volver a comprimir la lista completa cuando los cambios anotados aparte son muchos
+void ListaContactos::recomprimirSiHaceFalta()
+{
+    if (agregados.size() + quitados.size() <= 16 + cantidadComprimidos / 8)
+    {
+        return;
+    }
+    vector<uint32_t> contactos;
+    contactos.reserve(getCantidad());
+    for (CursorLista cursor(*this); !cursor.haTerminado(); cursor.avanzar())
+    {
+        contactos.push_back(cursor.getContacto());
+    }
+    comprimidos.clear();
+    saltos.clear();
+    agregados.clear();
+    quitados.clear();
+    cantidadComprimidos = 0;
+    for (uint32_t contacto : contactos)
+    {
+        anexarComprimido(contacto);
+    }
+}
+
+// Método para agregar un contacto a la lista
+void ListaContactos::agregar(uint32_t contacto)
+{
+    // Si estaba comprimido y se había quitado, basta con olvidar que se quitó
+    auto quitado = lower_bound(quitados.begin(), quitados.end(), contacto);
+    if (quitado != quitados.end() && *quitado == contacto)
+    {
+        quitados.erase(quitado);
+        return;
+    }
+    // Los agregados siempre son menores que el último comprimido, así que uno mayor va al final
+    if (cantidadComprimidos == 0 || contacto > ultimoComprimido)
+    {
+        anexarComprimido(contacto);
+        return;
+    }
+    agregados.insert(upper_bound(agregados.begin(), agregados.end(), contacto), contacto);
+    recomprimirSiHaceFalta();
+}
+
+// Método para quitar un contacto de la lista
+void ListaContactos::quitar(uint32_t contacto)
+{
+    auto agregado = lower_bound(agregados.begin(), agregados.end(), contacto);
+    if (agregado != agregados.end() && *agregado == contacto)
+    {
+        agregados.erase(agregado);
+        return;
+    }
+    quitados.insert(lower_bound(quitados.begin(), quitados.end(), contacto), contacto);
+    recomprimirSiHaceFalta();
+}
+
+// Método para quitar un contacto de la lista de una clave (la lista se descarta si queda vacía)
+void IndiceInvertido::quitar(const string &clave, uint32_t contacto)
+{
+    auto lista = listas.find(clave);
+    if (lista == listas.end())
+    {
+        return;
+    }
+    lista->second.quitar(contacto);
+    if (lista->second.getCantidad() == 0)
+    {
+        listas.erase(lista);
+    }
+}
+
+// Método para calcular la memoria que ocupan las listas y sus claves (en bytes, aproximada)
+size_t IndiceInvertido::getBytesOcupados() const
+{
+    size_t bytes = listas.bucket_count() * sizeof(void *);
+    for (const auto &lista : listas)
+    {
+        bytes += sizeof(lista) + lista.first.capacity() + lista.second.getBytesOcupados();
+    }
+    return bytes;
+}
+
+// Método para construir los índices con todos los contactos activos
+void IndicesGrupos::construir(const AlmacenContactos &almacen)
+{
+    if (construidos)
+    {
+        return;
+    }
+    construidos = true;
+    for (uint32_t contacto = 0; contacto < almacen.getTotalRegistros(); ++contacto)
+    {
+        if (almacen.estaActivo(contacto))
+        {
+            agregar(almacen, contacto);
+        }
+    }
+}
+
+// Método para agregar un contacto nuevo a los índices
+void IndicesGrupos::agregar(const AlmacenContactos &almacen, uint32_t contacto)
+{
+    if (!construidos)
+    {
+        return;
+    }
+    string clave = calcularClaveApellido(almacen.getApellido(contacto));
+    if (!clave.empty())
+    {
+        apellidos.agregar(clave, contacto);
+    }
+    clave = calcularClaveDominio(almacen.getEmail(contacto));
+    if (!clave.empty())
+    {
+        dominios.agregar(clave, contacto);
+    }
+}
+
+// Método para quitar de los índices un contacto que se borra
+void IndicesGrupos::quitar(const AlmacenContactos &almacen, uint32_t contacto)
+{
+    if (!construidos)
+    {
+        return;
+    }
+    string clave = calcularClaveApellido(almacen.getApellido(contacto));
+    if (!clave.empty())
+    {
+        apellidos.quitar(clave, contacto);
+    }
+    clave = calcularClaveDominio(almacen.getEmail(contacto));
+    if (!clave.empty())
+    {
+        dominios.quitar(clave, contacto);
+    }
+}
+
+// Método para pasar un contacto de la lista de su apellido anterior a la del nuevo
+void IndicesGrupos::cambiarApellido(uint32_t contacto, string_view anterior, string_view nuevo)
+{
+    if (!construidos)
+    {
+        return;
+    }
+    string claveAnterior = calcularClaveApellido(anterior), claveNueva = calcularClaveApellido(nuevo);
+    if (claveAnterior == claveNueva)
+    {
+        return;
+    }
+    if (!claveAnterior.empty())
+    {
+        apellidos.quitar(claveAnterior, contacto);
+    }
+    if (!claveNueva.empty())
+    {
+        apellidos.agregar(claveNueva, contacto);
+    }
+}
+
+// Método para pasar un contacto de la lista del dominio de su email anterior a la del nuevo
+void IndicesGrupos::cambiarEmail(uint32_t contacto, string_view anterior, string_view nuevo)
+{
+    if (!construidos)
+    {
+        return;
+    }
+    string claveAnterior = calcularClaveDominio(anterior), claveNueva = calcularClaveDominio(nuevo);
+    if (claveAnterior == claveNueva)
+    {
+        return;
+    }
+    if (!claveAnterior.empty())
+    {
+        dominios.quitar(claveAnterior, contacto);
+    }
+    if (!claveNueva.empty())
+    {
+        dominios.agregar(claveNueva, contacto);
+    }
+}
+
+// Función para calcular la distancia de edición entre dos claves de orden, comparando byte a byte
+// (programación dinámica clásica; la usan 'distanciaLevenshtein' y los patrones de más de 64 caracteres)
+int calcularDistanciaClaves(string_view a, string_view b)
+{
+    vector<int> filaAnterior(b.size() + 1), filaActual(b.size() + 1);
+    for (size_t j = 0; j <= b.size(); ++j)
+    {
+        filaAnterior[j] = static_cast<int>(j);
+    }
+    for (size_t i = 1; i <= a.size(); ++i)
+    {
+        filaActual[0] = static_cast<int>(i);
+        for (size_t j = 1; j <= b.size(); ++j)
+        {
+            int costoCambio = (a[i - 1] == b[j - 1]) ? 0 : 1;
+            filaActual[j] = min({filaAnterior[j] + 1, filaActual[j - 1] + 1, filaAnterior[j - 1] + costoCambio});
+        }
+        filaAnterior.swap(filaActual);
+    }
+    return filaAnterior[b.size()];
+}
+
+// Función de referencia para la distancia de edición (Levenshtein) entre dos nombres
+int distanciaLevenshtein(string_view a, string_view b)
+{
+    return calcularDistanciaClaves(calcularClaveOrden(a), calcularClaveOrden(b));
+}
+
+// Función para buscar los contactos cuyo nombre está a lo sumo a 'distanciaMaxima' ediciones de la consulta
+vector<ResultadoAproximado> buscarAproximado(const AgendaContactos &agenda, string_view consulta, int distanciaMaxima,
+                                             size_t cantidadMaxima)
+{
+    vector<ResultadoAproximado> resultados;
+    if (consulta.empty() || cantidadMaxima == 0 || distanciaMaxima < 0)
+    {
+        return resultados;
+    }
+
+    const AlmacenContactos &almacen = agenda.almacen;
+    const ParticionesContactos &particiones = agenda.particiones;
+    string claveConsulta = calcularClaveOrden(consulta);
+    const size_t columnas = claveConsulta.size() + 1;
+
+    // Función lambda para ordenar resultados: primero el más cercano y, a igual distancia, por nombre
+    auto mejorQue = [&](const ResultadoAproximado &a, const ResultadoAproximado &b)
+    {
+        if (a.distancia != b.distancia)
+        {
+            return a.distancia < b.distancia;
+        }
+        return almacen.compararContactos(a.contacto, b.contacto) < 0;
+    };
+
+    // Tabla de la distancia de edición: la fila 'd' tiene la distancia entre los primeros 'd' caracteres de la
+    // clave recorrida y cada comienzo de la consulta, y 'minimos[d]' el menor valor de esa fila. Las filas
+    // sirven para todas las claves que comienzan igual, así que solo se calculan las que siguen al comienzo
+    // común con la clave anterior.
+    vector<int> filas(columnas);
+    vector<int> minimos(1, 0);
+    for (size_t j = 0; j < columnas; ++j)
+    {
+        filas[j] = static_cast<int>(j);
+    }
+    string claveAnterior;
+    size_t filasCalculadas = 0; // Filas de 'claveAnterior' que están en la tabla (además de la 0)
+
+    // Los mejores resultados se guardan en un montículo cuyo tope es el peor de ellos
+    int limite = distanciaMaxima;
+    size_t particion = 0, posicion = 0;
+    while (particion < particiones.getCantidad())
+    {
+        const vector<uint32_t> &contactos = particiones.getContactos(particion);
+        if (posicion >= contactos.size())
+        {
+            particion++;
+            posicion = 0;
+            continue;
+        }
+        // Los contactos de las particiones están salteados en el almacén: se evita leer además el depósito
+        uint32_t contacto = contactos[posicion];
+        char corta[8];
+        string_view clave = almacen.getClaveCorta(contacto, corta);
+
+        size_t comun = 0, maximoComun = min(filasCalculadas, clave.size());
+        while (comun < maximoComun && clave[comun] == claveAnterior[comun])
+        {
+            comun++;
+        }
+        if (filas.size() < (clave.size() + 1) * columnas)
+        {
+            filas.resize((clave.size() + 1) * columnas);
+            minimos.resize(clave.size() + 1);
+        }
+
+        // El menor valor de una fila nunca baja en las siguientes: cuando pasa el límite, ningún nombre que
+        // comience con esos caracteres puede estar cerca (la poda es la cantidad de caracteres de ese comienzo)
+        size_t poda = minimos[comun] > limite ? comun : 0;
+        for (size_t d = comun + 1; poda == 0 && d <= clave.size(); ++d)
+        {
+            const int *anterior = &filas[(d - 1) * columnas];
+            int *actual = &filas[d * columnas];
+            actual[0] = static_cast<int>(d);
+            int minimo = actual[0];
+            for (size_t j = 1; j < columnas; ++j)
+            {
+                int costoCambio = clave[d - 1] == claveConsulta[j - 1] ? 0 : 1;
+                actual[j] = min({anterior[j] + 1, actual[j - 1] + 1, anterior[j - 1] + costoCambio});
+                minimo = min(minimo, actual[j]);
+            }
+            minimos[d] = minimo;
+            if (minimo > limite)
+            {
+                poda = d;
+            }
+        }
+        claveAnterior.assign(clave);
+        filasCalculadas = poda > 0 ? poda : clave.size();
+
+        if (poda > 0)
+        {
+            // Se saltan todos los contactos cuya clave comienza como esta (pueden seguir en las particiones
+            // siguientes). Casi siempre son pocos, así que se avanza con pasos que se duplican y la búsqueda
+            // binaria queda para el último tramo; el prefijo se compara con los 8 bytes del registro cuando
+            // le alcanzan
+            string_view prefijo = clave.substr(0, poda);
+            auto comienzaIgual = [&](uint32_t otro) { return almacen.compararConPrefijoClave(otro, prefijo) <= 0; };
+            while (particion < particiones.getCantidad())
+            {
+                const vector<uint32_t> &grupo = particiones.getContactos(particion);
+                size_t fin = posicion, paso = 1;
+                while (fin < grupo.size() && comienzaIgual(grupo[fin]))
+                {
+                    posicion = fin + 1;
+                    fin += paso;
+                    paso *= 2;
+                }
+                fin = min(fin, grupo.size());
+                posicion = static_cast<size_t>(partition_point(grupo.begin() + static_cast<ptrdiff_t>(posicion),
+                                                               grupo.begin() + static_cast<ptrdiff_t>(fin), comienzaIgual) -
+                                               grupo.begin());
+                if (posicion < grupo.size())
+                {
+                    break;
+                }
+                particion++;
+                posicion = 0;
+            }
+            continue;
+        }
+        posicion++;
+
+        int distancia = filas[clave.size() * columnas + columnas - 1];
+        if (distancia > limite || !almacen.estaActivo(contacto))
+        {
+            continue;
+        }
+        resultados.push_back(ResultadoAproximado{contacto, distancia});
+        push_heap(resultados.begin(), resultados.end(), mejorQue);
+        if (resultados.size() > cantidadMaxima)
+        {
+            pop_heap(resultados.begin(), resultados.end(), mejorQue);
+            resultados.pop_back();
+        }
+        // Con el montículo lleno ya no sirven candidatos más lejanos que el peor resultado guardado
+        if (resultados.size() == cantidadMaxima)
+        {
+            limite = resultados.front().distancia;
+        }
+    }
+
+    sort_heap(resultados.begin(), resultados.end(), mejorQue);
+    return resultados;
+}
+
+// Función para normalizar un email antes de compararlo
+void normalizarEmail(string_view email, string &normalizado)
+{
+    normalizado.clear();
+    size_t arroba = email.rfind('@');
+    size_t finUsuario = arroba == string_view::npos ? email.size() : arroba;
+    size_t etiqueta = email.substr(0, finUsuario).find('+'); // 'npos' si no tiene etiqueta
+    for (size_t i = 0; i < email.size(); ++i)
+    {
+        if (i >= etiqueta && i < finUsuario)
+        {
+            continue;
+        }
+        normalizado.push_back(static_cast<char>(plegarLetra(email[i])));
+    }
+}
+
+// Función para calcular la distancia de edición entre dos claves de orden sabiendo que solo interesa hasta 'maximo'
+// Retorna un valor mayor que 'maximo' si la distancia lo supera
+int calcularDistanciaAcotada(string_view a, string_view b, int maximo)
+{
+    if (a == b)
+    {
+        return 0;
+    }
+    int diferencia = static_cast<int>(a.size()) - static_cast<int>(b.size());
+    if (diferencia > maximo || -diferencia > maximo)
+    {
+        return maximo + 1;
+    }
+    if (a.empty() || b.empty())
+    {
+        return static_cast<int>(max(a.size(), b.size()));
+    }
+    PatronAproximado patron(a);
+    return patron.cabeEnPalabra() ? patron.distanciaEdicionBits(b, maximo) : calcularDistanciaClaves(a, b);
+}
+
+// Función para decidir si dos contactos tienen nombres completos parecidos
+// Se comparan las claves de orden, así las mayúsculas y los acentos no cuentan como ediciones
+bool sonNombresParecidos(const AlmacenContactos &almacen, uint32_t a, uint32_t b, int distanciaMaxima)
+{
+    if (distanciaMaxima < 0)
+    {
+        return false;
+    }
+    int distanciaNombres = calcularDistanciaAcotada(almacen.getClave(a), almacen.getClave(b), distanciaMaxima);
+    if (distanciaNombres > distanciaMaxima)
+    {
+        return false;
+    }
+    int restante = distanciaMaxima - distanciaNombres;
+    return calcularDistanciaAcotada(calcularClaveOrden(almacen.getApellido(a)), calcularClaveOrden(almacen.getApellido(b)),
+                                    restante) <= restante;
+}
+
+// Índices (0 a 2) de los criterios de 'CriterioDuplicado': el criterio i es el bit 1 << i
+constexpr int CRITERIO_NUMERO = 0;
+constexpr int CRITERIO_EMAIL = 1;
+constexpr int CRITERIO_NOMBRE = 2;
+
+// Cantidad de contactos con la misma clave hasta la que se comparan todos los pares; con más, cada contacto se
+// compara con a lo sumo 'MAXIMO_REPRESENTANTES' (así miles de contactos con un mismo número no cuestan millones
+// de comparaciones)
+constexpr size_t MAXIMO_TRAMO_COMPLETO = 32;
+constexpr size_t MAXIMO_REPRESENTANTES = 8;
+
+// Clave de un contacto para la detección de duplicados: el valor de dispersión de lo que se compara, con el
+// índice del criterio en los 2 bits más bajos (así las claves de distintos criterios nunca coinciden)
+struct ClaveDuplicado
+{
+    uint64_t clave;
+    uint32_t contacto;
+};
+
+// Función para mezclar los bits de un valor de dispersión (mezcla de splitmix64)
+inline uint64_t mezclarBits(uint64_t valor)
+{
+    valor ^= valor >> 30;
+    valor *= 0xBF58476D1CE4E5B9ULL;
+    valor ^= valor >> 27;
+    valor *= 0x94D049BB133111EBULL;
+    valor ^= valor >> 31;
+    return valor;
+}
+
+// Clase que calcula y compara las claves de duplicado de los contactos de un almacén
+// Cada hilo usa la suya: guarda los textos normalizados en búferes que se reutilizan entre contactos.
+class ClavesDuplicado
+{
+private:
+    const AlmacenContactos &almacen;
+    string textoA, textoB;
+
+    // Método para armar en 'texto' lo que se compara del contacto según el criterio (salvo el número)
+    void armarTexto(int criterio, uint32_t contacto, string &texto) const
+    {
+        if (criterio == CRITERIO_EMAIL)
+        {
+            normalizarEmail(almacen.getEmail(contacto), texto);
+            return;
+        }
+        // Nombre completo: clave de orden del nombre y del apellido, separadas por un byte que no es un peso
+        texto.assign(almacen.getClave(contacto));
+        texto.push_back('\0');
+        texto.append(calcularClaveOrden(almacen.getApellido(contacto)));
+    }
+
+public:
+    explicit ClavesDuplicado(const AlmacenContactos &almacen) : almacen(almacen) {}
+
+    uint64_t calcular(int criterio, uint32_t contacto)
+    {
+        uint64_t valor;
+        if (criterio == CRITERIO_NUMERO)
+        {
+            valor = almacen.getNumeroEmpaquetado(contacto);
+        }
+        else
+        {
+            armarTexto(criterio, contacto, textoA);
+            valor = hash<string_view>()(textoA);
+        }
+        return (mezclarBits(valor) & ~3ULL) | static_cast<uint64_t>(criterio);
+    }
+
+    // Método para comprobar que dos contactos con la misma clave realmente coinciden (la clave es un valor de
+    // dispersión, así que dos textos distintos podrían compartirla)
+    bool coinciden(int criterio, uint32_t a, uint32_t b)
+    {
+        if (criterio == CRITERIO_NUMERO)
+        {
+            return almacen.getNumeroEmpaquetado(a) == almacen.getNumeroEmpaquetado(b);
+        }
+        armarTexto(criterio, a, textoA);
+        armarTexto(criterio, b, textoB);
+        return textoA == textoB;
+    }
+};
+
+// Función para encontrar la raíz del conjunto de un contacto en los conjuntos disjuntos de 'detectarDuplicados'
+// De paso acorta el camino a la mitad: cada contacto recorrido pasa a apuntar a su abuelo
+uint32_t encontrarRaiz(vector<atomic<uint32_t>> &padres, uint32_t contacto)
+{
+    while (true)
+    {
+        uint32_t padre = padres[contacto].load(memory_order_relaxed);
+        if (padre == contacto)
+        {
+            return contacto;
+        }
+        uint32_t abuelo = padres[padre].load(memory_order_relaxed);
+        if (abuelo != padre)
+        {
+            // Si otro hilo lo cambió antes no importa: también lo acercó a la raíz
+            padres[contacto].compare_exchange_weak(padre, abuelo, memory_order_relaxed);
+        }
+        contacto = abuelo;
+    }
+}
+
+// Función para unir los conjuntos de dos contactos: la raíz mayor pasa a apuntar a la menor
+// Si otro hilo enlazó esa raíz mientras tanto, el 'compare_exchange' falla y se vuelve a intentar
+void unirConjuntos(vector<atomic<uint32_t>> &padres, uint32_t a, uint32_t b)
+{
+    while (true)
+    {
+        a = encontrarRaiz(padres, a);
+        b = encontrarRaiz(padres, b);
+        if (a == b)
+        {
+            return;
+        }
+        if (a < b)
+        {
+            swap(a, b);
+        }
+        uint32_t esperado = a;
+        if (padres[a].compare_exchange_strong(esperado, b, memory_order_relaxed))
+        {
+            return;
+        }
+    }
+}
+
+// Función para ejecutar 'trabajo(hilo)' en 'cantidadHilos' hilos; el primero lo ejecuta el hilo que llama
+template <typename Trabajo>
+void repartirEnHilos(size_t cantidadHilos, Trabajo trabajo)
+{
+    vector<thread> hilos;
+    for (size_t i = 1; i < cantidadHilos; ++i)
+    {
+        hilos.emplace_back(trabajo, i);
+    }
+    trabajo(0);
+    for (thread &hilo : hilos)
+    {
+        hilo.join();
+    }
+}
+
+// Función para encontrar los grupos de contactos duplicados de la agenda
+GruposDuplicados detectarDuplicados(const AgendaContactos &agenda, const ConfiguracionDuplicados &configuracion)
+{
+    const AlmacenContactos &almacen = agenda.almacen;
+    const size_t total = almacen.getTotalRegistros();
+    GruposDuplicados grupos;
+    vector<int> criterios;
+    for (int criterio = CRITERIO_NUMERO; criterio <= CRITERIO_NOMBRE; ++criterio)
+    {
+        if (configuracion.criterios & (1 << criterio))
+        {
+            criterios.push_back(criterio);
+        }
+    }
+    if (total == 0 || criterios.empty())
+    {
+        return grupos;
+    }
+
+    // Se usa un hilo por núcleo, pero sin menos de 65536 contactos por hilo. Las claves se reparten en más partes
+    // que hilos, así una parte con muchas claves repetidas no deja a los demás hilos esperando al final.
+    size_t cantidadHilos = configuracion.hilos > 0 ? configuracion.hilos : thread::hardware_concurrency();
+    cantidadHilos = max<size_t>(1, min(cantidadHilos, total / 65536 + 1));
+    const size_t cantidadPartes = cantidadHilos * 8;
+    auto primerContacto = [&](size_t hilo)
+    { return static_cast<uint32_t>(total * hilo / cantidadHilos); };
+    auto calcularParte = [&](uint64_t clave)
+    { return static_cast<size_t>((clave >> 32) % cantidadPartes); };
+
+    // Conjuntos disjuntos: cada contacto apunta a otro de menor índice de su grupo, y la raíz (que apunta a sí
+    // misma) es el de menor índice. Como los enlaces siempre van hacia un índice menor, los hilos pueden unir y
+    // acortar caminos a la vez sin formar ciclos.
+    vector<atomic<uint32_t>> padres(total);
+    vector<atomic<uint8_t>> criteriosPorContacto(total); // Criterios por los que se unió cada contacto (empiezan en 0)
+
+    // Primera pasada: cada hilo cuenta cuántas claves de sus contactos van a cada parte (y prepara sus conjuntos)
+    // Segunda pasada: vuelve a calcularlas y las escribe directamente en su lugar, así no se copian dos veces
+    vector<vector<size_t>> posicionesPorHilo(cantidadHilos, vector<size_t>(cantidadPartes, 0));
+    auto recorrerClaves = [&](size_t hilo, auto usarClave)
+    {
+        ClavesDuplicado claves(almacen);
+        for (uint32_t contacto = primerContacto(hilo); contacto < primerContacto(hilo + 1); ++contacto)
+        {
+            if (almacen.estaActivo(contacto))
+            {
+                for (int criterio : criterios)
+                {
+                    usarClave(claves.calcular(criterio, contacto), contacto);
+                }
+            }
+        }
+    };
+    repartirEnHilos(cantidadHilos, [&](size_t hilo)
+                    {
+                        for (uint32_t contacto = primerContacto(hilo); contacto < primerContacto(hilo + 1); ++contacto)
+                        {
+                            padres[contacto].store(contacto, memory_order_relaxed);
+                        }
+                        vector<size_t> &cantidades = posicionesPorHilo[hilo];
+                        recorrerClaves(hilo, [&](uint64_t clave, uint32_t)
+                                       { cantidades[calcularParte(clave)]++; });
+                    });
+
+    // Cada parte ocupa un tramo de 'candidatos' y, dentro de él, cada hilo escribe a continuación del anterior
+    vector<size_t> inicioPartes(cantidadPartes + 1, 0);
+    size_t siguiente = 0;
+    for (size_t parte = 0; parte < cantidadPartes; ++parte)
+    {
+        inicioPartes[parte] = siguiente;
+        for (size_t hilo = 0; hilo < cantidadHilos; ++hilo)
+        {
+            size_t cantidad = posicionesPorHilo[hilo][parte];
+            posicionesPorHilo[hilo][parte] = siguiente;
+            siguiente += cantidad;
+        }
+    }
+    inicioPartes[cantidadPartes] = siguiente;
+    vector<ClaveDuplicado> candidatos(siguiente);
+    repartirEnHilos(cantidadHilos, [&](size_t hilo)
+                    {
+                        vector<size_t> &posiciones = posicionesPorHilo[hilo];
+                        recorrerClaves(hilo, [&](uint64_t clave, uint32_t contacto)
+                                       { candidatos[posiciones[calcularParte(clave)]++] = ClaveDuplicado{clave, contacto}; });
+                    });
+
+    // Cada hilo ordena sus partes por clave y compara los contactos con la misma clave. Si son pocos se comparan
+    // todos los pares; si son muchos, cada uno se compara solo con los representantes (los primeros que no
+    // coincidieron con ninguno anterior), así el costo sigue siendo lineal aunque miles compartan una clave.
+    vector<size_t> comparacionesPorHilo(cantidadHilos, 0);
+    repartirEnHilos(cantidadHilos, [&](size_t hilo)
+                    {
+                        ClavesDuplicado claves(almacen);
+                        vector<uint32_t> comparables;
+                        size_t comparaciones = 0;
+                        for (size_t parte = hilo; parte < cantidadPartes; parte += cantidadHilos)
+                        {
+                            auto inicio = candidatos.begin() + static_cast<ptrdiff_t>(inicioPartes[parte]);
+                            auto fin = candidatos.begin() + static_cast<ptrdiff_t>(inicioPartes[parte + 1]);
+                            sort(inicio, fin, [](const ClaveDuplicado &a, const ClaveDuplicado &b)
+                                 { return a.clave != b.clave ? a.clave < b.clave : a.contacto < b.contacto; });
+                            for (auto tramo = inicio; tramo != fin;)
+                            {
+                                auto finTramo = tramo + 1;
+                                while (finTramo != fin && finTramo->clave == tramo->clave)
+                                {
+                                    ++finTramo;
+                                }
+                                int criterio = static_cast<int>(tramo->clave & 3);
+                                bool todosLosPares = finTramo - tramo <= static_cast<ptrdiff_t>(MAXIMO_TRAMO_COMPLETO);
+                                comparables.clear();
+                                for (auto actual = tramo; finTramo - tramo > 1 && actual != finTramo; ++actual)
+                                {
+                                    bool unido = false;
+                                    for (uint32_t anterior : comparables)
+                                    {
+                                        comparaciones++;
+                                        // Por nombre ya coinciden los nombres; por número o email, además deben parecerse
+                                        if (claves.coinciden(criterio, anterior, actual->contacto) &&
+                                            (criterio == CRITERIO_NOMBRE || configuracion.distanciaNombre < 0 ||
+                                             sonNombresParecidos(almacen, anterior, actual->contacto,
+                                                                 configuracion.distanciaNombre)))
+                                        {
+                                            unirConjuntos(padres, anterior, actual->contacto);
+                                            criteriosPorContacto[anterior].fetch_or(static_cast<uint8_t>(1 << criterio),
+                                                                                    memory_order_relaxed);
+                                            criteriosPorContacto[actual->contacto].fetch_or(static_cast<uint8_t>(1 << criterio),
+                                                                                            memory_order_relaxed);
+                                            unido = true;
+                                        }
+                                    }
+                                    if (todosLosPares || (!unido && comparables.size() < MAXIMO_REPRESENTANTES))
+                                    {
+                                        comparables.push_back(actual->contacto);
+                                    }
+                                }
+                                tramo = finTramo;
+                            }
+                        }
+                        comparacionesPorHilo[hilo] = comparaciones;
+                    });
+    vector<ClaveDuplicado>().swap(candidatos);
+    for (size_t comparaciones : comparacionesPorHilo)
+    {
+        grupos.comparaciones += comparaciones;
+    }
+
+    // Cada contacto pasa a apuntar directamente a su raíz (el contacto de menor índice de su grupo)
+    repartirEnHilos(cantidadHilos, [&](size_t hilo)
+                    {
+                        for (uint32_t contacto = primerContacto(hilo); contacto < primerContacto(hilo + 1); ++contacto)
+                        {
+                            padres[contacto].store(encontrarRaiz(padres, contacto), memory_order_relaxed);
+                        }
+                    });
+
+    // Se cuentan los contactos de cada raíz y las que tienen más de uno pasan a ser grupos, en orden de índice;
+    // después cada contacto se escribe en el lugar de su grupo (recorriéndolos en orden, quedan ordenados)
+    const uint32_t SIN_GRUPO = numeric_limits<uint32_t>::max();
+    vector<uint32_t> posicionRaiz(total, 0);
+    for (uint32_t contacto = 0; contacto < total; ++contacto)
+    {
+        posicionRaiz[padres[contacto].load(memory_order_relaxed)]++;
+    }
+    size_t enGrupos = 0;
+    for (uint32_t raiz = 0; raiz < total; ++raiz)
+    {
+        uint32_t cantidad = posicionRaiz[raiz];
+        if (cantidad < 2)
+        {
+            posicionRaiz[raiz] = SIN_GRUPO;
+            continue;
+        }
+        posicionRaiz[raiz] = static_cast<uint32_t>(enGrupos);
+        enGrupos += cantidad;
+        grupos.inicioGrupos.push_back(enGrupos);
+        grupos.criterios.push_back(0);
+    }
+    grupos.contactos.resize(enGrupos);
+    for (uint32_t contacto = 0; contacto < total; ++contacto)
+    {
+        uint32_t raiz = padres[contacto].load(memory_order_relaxed);
+        if (posicionRaiz[raiz] != SIN_GRUPO)
+        {
+            grupos.contactos[posicionRaiz[raiz]++] = contacto;
+        }
+    }
+    for (size_t grupo = 0; grupo < grupos.getCantidadGrupos(); ++grupo)
+    {
+        for (size_t i = grupos.inicioGrupos[grupo]; i < grupos.inicioGrupos[grupo + 1]; ++i)
+        {
+            grupos.criterios[grupo] |= criteriosPorContacto[grupos.contactos[i]].load(memory_order_relaxed);
+        }
+    }
+    return grupos;
+}
+
+// Función para elegir el valor más repetido de un campo entre los contactos de un grupo
+// A igual cantidad gana el que aparece primero en el grupo. Ordena los pares (valor, posición), así no compara
+// todos con todos aunque el grupo sea grande.
+template <typename Campo>
+auto elegirMasRepetido(const uint32_t *primero, const uint32_t *fin, Campo leerCampo)
+{
+    using Valor = decltype(leerCampo(*primero));
+    vector<pair<Valor, size_t>> valores;
+    for (const uint32_t *contacto = primero; contacto != fin; ++contacto)
+    {
+        valores.push_back({leerCampo(*contacto), static_cast<size_t>(contacto - primero)});
+    }
+    sort(valores.begin(), valores.end());
+    size_t mejor = 0, mejorCantidad = 0;
+    for (size_t i = 0; i < valores.size();)
+    {
+        // Cada tramo de valores iguales comienza por el de menor posición
+        size_t finTramo = i + 1;
+        while (finTramo < valores.size() && valores[finTramo].first == valores[i].first)
+        {
+            finTramo++;
+        }
+        if (finTramo - i > mejorCantidad ||
+            (finTramo - i == mejorCantidad && valores[i].second < valores[mejor].second))
+        {
+            mejor = i;
+            mejorCantidad = finTramo - i;
+        }
+        i = finTramo;
+    }
+    return valores[mejor].first;
+}
+
+// Función para decidir cómo se fusiona un grupo de duplicados según la política
+uint32_t prepararFusion(const AlmacenContactos &almacen, const GruposDuplicados &grupos, size_t grupo,
+                        PoliticaFusion politica, CambiosContacto &cambios)
+{
+    cambios = CambiosContacto();
+    const uint32_t *primero = grupos.contactos.data() + grupos.inicioGrupos[grupo];
+    const uint32_t *fin = grupos.contactos.data() + grupos.inicioGrupos[grupo + 1];
+    if (politica == FUSION_ULTIMO)
+    {
+        return *(fin - 1);
+    }
+    if (politica == FUSION_MAYORIA)
+    {
+        cambios.nombre = elegirMasRepetido(primero, fin, [&](uint32_t contacto)
+                                           { return almacen.getNombre(contacto); });
+        cambios.apellido = elegirMasRepetido(primero, fin, [&](uint32_t contacto)
+                                             { return almacen.getApellido(contacto); });
+        cambios.numero = elegirMasRepetido(primero, fin, [&](uint32_t contacto)
+                                           { return almacen.getNumeroEmpaquetado(contacto); });
+        cambios.email = elegirMasRepetido(primero, fin, [&](uint32_t contacto)
+                                          { return almacen.getEmail(contacto); });
+    }
+    return *primero;
+}
+
+// Función para fusionar los grupos de duplicados
+size_t fusionarDuplicados(AgendaContactos &agenda, const GruposDuplicados &grupos, PoliticaFusion politica)
+{
+    AlmacenContactos &almacen = agenda.almacen;
+    CambiosContacto cambios;
+    string nombre, apellido, email; // Copias de los valores elegidos: al borrar, el almacén puede mover sus textos
+    size_t borrados = 0;
+    for (size_t grupo = 0; grupo < grupos.getCantidadGrupos(); ++grupo)
+    {
+        uint32_t conservado = prepararFusion(almacen, grupos, grupo, politica, cambios);
+        if (!almacen.estaActivo(conservado))
+        {
+            continue;
+        }
+        if (politica == FUSION_MAYORIA)
+        {
+            cambios.nombre = nombre.assign(*cambios.nombre);
+            cambios.apellido = apellido.assign(*cambios.apellido);
+            cambios.email = email.assign(*cambios.email);
+        }
+
+        // Primero se borran las copias y después se actualiza el que se conserva
+        for (size_t i = grupos.inicioGrupos[grupo]; i < grupos.inicioGrupos[grupo + 1]; ++i)
+        {
+            uint32_t contacto = grupos.contactos[i];
+            size_t particion, posicion;
+            if (contacto == conservado || !almacen.estaActivo(contacto) ||
+                !ubicarEnParticion(agenda, contacto, particion, posicion))
+            {
+                continue;
+            }
+            borrarContacto(agenda, particion, posicion);
+            borrados++;
+        }
+        if (politica == FUSION_MAYORIA)
+        {
+            actualizarContacto(agenda, conservado, cambios);
+        }
+    }
+    return borrados;
+}
+
+// Función para interpretar una línea de "contactos.txt" con el formato que escribe 'contactoArchivado'
+bool interpretarLineaContacto(const char *inicio, const char *fin, CamposContacto &campos)
+{
+    // Se descarta el '\r' final de los archivos guardados en Windows
+    if (fin > inicio && fin[-1] == '\r')
+    {
+        fin--;
+    }
+
+    // Se separan las palabras de la línea (sin copiar, solo se guardan sus límites)
+    const char *palabras[64][2];
+    int cantidadPalabras = 0;
+    const char *cursor = inicio;
+    while (cursor < fin && cantidadPalabras < 64)
+    {
+        while (cursor < fin && *cursor == ' ')
+        {
+            cursor++;
+        }
+        if (cursor == fin)
+        {
+            break;
+        }
+        palabras[cantidadPalabras][0] = cursor;
+        while (cursor < fin && *cursor != ' ')
+        {
+            cursor++;
+        }
+        palabras[cantidadPalabras][1] = cursor;
+        cantidadPalabras++;
+    }
+
+    // Se necesitan al menos nombre, apellido, número y email
+    if (cantidadPalabras < 4)
+    {
+        return false;
+    }
+
+    // Función lambda para obtener el texto entre el inicio de una palabra y el final de otra
+    auto texto = [&](int primera, int ultima)
+    {
+        return string_view(palabras[primera][0], palabras[ultima][1] - palabras[primera][0]);
+    };
+    campos.nombre = texto(0, 0);
+    campos.apellido = texto(1, cantidadPalabras - 3);
+    campos.numeroDeCelular = texto(cantidadPalabras - 2, cantidadPalabras - 2);
+    campos.email = texto(cantidadPalabras - 1, cantidadPalabras - 1);
+    return true;
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+// Función para validar un número de celular con SSE2 (mismo resultado que 'validarNumeroCelular')
+// Los 10 bytes se copian a un bloque de 16 y se comprueba que todos estén entre '0' y '9' de una vez:
+// al restarles '0', los dígitos quedan entre 0 y 9 y cualquier otro byte queda (sin signo) por encima de 9.
+inline bool validarNumeroCelularVectorial(string_view numero)
+{
+    if (numero.size() != 10)
+    {
+        return false;
+    }
+    char bloque[16] = {};
+    memcpy(bloque, numero.data(), 10);
+    __m128i valores = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(bloque)), _mm_set1_epi8('0'));
+    __m128i nueve = _mm_set1_epi8(9);
+    __m128i esDigito = _mm_cmpeq_epi8(_mm_max_epu8(valores, nueve), nueve);
+    return (_mm_movemask_epi8(esDigito) & 0x3FF) == 0x3FF;
+}
+
+// Función para validar un email con SSE2/AVX2 (mismo resultado que 'validarEmail': tiene '@' y tiene '.')
+// Busca los dos símbolos en bloques de 32 o 16 bytes y termina en cuanto encontró ambos
+inline bool validarEmailVectorial(string_view email)
+{
+    const char *datos = email.data();
+    size_t tamano = email.size(), posicion = 0;
+    bool hayArroba = false, hayPunto = false;
+
+#ifdef __AVX2__
+    const __m256i arroba32 = _mm256_set1_epi8('@'), punto32 = _mm256_set1_epi8('.');
+    for (; posicion + 32 <= tamano; posicion += 32)
+    {
+        __m256i bloque = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(datos + posicion));
+        hayArroba |= _mm256_movemask_epi8(_mm256_cmpeq_epi8(bloque, arroba32)) != 0;
+        hayPunto |= _mm256_movemask_epi8(_mm256_cmpeq_epi8(bloque, punto32)) != 0;
+        if (hayArroba && hayPunto)
+        {
+            return true;
+        }
+    }
+#endif
+
+    const __m128i arroba = _mm_set1_epi8('@'), punto = _mm_set1_epi8('.');
+    while (posicion < tamano)
+    {
+        // El último bloque se completa con ceros, que no son ni '@' ni '.'
+        char copia[16] = {};
+        const char *inicio = datos + posicion;
+        if (tamano - posicion < 16)
+        {
+            memcpy(copia, inicio, tamano - posicion);
+            inicio = copia;
+        }
+        __m128i bloque = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inicio));
+        hayArroba |= _mm_movemask_epi8(_mm_cmpeq_epi8(bloque, arroba)) != 0;
+        hayPunto |= _mm_movemask_epi8(_mm_cmpeq_epi8(bloque, punto)) != 0;
+        if (hayArroba && hayPunto)
+        {
+            return true;
+        }
+        posicion += 16;
+    }
+    return false;
+}
+#else
+// Sin SSE2 se usan las validaciones de siempre
+inline bool validarNumeroCelularVectorial(string_view numero) { return validarNumeroCelular(numero); }
+inline bool validarEmailVectorial(string_view email) { return validarEmail(email); }
+#endif
+
+// Función para validar de una vez muchos contactos leídos del archivo (importación masiva)
+// El programa de mediciones comprueba que coincida con las validaciones de referencia
+void validarCamposEnLote(const CamposContacto *campos, size_t cantidad, uint64_t *fallas)
+{
+    for (size_t i = 0; i < cantidad; ++i)
+    {
+        const CamposContacto &contacto = campos[i];
+        bool valido = calcularLetraInicial(contacto.nombre) >= 0 &&
+                      validarNumeroCelularVectorial(contacto.numeroDeCelular) && validarEmailVectorial(contacto.email);
+        if (!valido)
+        {
+            fallas[i / 64] |= uint64_t(1) << (i % 64);
+        }
+    }
+}
+
+// Función para cargar los contactos guardados en "contactos.txt" al iniciar el programa
+size_t cargarContactos(AgendaContactos &agenda, const string &rutaArchivo)
+{
+    // Si el archivo todavía no existe (primera ejecución), la agenda empieza vacía
+    ifstream existeArchivo(rutaArchivo);
+    if (!existeArchivo.is_open())
+    {
+        return 0;
+    }
+    existeArchivo.close();
+
+    try
+    {
+        auto inicioCarga = chrono::steady_clock::now();
+
+        ArchivoMapeado archivo(rutaArchivo);
+        const char *datos = archivo.getDatos();
+        size_t tamano = archivo.getTamano();
+
+        // Se usa un hilo por núcleo, pero sin fragmentos menores a 1 MB (no vale la pena crear hilos para poco trabajo)
+        size_t cantidadHilos = thread::hardware_concurrency();
+        size_t maximoPorTamano = tamano / (1 << 20) + 1;
+        cantidadHilos = max<size_t>(1, min(cantidadHilos, maximoPorTamano));
+
+        // Calcula los límites de cada fragmento, moviéndolos hasta el siguiente salto de línea
+        vector<size_t> limites(cantidadHilos + 1, tamano);
+        limites[0] = 0;
+        for (size_t i = 1; i < cantidadHilos; ++i)
+        {
+            size_t posicion = max(limites[i - 1], tamano / cantidadHilos * i);
+            const char *salto = static_cast<const char *>(memchr(datos + posicion, '\n', tamano - posicion));
+            limites[i] = (salto == nullptr) ? tamano : static_cast<size_t>(salto - datos) + 1;
+        }
+
+        // Cada hilo guarda sus contactos en su propio almacén, así no necesitan sincronizarse
+        vector<AlmacenContactos> almacenesPorHilo(cantidadHilos);
+        vector<size_t> descartadosPorHilo(cantidadHilos, 0);
+
+        // Función lambda que interpreta las líneas de un fragmento
+        // Las líneas se separan en campos de a 64 y cada lote se valida de una vez con 'validarCamposEnLote'
+        auto procesarFragmento = [&](size_t hilo)
+        {
+            const char *cursor = datos + limites[hilo];
+            const char *finFragmento = datos + limites[hilo + 1];
+            CamposContacto lote[64];
+            size_t enLote = 0;
+
+            // Función lambda que agrega los contactos válidos del lote y descarta los demás
+            auto vaciarLote = [&]()
+            {
+                uint64_t fallas = 0;
+                validarCamposEnLote(lote, enLote, &fallas);
+                for (size_t i = 0; i < enLote; ++i)
+                {
+                    if (fallas & (uint64_t(1) << i))
+                    {
+                        descartadosPorHilo[hilo]++;
+                        continue;
+                    }
+                    almacenesPorHilo[hilo].agregar(lote[i].nombre, lote[i].apellido, lote[i].numeroDeCelular,
+                                                   lote[i].email);
+                }
+                enLote = 0;
+            };
+
+            while (cursor < finFragmento)
+            {
+                const char *salto = static_cast<const char *>(memchr(cursor, '\n', finFragmento - cursor));
+                const char *finLinea = (salto == nullptr) ? finFragmento : salto;
+
+                if (interpretarLineaContacto(cursor, finLinea, lote[enLote]))
+                {
+                    if (++enLote == 64)
+                    {
+                        vaciarLote();
+                    }
+                }
+                else if (finLinea > cursor && !(finLinea - cursor == 1 && *cursor == '\r'))
+                {
+                    // Las líneas vacías no cuentan como descartadas
+                    descartadosPorHilo[hilo]++;
+                }
+                cursor = finLinea + 1;
+            }
+            vaciarLote();
+        };
+
+        // El primer fragmento lo procesa el hilo principal mientras los demás trabajan
+        vector<thread> hilos;
+        for (size_t i = 1; i < cantidadHilos; ++i)
+        {
+            hilos.emplace_back(procesarFragmento, i);
+        }
+        procesarFragmento(0);
+        for (thread &hilo : hilos)
+        {
+            hilo.join();
+        }
+
+        // Une los almacenes de los hilos al de la agenda; los índices de cada hilo se desplazan por su base
+        // (cada hilo solo guardó contactos válidos, así que sus índices van de 0 a la cantidad que leyó)
+        vector<uint32_t> basePorHilo(cantidadHilos);
+        vector<size_t> leidosPorHilo(cantidadHilos);
+        size_t cargados = 0, descartados = 0;
+        for (size_t hilo = 0; hilo < cantidadHilos; ++hilo)
+        {
+            leidosPorHilo[hilo] = almacenesPorHilo[hilo].getTotalRegistros();
+            basePorHilo[hilo] = agenda.almacen.anexar(move(almacenesPorHilo[hilo]));
+            cargados += leidosPorHilo[hilo];
+            descartados += descartadosPorHilo[hilo];
+        }
+
+        // Los contactos de todos los hilos pasan a las particiones con un lote,
+        // así se ordenan una sola vez al final de la carga
+        agenda.indiceTelefonos.reservar(agenda.indiceTelefonos.getCantidad() + cargados);
+        LoteDeContactos lote(agenda);
+        lote.reservar(cargados);
+        for (size_t hilo = 0; hilo < cantidadHilos; ++hilo)
+        {
+            for (size_t contacto = 0; contacto < leidosPorHilo[hilo]; ++contacto)
+            {
+                lote.agregar(basePorHilo[hilo] + static_cast<uint32_t>(contacto));
+            }
+        }
+        lote.confirmar();
+
+        // Informa el tiempo de carga y la velocidad en contactos por segundo
+        chrono::duration<double> duracion = chrono::steady_clock::now() - inicioCarga;
+        double segundos = duracion.count();
+        cout << "Se cargaron " << cargados << " contactos en " << segundos * 1000.0 << " ms";
+        if (segundos > 0)
+        {
+            cout << " (" << static_cast<size_t>(cargados / segundos) << " contactos/s)";
+        }
+        cout << "." << endl;
+        if (descartados > 0)
+        {
+            cout << "Se descartaron " << descartados << " lineas no validas." << endl;
+        }
+        return cargados;
+    }
+    catch (const runtime_error &errorArchivo)
+    {
+        // Si ocurre un error al leer el archivo, muestra un mensaje de excepción
+        cout << "Excepción al cargar el archivo: " << errorArchivo.what() << endl;
+    }
+    return 0;
+}
+
+// Cabecera del archivo binario de la agenda ("contactos.agdb"), siempre al comienzo del archivo
+// Después de la cabecera vienen, en este orden y en little-endian:
+//   1. Tabla de grupos: 27 enteros de 64 bits; el grupo de la letra i ocupa los registros [tabla[i], tabla[i + 1])
+//   2. Registros: un RegistroInstantanea por contacto, agrupados por letra y ordenados por nombre
+//   3. Cadenas: por cada contacto, nombre, apellido y email, cada uno precedido por su longitud (16 bits)
+// En la versión 3 (formato comprimido) los registros y las cadenas se reemplazan por las secciones descritas en
+// 'CabeceraComprimida'. La suma de verificación cubre todo lo que viene después de la cabecera.
+struct CabeceraInstantanea
+{
+    char magia[4];              // "AGDB"
+    uint32_t version;           // Versión del formato
+    uint64_t cantidadRegistros; // Cantidad de contactos guardados
+    uint64_t bytesCadenas;      // Tamaño de la sección de cadenas (en la versión 3, de todas las secciones comprimidas)
+    uint64_t sumaVerificacion;  // Suma de verificación de la tabla, los registros y las cadenas
+    uint64_t secuenciaDiario;   // Última entrada del diario de cambios incluida (versión 2; en la versión 1 siempre es 0)
+};
+
+// Registro de un contacto dentro del archivo binario (16 bytes)
+struct RegistroInstantanea
+{
+    uint64_t desplazamiento;    // Posición de sus cadenas dentro de la sección de cadenas
+    uint64_t numeroEmpaquetado; // Número de celular empaquetado (10 dígitos)
+};
+
+static_assert(sizeof(CabeceraInstantanea) == 40, "La cabecera del archivo binario debe ocupar 40 bytes");
+
+static_assert(sizeof(RegistroInstantanea) == 16, "El registro del archivo binario debe ocupar 16 bytes");
+
+const char MAGIA_INSTANTANEA[4] = {'A', 'G', 'D', 'B'};
+
+const uint32_t VERSION_INSTANTANEA = 2;
+
+const uint32_t VERSION_INSTANTANEA_COMPRIMIDA = 3;
+
+// Función para acumular la suma de verificación de un bloque de bytes
+// Procesa palabras de 8 bytes (solo los últimos bytes sueltos van de uno en uno), así que cuesta mucho
+// menos que leer el archivo del disco. Se puede calcular por partes si cada parte (salvo la última)
+// tiene un tamaño múltiplo de 8.
+uint64_t acumularSumaVerificacion(uint64_t suma, const char *datos, size_t tamano)
+{
+    const uint64_t multiplicador = 0x9E3779B97F4A7C15ULL;
+    size_t i = 0;
+    for (; i + 8 <= tamano; i += 8)
+    {
+        uint64_t palabra;
+        memcpy(&palabra, datos + i, 8);
+        suma ^= palabra;
+        suma = ((suma << 29) | (suma >> 35)) * multiplicador;
+    }
+    for (; i < tamano; ++i)
+    {
+        suma ^= static_cast<unsigned char>(datos[i]);
+        suma = ((suma << 29) | (suma >> 35)) * multiplicador;
+    }
+    return suma;
+}
+
+// Clase para escribir un archivo binario por bloques grandes mientras se calcula su suma de verificación
+// Los datos se juntan en un búfer de 1 MB y se escriben de una sola vez, así el costo lo pone el disco.
+class EscritorBinario
+{
+private:
+    ofstream &archivo;
+    vector<char> bufer;
+    size_t usados;
+    uint64_t suma;
+
+    // Método para escribir en el archivo el contenido del búfer
+    void vaciar()
+    {
+        suma = acumularSumaVerificacion(suma, bufer.data(), usados);
+        archivo.write(bufer.data(), usados);
+        contarBytesEscritos(usados);
+        usados = 0;
+    }
+
+public:
+    // Constructor: escribe a continuación de lo que ya tenga el archivo
+    explicit EscritorBinario(ofstream &archivo) : archivo(archivo), bufer(1 << 20), usados(0), suma(0) {}
+
+    // Método para agregar bytes al archivo
+    void escribir(const void *datos, size_t tamano)
+    {
+        const char *origen = static_cast<const char *>(datos);
+        while (tamano > 0)
+        {
+            size_t cabe = min(tamano, bufer.size() - usados);
+            memcpy(bufer.data() + usados, origen, cabe);
+            usados += cabe;
+            origen += cabe;
+            tamano -= cabe;
+            // El búfer solo se vacía cuando está lleno (1 MB, múltiplo de 8) para que la suma no dependa de los cortes
+            if (usados == bufer.size())
+            {
+                vaciar();
+            }
+        }
+    }
+
+    // Método para escribir lo que quede en el búfer y obtener la suma de verificación de todo lo escrito
+    uint64_t terminar()
+    {
+        vaciar();
+        return suma;
+    }
+};
+
+// Función para reemplazar un archivo por otro recién escrito (renombrándolo)
+// Así nunca queda a medias el archivo original si el programa se interrumpe mientras se guarda
+void reemplazarArchivo(const string &rutaTemporal, const string &rutaFinal)
+{
+#ifdef _WIN32
+    // En Windows 'rename' no reemplaza un archivo existente
+    remove(rutaFinal.c_str());
+#endif
+    if (rename(rutaTemporal.c_str(), rutaFinal.c_str()) != 0)
+    {
+        throw runtime_error("No se pudo reemplazar el archivo " + rutaFinal + ".");
+    }
+}
+
+// FORMATO COMPRIMIDO (versión 3 del archivo binario)
+// Después de la tabla de grupos vienen, en este orden:
+//   1. CabeceraComprimida
+//   2. Índice de bloques: un entero de 64 bits por bloque con la posición del bloque dentro de la sección 5
+//   3. Diccionario de apellidos: los apellidos distintos, ordenados y codificados con prefijo común
+//   4. Diccionario de dominios: los dominios de email distintos, ordenados, cada uno precedido por su longitud
+//   5. Bloques: los contactos en orden de nombre, de a 'CONTACTOS_POR_BLOQUE'. Cada bloque comienza con sus
+//      números (ver 'anexarNumerosBloque') y sigue con cada contacto: nombre con prefijo común (el primero del
+//      bloque va completo, así se puede empezar a leer en cualquier bloque), número de apellido en el
+//      diccionario, número de dominio (0 si el email no tiene '@') y la parte del email antes del '@' (ver
+//      'anexarUsuarioEmail').
+// Las longitudes y los números de diccionario se guardan como enteros de longitud variable (7 bits por byte).
+struct CabeceraComprimida
+{
+    uint64_t cantidadApellidos;
+    uint64_t bytesApellidos;
+    uint64_t cantidadDominios;
+    uint64_t bytesDominios;
+    uint64_t bytesBloques;
+    uint64_t bytesTextos; // Lo que ocupan los textos de los contactos en el almacén (con la clave de orden)
+};
+
+static_assert(sizeof(CabeceraComprimida) == 48, "La cabecera del formato comprimido debe ocupar 48 bytes");
+
+const size_t CONTACTOS_POR_BLOQUE = 16;
+
+const unsigned BITS_NUMERO_CELULAR = 34; // Los 10 dígitos entran en 34 bits
+const unsigned BITS_POSICION_BLOQUE = 4; // Posición de un número entre los del bloque ordenados
+const unsigned char NUMEROS_SIN_DIFERENCIAS = 0xFF;
+
+static_assert(CONTACTOS_POR_BLOQUE <= (1u << BITS_POSICION_BLOQUE), "Las posiciones de los números no entran en 4 bits");
+
+// Función para calcular cuántos bytes ocupan 'cantidad' valores de 'bits' bits empaquetados uno tras otro
+inline size_t calcularBytesEmpaquetados(size_t cantidad, unsigned bits) { return (cantidad * bits + 7) / 8; }
+
+// Función para agregar un entero de longitud variable: 7 bits por byte, el bit alto indica que sigue otro
+void anexarEnteroVariable(vector<char> &destino, uint64_t valor)
+{
+    while (valor >= 0x80)
+    {
+        destino.push_back(static_cast<char>(valor | 0x80));
+        valor >>= 7;
+    }
+    destino.push_back(static_cast<char>(valor));
+}
+
+// Función para agregar 'cantidad' valores de 'bits' bits cada uno (hasta 34), empaquetados uno tras otro en
+// little-endian: el valor i empieza en el bit 'bits' * i
+void anexarBitsEmpaquetados(vector<char> &destino, const uint64_t *valores, size_t cantidad, unsigned bits)
+{
+    uint64_t acumulado = 0;
+    unsigned pendientes = 0;
+    for (size_t i = 0; i < cantidad; ++i)
+    {
+        acumulado |= valores[i] << pendientes;
+        pendientes += bits;
+        while (pendientes >= 8)
+        {
+            destino.push_back(static_cast<char>(acumulado & 0xFF));
+            acumulado >>= 8;
+            pendientes -= 8;
+        }
+    }
+    if (pendientes > 0)
+    {
+        destino.push_back(static_cast<char>(acumulado));
+    }
+}
+
+// Función para agregar los números de un bloque del formato comprimido, dados en el orden de los contactos
+// Se guardan ordenados como diferencias: un byte con los bits de cada diferencia, el número menor (entero de
+// longitud variable), la posición de cada contacto entre los números ordenados (4 bits cada una) y las
+// diferencias entre cada número ordenado y el anterior. Si así no ocupan menos (los números de un bloque
+// están muy dispersos), se guarda el byte 'NUMEROS_SIN_DIFERENCIAS' y los números de 34 bits en el orden de
+// los contactos.
+void anexarNumerosBloque(vector<char> &destino, const uint64_t *numeros, size_t cantidad)
+{
+    size_t indices[CONTACTOS_POR_BLOQUE] = {};
+    for (size_t i = 0; i < cantidad; ++i)
+    {
+        indices[i] = i;
+    }
+    stable_sort(indices, indices + cantidad, [&](size_t a, size_t b) { return numeros[a] < numeros[b]; });
+
+    uint64_t posiciones[CONTACTOS_POR_BLOQUE], diferencias[CONTACTOS_POR_BLOQUE];
+    uint64_t diferenciaMaxima = 0;
+    for (size_t i = 0; i < cantidad; ++i)
+    {
+        posiciones[indices[i]] = i;
+        if (i > 0)
+        {
+            diferencias[i - 1] = numeros[indices[i]] - numeros[indices[i - 1]];
+            diferenciaMaxima = max(diferenciaMaxima, diferencias[i - 1]);
+        }
+    }
+    unsigned bitsDiferencia = diferenciaMaxima > 0 ? calcularBitMasAlto(diferenciaMaxima) + 1 : 0;
+
+    uint64_t minimo = numeros[indices[0]];
+    size_t bytesMinimo = 1;
+    for (uint64_t resto = minimo; resto >= 0x80; resto >>= 7)
+    {
+        bytesMinimo++;
+    }
+    size_t bytesConDiferencias = bytesMinimo + calcularBytesEmpaquetados(cantidad, BITS_POSICION_BLOQUE) +
+                                 calcularBytesEmpaquetados(cantidad - 1, bitsDiferencia);
+    if (bytesConDiferencias >= calcularBytesEmpaquetados(cantidad, BITS_NUMERO_CELULAR))
+    {
+        destino.push_back(static_cast<char>(NUMEROS_SIN_DIFERENCIAS));
+        anexarBitsEmpaquetados(destino, numeros, cantidad, BITS_NUMERO_CELULAR);
+        return;
+    }
+    destino.push_back(static_cast<char>(bitsDiferencia));
+    anexarEnteroVariable(destino, minimo);
+    anexarBitsEmpaquetados(destino, posiciones, cantidad, BITS_POSICION_BLOQUE);
+    anexarBitsEmpaquetados(destino, diferencias, cantidad - 1, bitsDiferencia);
+}
+
+// Función para agregar un texto con prefijo común: cuántos bytes comparte con el anterior y el resto
+void anexarConPrefijoComun(vector<char> &destino, string_view anterior, string_view texto)
+{
+    size_t compartidos = 0;
+    size_t maximo = min(anterior.size(), texto.size());
+    while (compartidos < maximo && anterior[compartidos] == texto[compartidos])
+    {
+        compartidos++;
+    }
+    anexarEnteroVariable(destino, compartidos);
+    anexarEnteroVariable(destino, texto.size() - compartidos);
+    destino.insert(destino.end(), texto.begin() + compartidos, texto.end());
+}
+
+// Función para contar cuántos caracteres del comienzo de 'texto' repiten el comienzo de 'campo'
+// La repetición puede ser exacta o con las letras del campo en minúscula ('minusculas'); se elige la más larga
+size_t contarRepetidos(string_view texto, string_view campo, bool &minusculas)
+{
+    size_t maximo = min(texto.size(), campo.size());
+    size_t exactos = 0, plegados = 0;
+    while (exactos < maximo && texto[exactos] == campo[exactos])
+    {
+        exactos++;
+    }
+    while (plegados < maximo && static_cast<unsigned char>(texto[plegados]) == plegarLetra(campo[plegados]))
+    {
+        plegados++;
+    }
+    minusculas = plegados > exactos;
+    return max(exactos, plegados);
+}
+
+// Función para agregar la parte del email antes del '@' aprovechando que suele repetir el nombre y el apellido
+// ("juan.perez", "jperez", "Juan_P"): se guarda cuántos caracteres del nombre repite, lo que sigue hasta donde
+// comienza el apellido (a lo sumo 3 caracteres, como '.' o '_'), cuántos caracteres del apellido repite y el
+// resto. Cada repetición se guarda como 2 * caracteres + 1 si es en minúsculas.
+void anexarUsuarioEmail(vector<char> &destino, string_view usuario, string_view nombre, string_view apellido)
+{
+    bool nombreEnMinusculas;
+    size_t deNombre = contarRepetidos(usuario, nombre, nombreEnMinusculas);
+    string_view resto = usuario.substr(deNombre);
+
+    // Si no repite al menos 2 caracteres del apellido, todo el resto va como separador (y no hay apellido)
+    size_t separador = resto.size(), deApellido = 0;
+    bool apellidoEnMinusculas = false;
+    for (size_t salto = 0; salto <= min<size_t>(resto.size(), 3); ++salto)
+    {
+        bool enMinusculas;
+        size_t repetidos = contarRepetidos(resto.substr(salto), apellido, enMinusculas);
+        if (repetidos >= 2 && repetidos > deApellido)
+        {
+            separador = salto;
+            deApellido = repetidos;
+            apellidoEnMinusculas = enMinusculas;
+        }
+    }
+
+    anexarEnteroVariable(destino, deNombre * 2 + nombreEnMinusculas);
+    anexarEnteroVariable(destino, separador);
+    destino.insert(destino.end(), resto.begin(), resto.begin() + separador);
+    anexarEnteroVariable(destino, deApellido * 2 + apellidoEnMinusculas);
+    size_t despues = separador + deApellido;
+    anexarEnteroVariable(destino, resto.size() - despues);
+    destino.insert(destino.end(), resto.begin() + despues, resto.end());
+}
+
+// Función para separar un email en la parte antes del último '@' y el dominio
+// Retorna 'false' (y deja todo el email en 'usuario') si no tiene '@'
+bool separarEmail(string_view email, string_view &usuario, string_view &dominio)
+{
+    size_t arroba = email.rfind('@');
+    if (arroba == string_view::npos)
+    {
+        usuario = email;
+        dominio = string_view();
+        return false;
+    }
+    usuario = email.substr(0, arroba);
+    dominio = email.substr(arroba + 1);
+    return true;
+}
+
+// Clase para numerar los textos distintos de un diccionario en el orden en que aparecen
+// Es una tabla hash de direccionamiento abierto con sondeo lineal, como 'IndiceTelefonos': cada casilla guarda
+// una huella de 32 bits del texto y su número de aparición + 1 (0 es una casilla libre); cuando la huella
+// coincide se confirma el texto en 'textos'. Crece al doble cuando se llena a la mitad.
+class NumeradorTextos
+{
+private:
+    vector<pair<uint32_t, uint32_t>> casillas;
+    size_t mascara;
+
+public:
+    vector<string_view> textos; // En orden de aparición
+
+    NumeradorTextos() : casillas(1024), mascara(1023) {}
+
+    // Método para obtener el número de aparición de un texto (si es nuevo, se agrega al final de 'textos')
+    uint32_t numerar(string_view texto)
+    {
+        size_t dispersion = hash<string_view>()(texto);
+        uint32_t huella = static_cast<uint32_t>(dispersion ^ (dispersion >> 32));
+        size_t casilla = huella & mascara;
+        while (casillas[casilla].second != 0)
+        {
+            if (casillas[casilla].first == huella && textos[casillas[casilla].second - 1] == texto)
+            {
+                return casillas[casilla].second - 1;
+            }
+            casilla = (casilla + 1) & mascara;
+        }
+        uint32_t numero = static_cast<uint32_t>(textos.size());
+        casillas[casilla] = {huella, numero + 1};
+        textos.push_back(texto);
+
+        if (textos.size() * 2 > casillas.size())
+        {
+            vector<pair<uint32_t, uint32_t>> anteriores(casillas.size() * 2);
+            anteriores.swap(casillas);
+            mascara = casillas.size() - 1;
+            for (const pair<uint32_t, uint32_t> &ocupada : anteriores)
+            {
+                if (ocupada.second != 0)
+                {
+                    size_t nueva = ocupada.first & mascara;
+                    while (casillas[nueva].second != 0)
+                    {
+                        nueva = (nueva + 1) & mascara;
+                    }
+                    casillas[nueva] = ocupada;
+                }
+            }
+        }
+        return numero;
+    }
+};
+
+// Función para ordenar un diccionario armado en el orden de aparición de sus textos
+// Deja 'textos' ordenado y retorna, para cada número de aparición, la posición del texto en el orden.
+// Se ordena por los primeros 8 bytes de cada texto (ver 'calcularPrefijoClave') y solo los empates leen el texto.
+vector<uint32_t> ordenarDiccionario(vector<string_view> &textos)
+{
+    vector<pair<uint64_t, uint32_t>> porOrden(textos.size());
+    for (size_t i = 0; i < porOrden.size(); ++i)
+    {
+        porOrden[i] = {calcularPrefijoClave(textos[i]), static_cast<uint32_t>(i)};
+    }
+    sort(porOrden.begin(), porOrden.end(), [&](const pair<uint64_t, uint32_t> &a, const pair<uint64_t, uint32_t> &b)
+         { return a.first != b.first ? a.first < b.first : textos[a.second] < textos[b.second]; });
+
+    vector<uint32_t> posicion(textos.size());
+    vector<string_view> ordenados(textos.size());
+    for (size_t i = 0; i < porOrden.size(); ++i)
+    {
+        posicion[porOrden[i].second] = static_cast<uint32_t>(i);
+        ordenados[i] = textos[porOrden[i].second];
+    }
+    textos.swap(ordenados);
+    return posicion;
+}
+
+// Función para escribir las secciones del formato comprimido con los contactos activos de la agenda, en orden
+// de nombre (ver 'CabeceraComprimida'). Retorna cuántos bytes se escribieron.
+uint64_t escribirSeccionesComprimidas(const AgendaContactos &agenda, EscritorBinario &escritor)
+{
+    const AlmacenContactos &almacen = agenda.almacen;
+    const ParticionesContactos &particiones = agenda.particiones;
+    vector<uint32_t> orden;
+    orden.reserve(almacen.getCantidad());
+    for (size_t particion = 0; particion < particiones.getCantidad(); ++particion)
+    {
+        for (uint32_t contacto : particiones.getContactos(particion))
+        {
+            if (almacen.estaActivo(contacto))
+            {
+                orden.push_back(contacto);
+            }
+        }
+    }
+
+    // Diccionarios: los apellidos y dominios distintos se numeran en el orden en que aparecen (cada contacto
+    // guarda el número de los suyos) y después se ordenan; el número de aparición pasa a su posición en el orden
+    // Se recorre el almacén en orden de memoria, que es mucho más rápido que saltar de un contacto a otro por nombre
+    CabeceraComprimida cabecera = {};
+    NumeradorTextos numeradorApellidos, numeradorDominios;
+    vector<uint32_t> apellidoDe(almacen.getTotalRegistros()), dominioDe(almacen.getTotalRegistros()); // Dominio 0: sin '@'
+    for (uint32_t contacto = 0; contacto < almacen.getTotalRegistros(); ++contacto)
+    {
+        if (!almacen.estaActivo(contacto))
+        {
+            continue;
+        }
+        string_view apellido = almacen.getApellido(contacto), usuario, dominio;
+        apellidoDe[contacto] = numeradorApellidos.numerar(apellido);
+        if (separarEmail(almacen.getEmail(contacto), usuario, dominio))
+        {
+            dominioDe[contacto] = numeradorDominios.numerar(dominio) + 1;
+        }
+        cabecera.bytesTextos += almacen.getNombre(contacto).size() + apellido.size() + almacen.getEmail(contacto).size() +
+                                almacen.getClave(contacto).size();
+    }
+    vector<string_view> &apellidos = numeradorApellidos.textos, &dominios = numeradorDominios.textos;
+    vector<uint32_t> posicionApellido = ordenarDiccionario(apellidos);
+    vector<uint32_t> posicionDominio = ordenarDiccionario(dominios);
+
+    vector<char> seccionApellidos, seccionDominios;
+    string_view apellidoAnterior;
+    for (string_view apellido : apellidos)
+    {
+        anexarConPrefijoComun(seccionApellidos, apellidoAnterior, apellido);
+        apellidoAnterior = apellido;
+    }
+    for (string_view dominio : dominios)
+    {
+        anexarEnteroVariable(seccionDominios, dominio.size());
+        seccionDominios.insert(seccionDominios.end(), dominio.begin(), dominio.end());
+    }
+
+    // Bloques de contactos
+    vector<uint64_t> indiceBloques;
+    indiceBloques.reserve((orden.size() + CONTACTOS_POR_BLOQUE - 1) / CONTACTOS_POR_BLOQUE);
+    vector<char> bloques;
+    for (size_t inicio = 0; inicio < orden.size(); inicio += CONTACTOS_POR_BLOQUE)
+    {
+        size_t fin = min(orden.size(), inicio + CONTACTOS_POR_BLOQUE);
+        indiceBloques.push_back(bloques.size());
+
+        uint64_t numeros[CONTACTOS_POR_BLOQUE];
+        for (size_t i = inicio; i < fin; ++i)
+        {
+            numeros[i - inicio] = almacen.getNumeroEmpaquetado(orden[i]);
+        }
+        anexarNumerosBloque(bloques, numeros, fin - inicio);
+
+        string_view nombreAnterior;
+        for (size_t i = inicio; i < fin; ++i)
+        {
+            string_view nombre = almacen.getNombre(orden[i]), apellido = almacen.getApellido(orden[i]);
+            string_view usuario, dominio;
+            separarEmail(almacen.getEmail(orden[i]), usuario, dominio);
+            anexarConPrefijoComun(bloques, nombreAnterior, nombre);
+            anexarEnteroVariable(bloques, posicionApellido[apellidoDe[orden[i]]]);
+            anexarEnteroVariable(bloques, dominioDe[orden[i]] > 0 ? posicionDominio[dominioDe[orden[i]] - 1] + 1 : 0);
+            anexarUsuarioEmail(bloques, usuario, nombre, apellido);
+            nombreAnterior = nombre;
+        }
+    }
+
+    cabecera.cantidadApellidos = apellidos.size();
+    cabecera.bytesApellidos = seccionApellidos.size();
+    cabecera.cantidadDominios = dominios.size();
+    cabecera.bytesDominios = seccionDominios.size();
+    cabecera.bytesBloques = bloques.size();
+    escritor.escribir(&cabecera, sizeof(cabecera));
+    escritor.escribir(indiceBloques.data(), indiceBloques.size() * sizeof(uint64_t));
+    escritor.escribir(seccionApellidos.data(), seccionApellidos.size());
+    escritor.escribir(seccionDominios.data(), seccionDominios.size());
+    escritor.escribir(bloques.data(), bloques.size());
+    return sizeof(cabecera) + indiceBloques.size() * sizeof(uint64_t) + seccionApellidos.size() +
+           seccionDominios.size() + bloques.size();
+}
+
+// Función para guardar la agenda completa en el formato binario (ver 'CabeceraInstantanea')
+void guardarInstantanea(const AgendaContactos &agenda, const string &rutaArchivo, uint64_t secuenciaDiario, bool comprimir)
+{
+    MedicionOperacion medicion(OPERACION_INSTANTANEA);
+    const AlmacenContactos &almacen = agenda.almacen;
+    string rutaTemporal = rutaArchivo + ".tmp";
+    ofstream archivo(rutaTemporal, ios::out | ios::binary | ios::trunc);
+    if (!archivo.is_open())
+    {
+        throw runtime_error("Error al abrir el archivo " + rutaTemporal + " para guardar los contactos.");
+    }
+
+    // La cabecera se escribe al final, cuando se conoce la suma de verificación; por ahora se reserva su lugar
+    CabeceraInstantanea cabecera = {};
+    archivo.write(reinterpret_cast<const char *>(&cabecera), sizeof(cabecera));
+    contarBytesEscritos(sizeof(cabecera));
+
+    EscritorBinario escritor(archivo);
+
+    // 1. Tabla de grupos por letra inicial
+    // Las particiones recorren los nombres en orden, así que los de cada letra quedan juntos: el grupo de una
+    // letra comienza después de todos los nombres que van antes que ella (se cuentan con una búsqueda binaria)
+    // Los que comienzan con Ñ van antes que la O, así que quedan en el grupo de la N (ver 'calcularLetraInicial')
+    // Las lápidas de las particiones (contactos borrados) no se guardan ni se cuentan
+    const ParticionesContactos &particiones = agenda.particiones;
+    auto contarActivos = [&](vector<uint32_t>::const_iterator inicio, vector<uint32_t>::const_iterator fin)
+    { return static_cast<uint64_t>(count_if(inicio, fin, [&](uint32_t contacto) { return almacen.estaActivo(contacto); })); };
+    uint64_t tabla[27];
+    for (int i = 0; i < 26; ++i)
+    {
+        string letra = calcularClaveOrden(string(1, static_cast<char>('A' + i)));
+        size_t primera = particiones.ubicarPrefijo(letra);
+        tabla[i] = 0;
+        for (size_t particion = 0; particion < primera; ++particion)
+        {
+            tabla[i] += particiones.getParticion(particion).getActivos();
+        }
+        const vector<uint32_t> &grupo = particiones.getContactos(primera);
+        tabla[i] += contarActivos(
+            grupo.begin(),
+            lower_bound(grupo.begin(), grupo.end(), string_view(letra), [&](uint32_t contacto, string_view buscada)
+                        { return almacen.compararConPrefijoClave(contacto, buscada) < 0; }));
+    }
+    tabla[26] = 0;
+    for (size_t particion = 0; particion < particiones.getCantidad(); ++particion)
+    {
+        tabla[26] += particiones.getParticion(particion).getActivos();
+    }
+    escritor.escribir(tabla, sizeof(tabla));
+
+    uint64_t desplazamiento = 0;
+    if (comprimir)
+    {
+        desplazamiento = escribirSeccionesComprimidas(agenda, escritor);
+    }
+    else
+    {
+        // 2. Registros, con la posición que tendrán sus cadenas
+        for (size_t particion = 0; particion < particiones.getCantidad(); ++particion)
+        {
+            for (uint32_t contacto : particiones.getContactos(particion))
+            {
+                if (!almacen.estaActivo(contacto))
+                {
+                    continue;
+                }
+                RegistroInstantanea registro{desplazamiento, almacen.getNumeroEmpaquetado(contacto)};
+                escritor.escribir(&registro, sizeof(registro));
+                desplazamiento += 3 * sizeof(uint16_t) + almacen.getNombre(contacto).size() +
+                                  almacen.getApellido(contacto).size() + almacen.getEmail(contacto).size();
+            }
+        }
+
+        // 3. Cadenas precedidas por su longitud
+        for (size_t particion = 0; particion < particiones.getCantidad(); ++particion)
+        {
+            for (uint32_t contacto : particiones.getContactos(particion))
+            {
+                if (!almacen.estaActivo(contacto))
+                {
+                    continue;
+                }
+                for (string_view texto : {almacen.getNombre(contacto), almacen.getApellido(contacto), almacen.getEmail(contacto)})
+                {
+                    uint16_t longitud = static_cast<uint16_t>(texto.size());
+                    escritor.escribir(&longitud, sizeof(longitud));
+                    escritor.escribir(texto.data(), texto.size());
+                }
+            }
+        }
+    }
+
+    // Completa la cabecera y la escribe al comienzo del archivo
+    memcpy(cabecera.magia, MAGIA_INSTANTANEA, sizeof(cabecera.magia));
+    cabecera.version = comprimir ? VERSION_INSTANTANEA_COMPRIMIDA : VERSION_INSTANTANEA;
+    cabecera.cantidadRegistros = tabla[26];
+    cabecera.bytesCadenas = desplazamiento;
+    cabecera.sumaVerificacion = escritor.terminar();
+    cabecera.secuenciaDiario = secuenciaDiario;
+    archivo.seekp(0);
+    archivo.write(reinterpret_cast<const char *>(&cabecera), sizeof(cabecera));
+    archivo.close();
+    if (archivo.fail())
+    {
+        throw runtime_error("Error al escribir el archivo " + rutaTemporal + ".");
+    }
+
+    reemplazarArchivo(rutaTemporal, rutaArchivo);
+}
+
+// Clase para leer el archivo binario de la agenda directamente desde memoria mapeada
+// No copia los contactos: las búsquedas se hacen sobre las páginas del archivo mapeado y los
+// contactos que devuelve apuntan a ellas (son válidos mientras exista el objeto).
+class InstantaneaMapeada
+{
+private:
+    ArchivoMapeado archivo;
+    const CabeceraInstantanea *cabecera;
+    const uint64_t *tabla;
+    const RegistroInstantanea *registros;
+    const char *cadenas;
+
+    // Método para leer una cadena precedida por su longitud y avanzar el cursor
+    static string_view leerCadena(const char *&cursor)
+    {
+        uint16_t longitud;
+        memcpy(&longitud, cursor, sizeof(longitud));
+        string_view texto(cursor + sizeof(longitud), longitud);
+        cursor += sizeof(longitud) + longitud;
+        return texto;
+    }
+
+public:
+    // Constructor: mapea el archivo y comprueba la cabecera, los tamaños y (si se pide) la suma de verificación
+    // Lanza una excepción si el archivo no es válido
+    explicit InstantaneaMapeada(const string &rutaArchivo, bool verificarSuma = true) : archivo(rutaArchivo)
+    {
+        const char *datos = archivo.getDatos();
+        size_t tamano = archivo.getTamano();
+        if (tamano < sizeof(CabeceraInstantanea) + 27 * sizeof(uint64_t))
+        {
+            throw runtime_error("El archivo " + rutaArchivo + " es demasiado corto.");
+        }
+
+        cabecera = reinterpret_cast<const CabeceraInstantanea *>(datos);
+        if (memcmp(cabecera->magia, MAGIA_INSTANTANEA, sizeof(cabecera->magia)) != 0)
+        {
+            throw runtime_error("El archivo " + rutaArchivo + " no es una agenda binaria.");
+        }
+        // La versión 1 no tenía número de secuencia del diario (vale 0), el resto del formato es igual
+        if (cabecera->version != 1 && cabecera->version != VERSION_INSTANTANEA)
+        {
+            throw runtime_error("Versión no soportada del archivo " + rutaArchivo + ".");
+        }
+
+        // La tabla, los registros y las cadenas deben ocupar exactamente el resto del archivo
+        size_t tamanoEsperado = sizeof(CabeceraInstantanea) + 27 * sizeof(uint64_t) +
+                                cabecera->cantidadRegistros * sizeof(RegistroInstantanea) + cabecera->bytesCadenas;
+        if (cabecera->cantidadRegistros > tamano / sizeof(RegistroInstantanea) || tamanoEsperado != tamano)
+        {
+            throw runtime_error("El archivo " + rutaArchivo + " está incompleto o dañado.");
+        }
+        if (verificarSuma &&
+            acumularSumaVerificacion(0, datos + sizeof(CabeceraInstantanea), tamano - sizeof(CabeceraInstantanea)) !=
+                cabecera->sumaVerificacion)
+        {
+            throw runtime_error("La suma de verificación del archivo " + rutaArchivo + " no coincide.");
+        }
+
+        tabla = reinterpret_cast<const uint64_t *>(datos + sizeof(CabeceraInstantanea));
+        registros = reinterpret_cast<const RegistroInstantanea *>(tabla + 27);
+        cadenas = reinterpret_cast<const char *>(registros + cabecera->cantidadRegistros);
+        if (tabla[0] != 0 || tabla[26] != cabecera->cantidadRegistros)
+        {
+            throw runtime_error("La tabla de grupos del archivo " + rutaArchivo + " no es válida.");
+        }
+    }
+
+    // Método para obtener la cantidad de contactos guardados
+    size_t getCantidad() const { return cabecera->cantidadRegistros; }
+
+    // Método para obtener la última entrada del diario de cambios incluida en el archivo
+    uint64_t getSecuenciaDiario() const { return cabecera->version >= 2 ? cabecera->secuenciaDiario : 0; }
+
+    // Método para obtener el tamaño de la sección de cadenas (en bytes)
+    size_t getBytesCadenas() const { return cabecera->bytesCadenas; }
+
+    // Métodos para obtener el rango de posiciones del grupo de una letra (0 = 'A',...,25 = 'Z')
+    size_t getInicioGrupo(int letraInicial) const { return tabla[letraInicial]; }
+    size_t getFinGrupo(int letraInicial) const { return tabla[letraInicial + 1]; }
+
+    // Método para leer solo el nombre del contacto en una posición
+    string_view getNombre(size_t posicion) const
+    {
+        const char *cursor = cadenas + registros[posicion].desplazamiento;
+        return leerCadena(cursor);
+    }
+
+    // Método para obtener el contacto en una posición (sus textos apuntan al archivo mapeado)
+    Agenda getContacto(size_t posicion) const
+    {
+        const char *cursor = cadenas + registros[posicion].desplazamiento;
+        string_view nombre = leerCadena(cursor);
+        string_view apellido = leerCadena(cursor);
+        string_view email = leerCadena(cursor);
+        return Agenda(nombre, apellido, registros[posicion].numeroEmpaquetado, email);
+    }
+
+    // Método para buscar un contacto por nombre con búsqueda binaria dentro del grupo de su letra
+    // Retorna 'true' y guarda su posición en 'posicion' si lo encuentra
+    bool buscar(string_view nombre, size_t &posicion) const
+    {
+        int letraInicial = calcularLetraInicial(nombre);
+        if (letraInicial < 0)
+        {
+            return false;
+        }
+        size_t inicioRango = tabla[letraInicial], finRango = tabla[letraInicial + 1];
+        while (inicioRango < finRango)
+        {
+            size_t indiceMedio = inicioRango + (finRango - inicioRango) / 2;
+            int comparacion = compararNombres(getNombre(indiceMedio), nombre);
+            if (comparacion == 0)
+            {
+                posicion = indiceMedio;
+                return true;
+            }
+            else if (comparacion < 0)
+            {
+                inicioRango = indiceMedio + 1;
+            }
+            else
+            {
+                finRango = indiceMedio;
+            }
+        }
+        return false;
+    }
+};
+
+// Texto que se arma al decodificar el formato comprimido, en un búfer que no crece
+// Ningún texto del almacén supera los 65535 bytes (su longitud se guarda en 16 bits), así que si uno no entra
+// el archivo está dañado.
+struct TextoDecodificado
+{
+    static constexpr size_t CAPACIDAD = 1 << 16;
+    vector<char> bytes = vector<char>(CAPACIDAD);
+    size_t longitud = 0;
+
+    string_view getTexto() const { return string_view(bytes.data(), longitud); }
+};
+
+// Clase para leer los campos de un bloque del formato comprimido sin salirse de él
+// Si un campo no cabe, el lector queda inválido y los campos siguientes se leen vacíos
+class LectorBloque
+{
+private:
+    const char *cursor;
+    const char *fin;
+    bool valido;
+
+public:
+    LectorBloque(const char *inicio, const char *fin) : cursor(inicio), fin(fin), valido(true) {}
+
+    uint64_t leerEnteroVariable()
+    {
+        // Casi todos los valores (longitudes y repeticiones) entran en un solo byte
+        if (cursor < fin && static_cast<unsigned char>(*cursor) < 0x80)
+        {
+            return static_cast<unsigned char>(*cursor++);
+        }
+        uint64_t valor = 0;
+        for (unsigned desplazamiento = 0; cursor < fin && desplazamiento < 64; desplazamiento += 7)
+        {
+            unsigned char byte = static_cast<unsigned char>(*cursor++);
+            valor |= static_cast<uint64_t>(byte & 0x7F) << desplazamiento;
+            if (byte < 0x80)
+            {
+                return valor;
+            }
+        }
+        valido = false;
+        return 0;
+    }
+
+    string_view leerTexto(uint64_t longitud)
+    {
+        if (static_cast<uint64_t>(fin - cursor) < longitud)
+        {
+            valido = false;
+            return string_view();
+        }
+        string_view texto(cursor, longitud);
+        cursor += longitud;
+        return texto;
+    }
+
+    // Método para leer un texto precedido por su longitud y agregarlo al final de 'texto'
+    void leerAgregando(TextoDecodificado &texto)
+    {
+        string_view resto = leerTexto(leerEnteroVariable());
+        if (resto.size() > TextoDecodificado::CAPACIDAD - texto.longitud)
+        {
+            valido = false;
+            return;
+        }
+        memcpy(texto.bytes.data() + texto.longitud, resto.data(), resto.size());
+        texto.longitud += resto.size();
+    }
+
+    // Método para leer un texto con prefijo común: reemplaza en 'texto' lo que no comparte con el anterior
+    void leerConPrefijoComun(TextoDecodificado &texto)
+    {
+        uint64_t compartidos = leerEnteroVariable();
+        if (compartidos > texto.longitud)
+        {
+            valido = false;
+            return;
+        }
+        texto.longitud = compartidos;
+        leerAgregando(texto);
+    }
+
+    // Método para leer la repetición de un campo (ver 'anexarUsuarioEmail') y agregarla al final de 'texto'
+    void leerRepetidos(TextoDecodificado &texto, string_view campo)
+    {
+        uint64_t codigo = leerEnteroVariable();
+        uint64_t repetidos = codigo / 2;
+        if (repetidos > campo.size() || repetidos > TextoDecodificado::CAPACIDAD - texto.longitud)
+        {
+            valido = false;
+            return;
+        }
+        char *destino = texto.bytes.data() + texto.longitud;
+        if (codigo % 2 == 0)
+        {
+            memcpy(destino, campo.data(), repetidos);
+        }
+        else
+        {
+            for (size_t i = 0; i < repetidos; ++i)
+            {
+                destino[i] = static_cast<char>(plegarLetra(campo[i]));
+            }
+        }
+        texto.longitud += repetidos;
+    }
+
+    // Método para leer los números de un bloque (ver 'anexarNumerosBloque') en 'numeros', en el orden de los contactos
+    void leerNumeros(size_t cantidad, uint64_t *numeros)
+    {
+        if (cursor == fin)
+        {
+            valido = false;
+            return;
+        }
+        unsigned char bitsDiferencia = static_cast<unsigned char>(*cursor++);
+        if (bitsDiferencia == NUMEROS_SIN_DIFERENCIAS)
+        {
+            string_view empaquetados = leerTexto(calcularBytesEmpaquetados(cantidad, BITS_NUMERO_CELULAR));
+            for (size_t i = 0; i < cantidad && valido; ++i)
+            {
+                numeros[i] = leerEmpaquetado(empaquetados, i, BITS_NUMERO_CELULAR);
+                valido = numeros[i] < 10000000000ULL;
+            }
+            return;
+        }
+
+        uint64_t ordenados[CONTACTOS_POR_BLOQUE];
+        ordenados[0] = leerEnteroVariable();
+        string_view posiciones = leerTexto(calcularBytesEmpaquetados(cantidad, BITS_POSICION_BLOQUE));
+        string_view diferencias = leerTexto(calcularBytesEmpaquetados(cantidad - 1, bitsDiferencia));
+        if (!valido || bitsDiferencia > BITS_NUMERO_CELULAR || ordenados[0] >= 10000000000ULL)
+        {
+            valido = false;
+            return;
+        }
+        for (size_t i = 1; i < cantidad; ++i)
+        {
+            ordenados[i] = ordenados[i - 1] + leerEmpaquetado(diferencias, i - 1, bitsDiferencia);
+        }
+        // Cada contacto debe tener una posición distinta entre los números ordenados
+        unsigned usadas = 0;
+        for (size_t i = 0; i < cantidad; ++i)
+        {
+            size_t posicion = leerEmpaquetado(posiciones, i, BITS_POSICION_BLOQUE);
+            if (posicion >= cantidad)
+            {
+                valido = false;
+                return;
+            }
+            usadas |= 1u << posicion;
+            numeros[i] = ordenados[posicion];
+        }
+        valido = usadas == (1u << cantidad) - 1 && ordenados[cantidad - 1] < 10000000000ULL;
+    }
+
+    const char *getCursor() const { return cursor; }
+    bool esValido() const { return valido; }
+
+private:
+    // Método para obtener el valor 'indice' de los empaquetados en 'bytes' de a 'bits' bits (ver 'anexarBitsEmpaquetados')
+    // Se leen los (hasta) 8 bytes que lo contienen
+    static uint64_t leerEmpaquetado(string_view bytes, size_t indice, unsigned bits)
+    {
+        size_t bit = indice * bits;
+        uint64_t palabra = 0;
+        memcpy(&palabra, bytes.data() + bit / 8, min<size_t>(8, bytes.size() - bit / 8));
+        return (palabra >> (bit % 8)) & ((1ULL << bits) - 1);
+    }
+};
+
+// Clase para leer el archivo binario en el formato comprimido (versión 3) desde memoria mapeada
+// Los bloques se pueden decodificar en cualquier orden (el primer nombre de cada uno está completo), así que
+// la carga los reparte entre varios hilos y 'buscar' decodifica uno solo. Los diccionarios se leen completos
+// al abrir el archivo: los dominios apuntan al archivo mapeado y los apellidos se decodifican en memoria.
+class InstantaneaComprimida
+{
+private:
+    ArchivoMapeado archivo;
+    const CabeceraInstantanea *cabecera;
+    CabeceraComprimida secciones;
+    const uint64_t *tabla;
+    const uint64_t *indiceBloques;
+    const char *bloques;
+    size_t cantidadBloques;
+    string textoApellidos;
+    vector<string_view> apellidos;
+    vector<string_view> dominios;
+
+    // Método para obtener dónde empieza y termina un bloque y cuántos contactos tiene
+    size_t ubicarBloque(size_t bloque, const char *&inicio, const char *&fin) const
+    {
+        inicio = bloques + indiceBloques[bloque];
+        fin = bloques + (bloque + 1 < cantidadBloques ? indiceBloques[bloque + 1] : secciones.bytesBloques);
+        return min(CONTACTOS_POR_BLOQUE, cabecera->cantidadRegistros - bloque * CONTACTOS_POR_BLOQUE);
+    }
+
+public:
+    // Constructor: mapea el archivo, comprueba la cabecera, los tamaños y la suma de verificación y lee los diccionarios
+    // Lanza una excepción si el archivo no es válido
+    explicit InstantaneaComprimida(const string &rutaArchivo) : archivo(rutaArchivo)
+    {
+        const char *datos = archivo.getDatos();
+        size_t tamano = archivo.getTamano();
+        size_t inicioSecciones = sizeof(CabeceraInstantanea) + 27 * sizeof(uint64_t);
+        if (tamano < inicioSecciones + sizeof(CabeceraComprimida))
+        {
+            throw runtime_error("El archivo " + rutaArchivo + " es demasiado corto.");
+        }
+
+        cabecera = reinterpret_cast<const CabeceraInstantanea *>(datos);
+        if (memcmp(cabecera->magia, MAGIA_INSTANTANEA, sizeof(cabecera->magia)) != 0 ||
+            cabecera->version != VERSION_INSTANTANEA_COMPRIMIDA)
+        {
+            throw runtime_error("El archivo " + rutaArchivo + " no es una agenda binaria comprimida.");
+        }
+        if (acumularSumaVerificacion(0, datos + sizeof(CabeceraInstantanea), tamano - sizeof(CabeceraInstantanea)) !=
+            cabecera->sumaVerificacion)
+        {
+            throw runtime_error("La suma de verificación del archivo " + rutaArchivo + " no coincide.");
+        }
+
+        // Las secciones deben ocupar exactamente el resto del archivo
+        memcpy(&secciones, datos + inicioSecciones, sizeof(secciones));
+        cantidadBloques = (cabecera->cantidadRegistros + CONTACTOS_POR_BLOQUE - 1) / CONTACTOS_POR_BLOQUE;
+        uint64_t tamanoSecciones = sizeof(CabeceraComprimida) + cantidadBloques * sizeof(uint64_t) +
+                                   secciones.bytesApellidos + secciones.bytesDominios + secciones.bytesBloques;
+        if (cabecera->cantidadRegistros > tamano || secciones.bytesApellidos > tamano || secciones.bytesDominios > tamano ||
+            secciones.bytesBloques > tamano || tamanoSecciones != cabecera->bytesCadenas ||
+            inicioSecciones + tamanoSecciones != tamano)
+        {
+            throw runtime_error("El archivo " + rutaArchivo + " está incompleto o dañado.");
+        }
+
+        tabla = reinterpret_cast<const uint64_t *>(datos + sizeof(CabeceraInstantanea));
+        indiceBloques = reinterpret_cast<const uint64_t *>(datos + inicioSecciones + sizeof(CabeceraComprimida));
+        const char *inicioApellidos = reinterpret_cast<const char *>(indiceBloques + cantidadBloques);
+        const char *inicioDominios = inicioApellidos + secciones.bytesApellidos;
+        bloques = inicioDominios + secciones.bytesDominios;
+        bool tablaValida = tabla[0] == 0 && tabla[26] == cabecera->cantidadRegistros;
+        for (int i = 0; i < 26; ++i)
+        {
+            tablaValida = tablaValida && tabla[i] <= tabla[i + 1];
+        }
+        for (size_t bloque = 0; bloque < cantidadBloques; ++bloque)
+        {
+            uint64_t finBloque = bloque + 1 < cantidadBloques ? indiceBloques[bloque + 1] : secciones.bytesBloques;
+            tablaValida = tablaValida && indiceBloques[bloque] <= finBloque;
+        }
+        if (!tablaValida)
+        {
+            throw runtime_error("La tabla de grupos o de bloques del archivo " + rutaArchivo + " no es válida.");
+        }
+
+        // Diccionario de apellidos: se decodifica en 'textoApellidos' y después se arman las vistas (el texto ya no crece)
+        LectorBloque lectorApellidos(inicioApellidos, inicioDominios);
+        vector<pair<size_t, size_t>> ubicaciones;
+        TextoDecodificado apellido;
+        for (uint64_t i = 0; i < secciones.cantidadApellidos && lectorApellidos.esValido(); ++i)
+        {
+            lectorApellidos.leerConPrefijoComun(apellido);
+            ubicaciones.push_back({textoApellidos.size(), apellido.longitud});
+            textoApellidos += apellido.getTexto();
+        }
+        for (const pair<size_t, size_t> &ubicacion : ubicaciones)
+        {
+            apellidos.push_back(string_view(textoApellidos).substr(ubicacion.first, ubicacion.second));
+        }
+
+        LectorBloque lectorDominios(inicioDominios, bloques);
+        for (uint64_t i = 0; i < secciones.cantidadDominios && lectorDominios.esValido(); ++i)
+        {
+            dominios.push_back(lectorDominios.leerTexto(lectorDominios.leerEnteroVariable()));
+        }
+        if (!lectorApellidos.esValido() || lectorApellidos.getCursor() != inicioDominios ||
+            !lectorDominios.esValido() || lectorDominios.getCursor() != bloques)
+        {
+            throw runtime_error("Los diccionarios del archivo " + rutaArchivo + " están dañados.");
+        }
+    }
+
+    // Métodos para obtener la cantidad de contactos y de bloques guardados
+    size_t getCantidad() const { return cabecera->cantidadRegistros; }
+    size_t getCantidadBloques() const { return cantidadBloques; }
+
+    // Método para obtener la última entrada del diario de cambios incluida en el archivo
+    uint64_t getSecuenciaDiario() const { return cabecera->secuenciaDiario; }
+
+    // Método para obtener lo que ocupan los textos de los contactos ya decodificados (en bytes)
+    size_t getBytesTextos() const { return secciones.bytesTextos; }
+
+    // Método para decodificar en orden los contactos de los bloques [primerBloque, finBloque)
+    // 'visitar' recibe el nombre, el apellido, el número empaquetado y el email de cada contacto; los textos
+    // solo son válidos durante la llamada. Lanza una excepción si un bloque está dañado.
+    template <typename Visitar>
+    void recorrerBloques(size_t primerBloque, size_t finBloque, Visitar visitar) const
+    {
+        // Los búferes se reservan una vez por hilo (decodificar un solo bloque en 'buscar' no debe pedir memoria)
+        thread_local TextoDecodificado buferNombre, buferEmail;
+        TextoDecodificado &nombre = buferNombre, &email = buferEmail;
+        for (size_t bloque = primerBloque; bloque < finBloque; ++bloque)
+        {
+            const char *inicio, *fin;
+            size_t cantidad = ubicarBloque(bloque, inicio, fin);
+            LectorBloque lector(inicio, fin);
+            uint64_t numeros[CONTACTOS_POR_BLOQUE];
+            lector.leerNumeros(cantidad, numeros);
+            if (!lector.esValido())
+            {
+                throw runtime_error("Un bloque del archivo comprimido está dañado.");
+            }
+
+            nombre.longitud = 0;
+            for (size_t i = 0; i < cantidad; ++i)
+            {
+                lector.leerConPrefijoComun(nombre);
+                uint64_t numeroApellido = lector.leerEnteroVariable();
+                uint64_t numeroDominio = lector.leerEnteroVariable();
+                if (numeroApellido >= apellidos.size() || numeroDominio > dominios.size())
+                {
+                    throw runtime_error("Un bloque del archivo comprimido está dañado.");
+                }
+                string_view apellido = apellidos[numeroApellido];
+
+                email.longitud = 0;
+                lector.leerRepetidos(email, nombre.getTexto());
+                lector.leerAgregando(email);
+                lector.leerRepetidos(email, apellido);
+                lector.leerAgregando(email);
+                if (numeroDominio > 0)
+                {
+                    string_view dominio = dominios[numeroDominio - 1];
+                    if (dominio.size() >= TextoDecodificado::CAPACIDAD - email.longitud)
+                    {
+                        throw runtime_error("Un bloque del archivo comprimido está dañado.");
+                    }
+                    email.bytes[email.longitud] = '@';
+                    memcpy(email.bytes.data() + email.longitud + 1, dominio.data(), dominio.size());
+                    email.longitud += dominio.size() + 1;
+                }
+                if (!lector.esValido())
+                {
+                    break;
+                }
+                visitar(nombre.getTexto(), apellido, numeros[i], email.getTexto());
+            }
+            if (!lector.esValido() || lector.getCursor() != fin)
+            {
+                throw runtime_error("Un bloque del archivo comprimido está dañado.");
+            }
+        }
+    }
+
+    // Método para buscar un contacto por nombre sin decodificar todo el archivo
+    // Busca con búsqueda binaria, entre los bloques del grupo de su letra, el último cuyo primer nombre no va
+    // después del buscado, y decodifica solo ese bloque. Si lo encuentra, llama a 'visitar' con sus datos
+    // (como en 'recorrerBloques') y retorna 'true'.
+    template <typename Visitar>
+    bool buscar(string_view nombre, Visitar visitar) const
+    {
+        int letraInicial = calcularLetraInicial(nombre);
+        if (letraInicial < 0 || tabla[letraInicial] == tabla[letraInicial + 1])
+        {
+            return false;
+        }
+        size_t inicioRango = tabla[letraInicial] / CONTACTOS_POR_BLOQUE;
+        size_t finRango = (tabla[letraInicial + 1] - 1) / CONTACTOS_POR_BLOQUE + 1;
+        while (finRango - inicioRango > 1)
+        {
+            size_t bloqueMedio = inicioRango + (finRango - inicioRango) / 2;
+            const char *inicio, *fin;
+            size_t cantidad = ubicarBloque(bloqueMedio, inicio, fin);
+            LectorBloque lector(inicio, fin);
+            uint64_t numeros[CONTACTOS_POR_BLOQUE];
+            lector.leerNumeros(cantidad, numeros); // Hay que pasarlos para llegar al primer nombre
+            lector.leerEnteroVariable();           // El primer nombre del bloque no comparte nada con el anterior
+            string_view primerNombre = lector.leerTexto(lector.leerEnteroVariable());
+            if (compararNombres(primerNombre, nombre) <= 0)
+            {
+                inicioRango = bloqueMedio;
+            }
+            else
+            {
+                finRango = bloqueMedio;
+            }
+        }
+
+        bool encontrado = false;
+        recorrerBloques(inicioRango, inicioRango + 1, [&](string_view nombreContacto, string_view apellido, uint64_t numero, string_view email)
+                        {
+                            if (!encontrado && compararNombres(nombreContacto, nombre) == 0)
+                            {
+                                encontrado = true;
+                                visitar(nombreContacto, apellido, numero, email);
+                            }
+                        });
+        return encontrado;
+    }
+};
+
+// Función para leer la versión del archivo binario (0 si no se puede leer o no es una agenda binaria)
+uint32_t leerVersionInstantanea(const string &rutaArchivo)
+{
+    ifstream archivo(rutaArchivo, ios::in | ios::binary);
+    CabeceraInstantanea cabecera;
+    if (!archivo.read(reinterpret_cast<char *>(&cabecera), sizeof(cabecera)) ||
+        memcmp(cabecera.magia, MAGIA_INSTANTANEA, sizeof(cabecera.magia)) != 0)
+    {
+        return 0;
+    }
+    return cabecera.version;
+}
+
+// Función para cargar en la agenda los contactos del archivo binario comprimido
+// Los bloques se reparten entre varios hilos; cada uno los decodifica en su propio almacén y al final se unen
+// al de la agenda (en el orden de los bloques, así los contactos siguen ordenados por nombre).
+size_t cargarInstantaneaComprimida(AgendaContactos &agenda, const string &rutaArchivo, uint64_t &secuenciaDiario)
+{
+    InstantaneaComprimida instantanea(rutaArchivo);
+    size_t cantidadBloques = instantanea.getCantidadBloques();
+    secuenciaDiario = instantanea.getSecuenciaDiario();
+
+    // Se usa un hilo por núcleo, pero sin menos de 4096 bloques (65536 contactos) por hilo
+    size_t cantidadHilos = thread::hardware_concurrency();
+    cantidadHilos = max<size_t>(1, min(cantidadHilos, cantidadBloques / 4096 + 1));
+    vector<AlmacenContactos> almacenesPorHilo(cantidadHilos);
+    vector<string> erroresPorHilo(cantidadHilos);
+
+    auto decodificarBloques = [&](size_t hilo)
+    {
+        size_t primerBloque = cantidadBloques * hilo / cantidadHilos;
+        size_t finBloque = cantidadBloques * (hilo + 1) / cantidadHilos;
+        AlmacenContactos &almacen = almacenesPorHilo[hilo];
+        almacen.reservar((finBloque - primerBloque) * CONTACTOS_POR_BLOQUE,
+                         cantidadBloques > 0 ? instantanea.getBytesTextos() / cantidadBloques * (finBloque - primerBloque) : 0);
+        try
+        {
+            instantanea.recorrerBloques(primerBloque, finBloque, [&](string_view nombre, string_view apellido, uint64_t numero, string_view email)
+                                        { almacen.agregar(nombre, apellido, numero, email); });
+        }
+        catch (const runtime_error &errorBloque)
+        {
+            erroresPorHilo[hilo] = errorBloque.what();
+        }
+    };
+
+    vector<thread> hilos;
+    for (size_t i = 1; i < cantidadHilos; ++i)
+    {
+        hilos.emplace_back(decodificarBloques, i);
+    }
+    decodificarBloques(0);
+    for (thread &hilo : hilos)
+    {
+        hilo.join();
+    }
+    for (const string &error : erroresPorHilo)
+    {
+        if (!error.empty())
+        {
+            throw runtime_error(error);
+        }
+    }
+
+    size_t cantidad = instantanea.getCantidad();
+    agenda.indiceTelefonos.reservar(agenda.indiceTelefonos.getCantidad() + cantidad);
+    LoteDeContactos lote(agenda);
+    lote.reservar(cantidad);
+    for (size_t hilo = 0; hilo < cantidadHilos; ++hilo)
+    {
+        size_t leidos = almacenesPorHilo[hilo].getTotalRegistros();
+        uint32_t base = agenda.almacen.anexar(move(almacenesPorHilo[hilo]));
+        for (size_t contacto = 0; contacto < leidos; ++contacto)
+        {
+            lote.agregar(base + static_cast<uint32_t>(contacto));
+        }
+    }
+    lote.confirmar();
+    return cantidad;
+}
+
+// Función para cargar en la agenda los contactos del archivo binario
+size_t cargarInstantanea(AgendaContactos &agenda, const string &rutaArchivo, uint64_t &secuenciaDiario, bool informar)
+{
+    auto inicioCarga = chrono::steady_clock::now();
+    size_t cantidad;
+    bool comprimido = leerVersionInstantanea(rutaArchivo) == VERSION_INSTANTANEA_COMPRIMIDA;
+    if (comprimido)
+    {
+        cantidad = cargarInstantaneaComprimida(agenda, rutaArchivo, secuenciaDiario);
+    }
+    else
+    {
+        InstantaneaMapeada instantanea(rutaArchivo);
+        cantidad = instantanea.getCantidad();
+        secuenciaDiario = instantanea.getSecuenciaDiario();
+
+        agenda.almacen.reservar(cantidad, instantanea.getBytesCadenas());
+        agenda.indiceTelefonos.reservar(agenda.indiceTelefonos.getCantidad() + cantidad);
+        LoteDeContactos lote(agenda);
+        for (size_t posicion = 0; posicion < cantidad; ++posicion)
+        {
+            Agenda contacto = instantanea.getContacto(posicion);
+            uint32_t indice = agenda.almacen.agregar(contacto.getNombre(), contacto.getApellido(),
+                                                     contacto.getNumeroEmpaquetado(), contacto.getEmail());
+            lote.agregar(indice);
+        }
+        lote.confirmar();
+    }
+    if (!informar)
+    {
+        return cantidad;
+    }
+
+    // Informa el tiempo de carga y la velocidad en contactos por segundo
+    chrono::duration<double> duracion = chrono::steady_clock::now() - inicioCarga;
+    double segundos = duracion.count();
+    cout << "Se cargaron " << cantidad << " contactos del archivo binario" << (comprimido ? " comprimido" : "") << " en "
+         << segundos * 1000.0 << " ms";
+    if (segundos > 0)
+    {
+        cout << " (" << static_cast<size_t>(cantidad / segundos) << " contactos/s)";
+    }
+    cout << "." << endl;
+    return cantidad;
+}
+
+// Cabecera de cada entrada del diario de cambios
+// Después de la cabecera va la carga ('longitudCarga' bytes) y al final una suma de verificación de
+// 64 bits que cubre la cabecera y la carga
+struct CabeceraEntradaDiario
+{
+    uint32_t longitudCarga;
+    uint32_t tipo;      // TipoEntradaDiario
+    uint64_t secuencia; // Número de la entrada, crece de uno en uno (también entre archivos)
+};
+
+static_assert(sizeof(CabeceraEntradaDiario) == 16, "La cabecera de las entradas del diario debe ocupar 16 bytes");
+
+// Función para agregar un entero de 64 bits al final de la carga de una entrada
+void anexarEntero(vector<char> &carga, uint64_t valor)
+{
+    const char *bytes = reinterpret_cast<const char *>(&valor);
+    carga.insert(carga.end(), bytes, bytes + sizeof(valor));
+}
+
+// Función para agregar un texto precedido por su longitud (16 bits) al final de la carga de una entrada
+void anexarTexto(vector<char> &carga, string_view texto)
+{
+    uint16_t longitud = static_cast<uint16_t>(texto.size());
+    const char *bytes = reinterpret_cast<const char *>(&longitud);
+    carga.insert(carga.end(), bytes, bytes + sizeof(longitud));
+    carga.insert(carga.end(), texto.begin(), texto.end());
+}
+
+// Clase para leer los campos de la carga de una entrada sin salirse de ella
+// Si un campo no cabe, el lector queda inválido y los campos siguientes se leen vacíos
+class LectorEntrada
+{
+private:
+    const char *cursor;
+    const char *fin;
+    bool valido;
+
+public:
+    LectorEntrada(const char *inicio, size_t tamano) : cursor(inicio), fin(inicio + tamano), valido(true) {}
+
+    uint64_t leerEntero()
+    {
+        uint64_t valor = 0;
+        if (fin - cursor < static_cast<ptrdiff_t>(sizeof(valor)))
+        {
+            valido = false;
+            return 0;
+        }
+        memcpy(&valor, cursor, sizeof(valor));
+        cursor += sizeof(valor);
+        return valor;
+    }
+
+    string_view leerTexto()
+    {
+        uint16_t longitud;
+        if (fin - cursor < static_cast<ptrdiff_t>(sizeof(longitud)))
+        {
+            valido = false;
+            return string_view();
+        }
+        memcpy(&longitud, cursor, sizeof(longitud));
+        if (fin - cursor - static_cast<ptrdiff_t>(sizeof(longitud)) < longitud)
+        {
+            valido = false;
+            return string_view();
+        }
+        string_view texto(cursor + sizeof(longitud), longitud);
+        cursor += sizeof(longitud) + longitud;
+        return texto;
+    }
+
+    bool esValido() const { return valido; }
+};
+
+// Función para localizar un contacto por todos sus datos (ver 'ENTRADA_BAJA_EXACTA')
+// Si hay varios iguales da lo mismo cuál se elige: después de cambiarlo o borrarlo la agenda queda igual.
+bool localizarContactoExacto(const AgendaContactos &agenda, string_view nombre, string_view apellido, uint64_t numero,
+                             string_view email, size_t &particion, size_t &posicion)
+{
+    if (!localizarContacto(agenda, nombre, numero, particion, posicion))
+    {
+        return false;
+    }
+    const AlmacenContactos &almacen = agenda.almacen;
+    const vector<uint32_t> &grupo = agenda.particiones.getContactos(particion);
+    for (; posicion < grupo.size() && almacen.getNombre(grupo[posicion]) == nombre; ++posicion)
+    {
+        uint32_t contacto = grupo[posicion];
+        if (almacen.getNumeroEmpaquetado(contacto) == numero && almacen.getApellido(contacto) == apellido &&
+            almacen.getEmail(contacto) == email)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Función para aplicar a la agenda una entrada del diario de cambios
+// Retorna 'false' si la carga no es válida o si el contacto que modifica o elimina no existe
+bool aplicarEntradaDiario(AgendaContactos &agenda, uint32_t tipo, const char *carga, size_t longitud)
+{
+    LectorEntrada lector(carga, longitud);
+    size_t particion, posicion;
+
+    if (tipo == ENTRADA_ALTA)
+    {
+        uint64_t numero = lector.leerEntero();
+        string_view nombre = lector.leerTexto(), apellido = lector.leerTexto(), email = lector.leerTexto();
+        return lector.esValido() &&
+               registrarContacto(agenda, nombre, apellido, desempaquetarNumeroCelular(numero), email) !=
+                   numeric_limits<uint32_t>::max();
+    }
+    if (tipo == ENTRADA_EDICION)
+    {
+        uint64_t numeroAnterior = lector.leerEntero();
+        string_view nombreAnterior = lector.leerTexto();
+        uint64_t numero = lector.leerEntero();
+        string_view nombre = lector.leerTexto(), apellido = lector.leerTexto(), email = lector.leerTexto();
+        if (!lector.esValido() || !localizarContacto(agenda, nombreAnterior, numeroAnterior, particion, posicion))
+        {
+            return false;
+        }
+        modificarContacto(agenda, agenda.particiones.getContactos(particion)[posicion], nombre, apellido,
+                          desempaquetarNumeroCelular(numero), email);
+        return true;
+    }
+    if (tipo == ENTRADA_EDICION_EXACTA)
+    {
+        uint64_t numeroAnterior = lector.leerEntero();
+        string_view nombreAnterior = lector.leerTexto(), apellidoAnterior = lector.leerTexto();
+        string_view emailAnterior = lector.leerTexto();
+        uint64_t numero = lector.leerEntero();
+        string_view nombre = lector.leerTexto(), apellido = lector.leerTexto(), email = lector.leerTexto();
+        if (!lector.esValido() || !localizarContactoExacto(agenda, nombreAnterior, apellidoAnterior, numeroAnterior,
+                                                           emailAnterior, particion, posicion))
+        {
+            return false;
+        }
+        modificarContacto(agenda, agenda.particiones.getContactos(particion)[posicion], nombre, apellido,
+                          desempaquetarNumeroCelular(numero), email);
+        return true;
+    }
+    if (tipo == ENTRADA_BAJA)
+    {
+        uint64_t numero = lector.leerEntero();
+        string_view nombre = lector.leerTexto();
+        if (!lector.esValido() || !localizarContacto(agenda, nombre, numero, particion, posicion))
+        {
+            return false;
+        }
+        borrarContacto(agenda, particion, posicion);
+        return true;
+    }
+    if (tipo == ENTRADA_BAJA_EXACTA)
+    {
+        uint64_t numero = lector.leerEntero();
+        string_view nombre = lector.leerTexto(), apellido = lector.leerTexto(), email = lector.leerTexto();
+        if (!lector.esValido() || !localizarContactoExacto(agenda, nombre, apellido, numero, email, particion, posicion))
+        {
+            return false;
+        }
+        borrarContacto(agenda, particion, posicion);
+        return true;
+    }
+    return false;
+}
+
+// Función para aplicar a la agenda las entradas de un archivo del diario posteriores a 'secuenciaBase'
+uint64_t reproducirDiario(AgendaContactos &agenda, const string &rutaDiario, uint64_t secuenciaBase,
+                          uint64_t &ultimaSecuencia, size_t &aplicadas)
+{
+    ArchivoMapeado archivo(rutaDiario);
+    const char *datos = archivo.getDatos();
+    size_t tamano = archivo.getTamano();
+    size_t posicion = 0;
+
+    while (tamano - posicion >= sizeof(CabeceraEntradaDiario) + sizeof(uint64_t))
+    {
+        CabeceraEntradaDiario cabecera;
+        memcpy(&cabecera, datos + posicion, sizeof(cabecera));
+        size_t tamanoEntrada = sizeof(cabecera) + static_cast<size_t>(cabecera.longitudCarga) + sizeof(uint64_t);
+        if (tamano - posicion < tamanoEntrada)
+        {
+            break; // Entrada incompleta
+        }
+
+        uint64_t suma;
+        memcpy(&suma, datos + posicion + tamanoEntrada - sizeof(suma), sizeof(suma));
+        if (acumularSumaVerificacion(0, datos + posicion, tamanoEntrada - sizeof(suma)) != suma)
+        {
+            break; // Entrada dañada
+        }
+
+        // Las entradas que ya están incluidas en el archivo binario se saltan
+        if (cabecera.secuencia > secuenciaBase &&
+            aplicarEntradaDiario(agenda, cabecera.tipo, datos + posicion + sizeof(cabecera), cabecera.longitudCarga))
+        {
+            aplicadas++;
+        }
+        ultimaSecuencia = max(ultimaSecuencia, cabecera.secuencia);
+        posicion += tamanoEntrada;
+    }
+    return posicion;
+}
+
+// Función para listar los segmentos rotados de un diario que existen, del más viejo al más nuevo
+vector<string> listarSegmentosDiario(const string &rutaDiario)
+{
+    filesystem::path ruta(rutaDiario);
+    filesystem::path carpeta = ruta.has_parent_path() ? ruta.parent_path() : filesystem::path(".");
+    string prefijo = ruta.filename().string() + ".";
+    vector<pair<uint64_t, string>> segmentos;
+    for (const filesystem::directory_entry &entrada : filesystem::directory_iterator(carpeta))
+    {
+        string nombre = entrada.path().filename().string();
+        if (nombre.size() <= prefijo.size() || nombre.compare(0, prefijo.size(), prefijo) != 0 ||
+            nombre.size() - prefijo.size() > 9 ||
+            !all_of(nombre.begin() + prefijo.size(), nombre.end(), [](char c)
+                    { return c >= '0' && c <= '9'; }))
+        {
+            continue;
+        }
+        segmentos.emplace_back(stoull(nombre.substr(prefijo.size())), rutaDiario + nombre.substr(prefijo.size() - 1));
+    }
+    sort(segmentos.begin(), segmentos.end());
+    vector<string> rutas;
+    for (const auto &segmento : segmentos)
+    {
+        rutas.push_back(segmento.second);
+    }
+    return rutas;
+}
+
+// Función para compactar segmentos rotados del diario: aplica sus entradas (en orden) sobre el archivo binario
+// y escribe uno nuevo. Trabaja sobre su propia copia de la agenda leída de los archivos, así que no toca la
+// agenda del menú. Al terminar borra los segmentos; si el programa se corta antes, al iniciar se vuelven a
+// aplicar (las entradas que ya estén en el archivo binario se saltan por su secuencia).
+void compactarDiario(const string &rutaInstantanea, const vector<string> &segmentos, bool comprimir)
+{
+    AgendaContactos agenda;
+    uint64_t secuenciaBase = 0;
+    if (filesystem::exists(rutaInstantanea))
+    {
+        cargarInstantanea(agenda, rutaInstantanea, secuenciaBase, false);
+    }
+
+    uint64_t ultimaSecuencia = secuenciaBase;
+    size_t aplicadas = 0;
+    for (const string &segmento : segmentos)
+    {
+        reproducirDiario(agenda, segmento, secuenciaBase, ultimaSecuencia, aplicadas);
+    }
+    guardarInstantanea(agenda, rutaInstantanea, ultimaSecuencia, comprimir);
+    for (const string &segmento : segmentos)
+    {
+        filesystem::remove(segmento);
+    }
+}
+
+// Constructor: abre el diario para agregar entradas al final y arranca el hilo que confirma los grupos
+// 'siguienteSecuencia' es el número que recibirá la próxima entrada
+DiarioCambios::DiarioCambios(const string &rutaDiario, const string &rutaInstantanea, uint64_t siguienteSecuencia,
+                             const ConfiguracionDiario &configuracion)
+    : rutaDiario(rutaDiario), rutaInstantanea(rutaInstantanea), configuracion(configuracion), descriptor(-1),
+      siguienteSecuencia(siguienteSecuencia), bytesEnArchivo(0), entradasPendientes(0), terminando(false),
+      cambiosSinCompactar(0), compactando(false), segmentosEnEspera(false)
+{
+    abrirArchivo();
+    // Un diario que ya tenía entradas se compacta cuando pase 'intervaloCompactacion' (o antes si sigue creciendo)
+    if (bytesEnArchivo > 0)
+    {
+        cambiosSinCompactar = 1;
+        inicioCambios = chrono::steady_clock::now();
+    }
+    hiloConfirmacion = thread(&DiarioCambios::esperarConfirmaciones, this);
+
+    // Si quedaron segmentos rotados (una compactación que no terminó), se retoma en segundo plano
+    if (!listarSegmentosDiario(rutaDiario).empty())
+    {
+        lock_guard<mutex> bloqueo(candado);
+        iniciarCompactacionBloqueado();
+    }
+}
+
+// Destructor: confirma lo pendiente y espera a los hilos del diario
+DiarioCambios::~DiarioCambios()
+{
+    {
+        lock_guard<mutex> bloqueo(candado);
+        terminando = true;
+        try
+        {
+            confirmarBloqueado();
+        }
+        catch (const exception &error)
+        {
+            cerr << "Excepción al confirmar el diario de cambios: " << error.what() << endl;
+        }
+    }
+    avisoPendientes.notify_one();
+    hiloConfirmacion.join();
+    if (hiloCompactacion.joinable())
+    {
+        hiloCompactacion.join();
+    }
+#ifndef _WIN32
+    close(descriptor);
+#else
+    _close(descriptor);
+#endif
+}
+
+// Método para abrir (o crear) el archivo del diario en modo de agregar al final
+void DiarioCambios::abrirArchivo()
+{
+#ifndef _WIN32
+    descriptor = open(rutaDiario.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+#else
+    descriptor = _open(rutaDiario.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#endif
+    if (descriptor < 0)
+    {
+        throw runtime_error("No se pudo abrir el diario de cambios " + rutaDiario + ".");
+    }
+    bytesEnArchivo = filesystem::file_size(rutaDiario);
+}
+
+// Método para serializar una entrada y dejarla pendiente hasta que se confirme su grupo
+void DiarioCambios::agregarEntrada(TipoEntradaDiario tipo, const vector<char> &carga)
+{
+    lock_guard<mutex> bloqueo(candado);
+    CabeceraEntradaDiario cabecera{static_cast<uint32_t>(carga.size()), tipo, siguienteSecuencia++};
+    size_t inicio = pendientes.size();
+    const char *bytes = reinterpret_cast<const char *>(&cabecera);
+    pendientes.insert(pendientes.end(), bytes, bytes + sizeof(cabecera));
+    pendientes.insert(pendientes.end(), carga.begin(), carga.end());
+    uint64_t suma = acumularSumaVerificacion(0, pendientes.data() + inicio, pendientes.size() - inicio);
+    anexarEntero(pendientes, suma);
+
+    // La primera entrada del grupo despierta al hilo que lo confirma pasado el intervalo
+    if (entradasPendientes++ == 0)
+    {
+        inicioPendientes = chrono::steady_clock::now();
+        avisoPendientes.notify_one();
+    }
+    if (entradasPendientes >= configuracion.entradasPorGrupo)
+    {
+        confirmarBloqueado();
+    }
+}
+
+// Método para escribir en el archivo las entradas pendientes y sincronizarlo con el disco
+// Se llama con el candado tomado
+void DiarioCambios::confirmarBloqueado()
+{
+    if (pendientes.empty())
+    {
+        return;
+    }
+    MedicionOperacion medicion(OPERACION_GUARDAR);
+
+    size_t escritos = 0;
+    while (escritos < pendientes.size())
+    {
+#ifndef _WIN32
+        ssize_t resultado = write(descriptor, pendientes.data() + escritos, pendientes.size() - escritos);
+        if (resultado < 0 && errno == EINTR)
+        {
+            continue;
+        }
+#else
+        int resultado = _write(descriptor, pendientes.data() + escritos, static_cast<unsigned>(pendientes.size() - escritos));
+#endif
+        if (resultado < 0)
+        {
+            throw runtime_error("No se pudo escribir el diario de cambios.");
+        }
+        escritos += static_cast<size_t>(resultado);
+    }
+    if (configuracion.sincronizarDisco)
+    {
+#ifndef _WIN32
+        fsync(descriptor);
+#else
+        _commit(descriptor);
+#endif
+    }
+
+    bytesEnArchivo += pendientes.size();
+    contarBytesEscritos(pendientes.size());
+    pendientes.clear();
+    if (cambiosSinCompactar == 0)
+    {
+        inicioCambios = inicioPendientes;
+    }
+    cambiosSinCompactar += entradasPendientes;
+    entradasPendientes = 0;
+
+    // Si el diario llegó a su tamaño máximo mientras se compacta, se rota a un segmento nuevo en lugar de hacer
+    // esperar a los cambios; el segmento queda para la próxima compactación
+    if (compactando && configuracion.bytesMaximosDiario > 0 && bytesEnArchivo >= configuracion.bytesMaximosDiario)
+    {
+        rotarBloqueado();
+        segmentosEnEspera = true;
+        return;
+    }
+
+    // El intervalo de compactación lo revisa el hilo de confirmación
+    if (bytesEnArchivo >= configuracion.bytesParaCompactar ||
+        (configuracion.cambiosParaCompactar > 0 && cambiosSinCompactar >= configuracion.cambiosParaCompactar))
+    {
+        iniciarCompactacionBloqueado();
+    }
+}
+
+// Método para renombrar el diario actual como el segmento siguiente al último que existe y seguir en uno nuevo
+// Se llama con el candado tomado y sin entradas pendientes
+void DiarioCambios::rotarBloqueado()
+{
+    vector<string> segmentos = listarSegmentosDiario(rutaDiario);
+    uint64_t numero = segmentos.empty() ? 1 : stoull(segmentos.back().substr(rutaDiario.size() + 1)) + 1;
+#ifndef _WIN32
+    close(descriptor);
+#else
+    _close(descriptor);
+#endif
+    filesystem::rename(rutaDiario, rutaDiario + "." + to_string(numero));
+    abrirArchivo();
+}
+
+// Método para rotar el diario y compactarlo en segundo plano (si no hay otra compactación en curso)
+// Se compactan juntos todos los segmentos rotados: el diario actual y los que quedaron de antes (de una
+// compactación que falló o no terminó, o rotados por tamaño mientras se compactaba).
+// Se llama con el candado tomado y sin entradas pendientes
+void DiarioCambios::iniciarCompactacionBloqueado()
+{
+    if (compactando || terminando)
+    {
+        return;
+    }
+
+    if (bytesEnArchivo > 0)
+    {
+        rotarBloqueado();
+        cambiosSinCompactar = 0;
+    }
+    segmentosEnEspera = false;
+    vector<string> segmentos = listarSegmentosDiario(rutaDiario);
+    if (segmentos.empty())
+    {
+        return;
+    }
+
+    if (hiloCompactacion.joinable())
+    {
+        hiloCompactacion.join(); // Es la compactación anterior, que ya terminó
+    }
+    compactando = true;
+    hiloCompactacion = thread([this, segmentos]()
+                              {
+                                  try
+                                  {
+                                      compactarDiario(rutaInstantanea, segmentos, configuracion.comprimirInstantanea);
+                                  }
+                                  catch (const exception &error)
+                                  {
+                                      cerr << "Excepción al compactar el diario de cambios: " << error.what() << endl;
+                                  }
+                                  // Despierta al hilo de confirmación (por el intervalo y por los segmentos en espera)
+                                  lock_guard<mutex> bloqueo(candado);
+                                  compactando = false;
+                                  avisoPendientes.notify_one();
+                              });
+}
+
+// Método del hilo que confirma los grupos que no se llenan antes de 'intervaloConfirmacion' y que inicia la
+// compactación cuando el cambio confirmado más viejo lleva 'intervaloCompactacion' fuera del archivo binario
+void DiarioCambios::esperarConfirmaciones()
+{
+    unique_lock<mutex> bloqueo(candado);
+    while (!terminando)
+    {
+        // Mientras se compacta no corre el intervalo de compactación: el hilo que compacta avisa al terminar
+        bool porTiempo = configuracion.intervaloCompactacion.count() > 0 && cambiosSinCompactar > 0 && !compactando;
+
+        // Los segmentos rotados por tamaño durante la compactación anterior se compactan apenas termina
+        if (segmentosEnEspera && !compactando)
+        {
+            try
+            {
+                confirmarBloqueado();
+                iniciarCompactacionBloqueado();
+            }
+            catch (const exception &error)
+            {
+                cerr << "Excepción al compactar el diario de cambios: " << error.what() << endl;
+                segmentosEnEspera = false;
+            }
+            continue;
+        }
+        if (entradasPendientes == 0 && !porTiempo)
+        {
+            avisoPendientes.wait(bloqueo);
+            continue;
+        }
+        auto limiteGrupo = entradasPendientes > 0 ? inicioPendientes + configuracion.intervaloConfirmacion
+                                                  : chrono::steady_clock::time_point::max();
+        auto limiteCompactacion = porTiempo ? inicioCambios + configuracion.intervaloCompactacion
+                                            : chrono::steady_clock::time_point::max();
+        auto ahora = chrono::steady_clock::now();
+        if (ahora < limiteGrupo && ahora < limiteCompactacion)
+        {
+            avisoPendientes.wait_until(bloqueo, min(limiteGrupo, limiteCompactacion));
+            continue;
+        }
+        try
+        {
+            confirmarBloqueado();
+        }
+        catch (const exception &error)
+        {
+            cerr << "Excepción al confirmar el diario de cambios: " << error.what() << endl;
+            pendientes.clear();
+            entradasPendientes = 0;
+        }
+        if (ahora >= limiteCompactacion)
+        {
+            // Si la compactación no se puede iniciar o falla, se vuelve a intentar pasado otro intervalo
+            inicioCambios = ahora;
+            try
+            {
+                iniciarCompactacionBloqueado();
+            }
+            catch (const exception &error)
+            {
+                cerr << "Excepción al compactar el diario de cambios: " << error.what() << endl;
+            }
+        }
+    }
+}
+
+// Método para anotar un contacto agregado
+void DiarioCambios::registrarAlta(const AlmacenContactos &almacen, uint32_t contacto)
+{
+    vector<char> carga;
+    anexarEntero(carga, almacen.getNumeroEmpaquetado(contacto));
+    anexarTexto(carga, almacen.getNombre(contacto));
+    anexarTexto(carga, almacen.getApellido(contacto));
+    anexarTexto(carga, almacen.getEmail(contacto));
+    agregarEntrada(ENTRADA_ALTA, carga);
+}
+
+// Método para anotar un contacto modificado: sus datos anteriores y sus datos nuevos
+void DiarioCambios::registrarEdicion(string_view nombreAnterior, string_view apellidoAnterior, uint64_t numeroAnterior,
+                                     string_view emailAnterior, const AlmacenContactos &almacen, uint32_t contacto)
+{
+    vector<char> carga;
+    anexarEntero(carga, numeroAnterior);
+    anexarTexto(carga, nombreAnterior);
+    anexarTexto(carga, apellidoAnterior);
+    anexarTexto(carga, emailAnterior);
+    anexarEntero(carga, almacen.getNumeroEmpaquetado(contacto));
+    anexarTexto(carga, almacen.getNombre(contacto));
+    anexarTexto(carga, almacen.getApellido(contacto));
+    anexarTexto(carga, almacen.getEmail(contacto));
+    agregarEntrada(ENTRADA_EDICION_EXACTA, carga);
+}
+
+// Método para anotar un contacto eliminado (con todos sus datos, antes de liberar su registro)
+void DiarioCambios::registrarBaja(const AlmacenContactos &almacen, uint32_t contacto)
+{
+    vector<char> carga;
+    anexarEntero(carga, almacen.getNumeroEmpaquetado(contacto));
+    anexarTexto(carga, almacen.getNombre(contacto));
+    anexarTexto(carga, almacen.getApellido(contacto));
+    anexarTexto(carga, almacen.getEmail(contacto));
+    agregarEntrada(ENTRADA_BAJA_EXACTA, carga);
+}
+
+// Método para confirmar ya las entradas pendientes (sin esperar a que se llene el grupo)
+// Retorna cuántas entradas se confirmaron
+size_t DiarioCambios::confirmar()
+{
+    lock_guard<mutex> bloqueo(candado);
+    size_t confirmadas = entradasPendientes;
+    confirmarBloqueado();
+    return confirmadas;
+}
+
+// Función para recuperar la agenda al iniciar el programa
+uint64_t recuperarAgenda(AgendaContactos &agenda, bool comprimir)
+{
+    uint64_t secuenciaBase = 0;
+    bool cargadoBinario = false;
+    if (filesystem::exists("contactos.agdb"))
+    {
+        try
+        {
+            cargarInstantanea(agenda, "contactos.agdb", secuenciaBase);
+            cargadoBinario = true;
+        }
+        catch (const runtime_error &errorArchivo)
+        {
+            cout << "Excepción al cargar el archivo binario: " << errorArchivo.what() << endl;
+        }
+    }
+    if (!cargadoBinario)
+    {
+        cargarContactos(agenda, "contactos.txt");
+    }
+
+    uint64_t ultimaSecuencia = secuenciaBase;
+    size_t aplicadas = 0;
+    vector<string> diarios = listarSegmentosDiario("contactos.diario");
+    diarios.push_back("contactos.diario");
+    for (const string &rutaDiario : diarios)
+    {
+        if (!filesystem::exists(rutaDiario))
+        {
+            continue;
+        }
+        uint64_t bytesValidos = reproducirDiario(agenda, rutaDiario, secuenciaBase, ultimaSecuencia, aplicadas);
+
+        // Lo que sigue a la última entrada válida es un resto de un corte inesperado: se descarta
+        if (bytesValidos < filesystem::file_size(rutaDiario))
+        {
+            filesystem::resize_file(rutaDiario, bytesValidos);
+            cout << "Se descartó el final incompleto del diario " << rutaDiario << "." << endl;
+        }
+    }
+    if (aplicadas > 0)
+    {
+        cout << "Se recuperaron " << aplicadas << " cambios del diario." << endl;
+    }
+
+    // La compactación aplica el diario sobre el archivo binario, así que debe existir uno (y en el formato pedido)
+    bool estaComprimido = cargadoBinario && leerVersionInstantanea("contactos.agdb") == VERSION_INSTANTANEA_COMPRIMIDA;
+    if (!cargadoBinario || estaComprimido != comprimir)
+    {
+        guardarInstantanea(agenda, "contactos.agdb", ultimaSecuencia, comprimir);
+    }
+    return ultimaSecuencia;
+}
+
+// Función para armar la copia inmutable de la partición 'particion' de la agenda
+GrupoInmutable *copiarParticion(const AgendaContactos &agenda, size_t particion)
+{
+    const Particion &origen = agenda.particiones.getParticion(particion);
+    GrupoInmutable *copia = new GrupoInmutable();
+    copia->limiteInferior = origen.limiteInferior;
+    copia->claveLimite = origen.claveLimite;
+    size_t activos = 0;
+    size_t bytesDeCadenas = 0;
+    for (uint32_t contacto : origen.contactos)
+    {
+        if (agenda.almacen.estaActivo(contacto))
+        {
+            activos++;
+            bytesDeCadenas += agenda.almacen.getBytesCadenas(contacto);
+        }
+    }
+    copia->almacen.reservar(activos, bytesDeCadenas);
+    copia->contactos.reserve(activos);
+    copia->indiceTelefonos.reservar(activos);
+
+    // La partición ya está ordenada, así que el registro i del almacén nuevo es el contacto i del grupo
+    // (las lápidas no se copian). Los registros se copian tal cual, con su clave de orden ya calculada.
+    for (uint32_t contacto : origen.contactos)
+    {
+        if (agenda.almacen.estaActivo(contacto))
+        {
+            uint32_t nuevo = copia->almacen.agregarCopia(agenda.almacen, contacto);
+            copia->contactos.push_back(nuevo);
+            copia->indiceTelefonos.agregar(agenda.almacen.getNumeroEmpaquetado(contacto), nuevo);
+        }
+    }
+    return copia;
+}
+
+// Cantidad de entradas por fragmento del índice por número que se busca al elegir cuántos fragmentos usar
+constexpr size_t ENTRADAS_POR_FRAGMENTO = 256;
+
+// Función para calcular el fragmento del índice por número al que va un número ('cantidad' es una potencia de 2)
+// Usa los bits altos de un hash multiplicativo, así los números consecutivos quedan repartidos
+size_t calcularFragmentoTelefono(uint64_t numero, size_t cantidad)
+{
+    return static_cast<size_t>((numero * 0x9E3779B97F4A7C15ULL) >> 40) & (cantidad - 1);
+}
+
+// Entrada del índice por número mientras se arma una versión (el nombre apunta al almacén de un grupo)
+struct EntradaTelefono
+{
+    size_t fragmento;
+    uint64_t numero;
+    string_view nombre;
+
+    bool operator<(const EntradaTelefono &otra) const
+    {
+        if (fragmento != otra.fragmento)
+        {
+            return fragmento < otra.fragmento;
+        }
+        if (numero != otra.numero)
+        {
+            return numero < otra.numero;
+        }
+        return nombre < otra.nombre;
+    }
+};
+
+// Función para agregar a 'entradas' los números de los contactos de un grupo
+void juntarTelefonos(const GrupoInmutable &grupo, size_t cantidadFragmentos, vector<EntradaTelefono> &entradas)
+{
+    for (uint32_t contacto : grupo.contactos)
+    {
+        uint64_t numero = grupo.almacen.getNumeroEmpaquetado(contacto);
+        entradas.push_back(EntradaTelefono{calcularFragmentoTelefono(numero, cantidadFragmentos), numero,
+                                           grupo.almacen.getNombre(contacto)});
+    }
+}
+
+// Función para agregar a 'entradas' los números de los contactos de una versión que tienen un nombre
+void juntarTelefonosNombre(const VersionAgenda &version, const ClaveOrden &buscada, size_t cantidadFragmentos,
+                           vector<EntradaTelefono> &entradas)
+{
+    const GrupoInmutable &grupo = *version.grupos[ubicarEnVersion(version, buscada)];
+    auto posicion = lower_bound(grupo.contactos.begin(), grupo.contactos.end(), buscada,
+                                [&](uint32_t contacto, const ClaveOrden &clave)
+                                { return grupo.almacen.compararConClave(contacto, clave) < 0; });
+    for (; posicion != grupo.contactos.end() && grupo.almacen.compararConClave(*posicion, buscada) == 0; ++posicion)
+    {
+        uint64_t numero = grupo.almacen.getNumeroEmpaquetado(*posicion);
+        entradas.push_back(EntradaTelefono{calcularFragmentoTelefono(numero, cantidadFragmentos), numero,
+                                           grupo.almacen.getNombre(*posicion)});
+    }
+}
+
+// Función para armar un fragmento con las entradas de 'anterior' (si hay) sin las de [quitadas, finQuitadas) y
+// con las de [agregadas, finAgregadas)
+// Las tres listas están ordenadas por número y nombre, y las quitadas están todas en 'anterior'.
+FragmentoTelefonos *armarFragmento(const FragmentoTelefonos *anterior,
+                                   const EntradaTelefono *quitadas, const EntradaTelefono *finQuitadas,
+                                   const EntradaTelefono *agregadas, const EntradaTelefono *finAgregadas)
+{
+    FragmentoTelefonos *fragmento = new FragmentoTelefonos();
+    size_t cantidadAnterior = anterior == nullptr ? 0 : anterior->getCantidad();
+    size_t cantidad = cantidadAnterior - static_cast<size_t>(finQuitadas - quitadas) +
+                      static_cast<size_t>(finAgregadas - agregadas);
+    fragmento->numeros.reserve(cantidad);
+    fragmento->finNombres.reserve(cantidad);
+    auto agregar = [&](uint64_t numero, string_view nombre)
+    {
+        fragmento->numeros.push_back(numero);
+        fragmento->nombres.append(nombre);
+        fragmento->finNombres.push_back(static_cast<uint32_t>(fragmento->nombres.size()));
+    };
+
+    // Mezcla de listas ordenadas: en cada paso va la menor entrada entre la anterior y la agregada
+    for (size_t entrada = 0; entrada < cantidadAnterior; ++entrada)
+    {
+        uint64_t numero = anterior->numeros[entrada];
+        string_view nombre = anterior->getNombre(entrada);
+        while (agregadas != finAgregadas && (agregadas->numero < numero ||
+                                             (agregadas->numero == numero && agregadas->nombre < nombre)))
+        {
+            agregar(agregadas->numero, agregadas->nombre);
+            ++agregadas;
+        }
+        if (quitadas != finQuitadas && quitadas->numero == numero && quitadas->nombre == nombre)
+        {
+            ++quitadas;
+            continue;
+        }
+        agregar(numero, nombre);
+    }
+    for (; agregadas != finAgregadas; ++agregadas)
+    {
+        agregar(agregadas->numero, agregadas->nombre);
+    }
+    return fragmento;
+}
+
+// Función para armar todos los fragmentos del índice por número con los contactos de los grupos
+vector<const FragmentoTelefonos *> armarTelefonos(const vector<const GrupoInmutable *> &grupos,
+                                                  size_t cantidadFragmentos)
+{
+    vector<EntradaTelefono> entradas;
+    for (const GrupoInmutable *grupo : grupos)
+    {
+        juntarTelefonos(*grupo, cantidadFragmentos, entradas);
+    }
+    sort(entradas.begin(), entradas.end());
+    vector<const FragmentoTelefonos *> telefonos;
+    const EntradaTelefono *inicio = entradas.data();
+    const EntradaTelefono *fin = entradas.data() + entradas.size();
+    for (size_t fragmento = 0; fragmento < cantidadFragmentos; ++fragmento)
+    {
+        const EntradaTelefono *finFragmento = inicio;
+        while (finFragmento != fin && finFragmento->fragmento == fragmento)
+        {
+            ++finFragmento;
+        }
+        telefonos.push_back(armarFragmento(nullptr, nullptr, nullptr, inicio, finFragmento));
+        inicio = finFragmento;
+    }
+    return telefonos;
+}
+
+// Función para calcular los prefijos de los límites de los grupos de una versión (ver 'ubicarEnVersion')
+void calcularPrefijosLimite(VersionAgenda &version)
+{
+    version.prefijosLimite.reserve(version.grupos.size());
+    for (const GrupoInmutable *grupo : version.grupos)
+    {
+        version.prefijosLimite.push_back(calcularPrefijoClave(grupo->claveLimite));
+    }
+}
+
+// Constructor: publica la primera versión con una copia de todas las particiones de la agenda
+PublicadorVersiones::PublicadorVersiones(const AgendaContactos &agenda) : epocaGlobal(1)
+{
+    VersionAgenda *version = new VersionAgenda();
+    for (size_t particion = 0; particion < agenda.particiones.getCantidad(); ++particion)
+    {
+        version->grupos.push_back(copiarParticion(agenda, particion));
+    }
+
+    // La cantidad de fragmentos queda fija: con la agenda del arranque tienen unas 'ENTRADAS_POR_FRAGMENTO'
+    size_t cantidadFragmentos = 64;
+    while (cantidadFragmentos * ENTRADAS_POR_FRAGMENTO < agenda.almacen.getCantidad())
+    {
+        cantidadFragmentos *= 2;
+    }
+    calcularPrefijosLimite(*version);
+    version->telefonos = armarTelefonos(version->grupos, cantidadFragmentos);
+    version->numero = 1;
+    actual.store(version);
+}
+
+// Destructor: libera la versión actual y lo retirado (ya no debe quedar ningún lector)
+PublicadorVersiones::~PublicadorVersiones()
+{
+    for (const Retirado &retirado : retirados)
+    {
+        delete retirado.version;
+        delete retirado.grupo;
+        delete retirado.fragmento;
+    }
+    const VersionAgenda *version = actual.load();
+    for (const GrupoInmutable *grupo : version->grupos)
+    {
+        delete grupo;
+    }
+    for (const FragmentoTelefonos *fragmento : version->telefonos)
+    {
+        delete fragmento;
+    }
+    delete version;
+}
+
+// Método para que un hilo lector obtenga una ranura libre
+int PublicadorVersiones::registrarLector()
+{
+    for (size_t i = 0; i < MAXIMO_LECTORES; ++i)
+    {
+        bool libre = false;
+        if (ranuras[i].ocupada.compare_exchange_strong(libre, true))
+        {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+// Método para devolver la ranura de un lector que terminó
+void PublicadorVersiones::liberarLector(int ranura)
+{
+    ranuras[ranura].epoca.store(0);
+    ranuras[ranura].ocupada.store(false);
+}
+
+// Método para empezar a leer: anuncia la época y retorna la versión actual
+// El anuncio tiene que ser visible antes de leer el puntero (por eso ambos son secuencialmente consistentes):
+// así, si el lector obtuvo una versión que después se retira, quien la retira ve su anuncio.
+const VersionAgenda *PublicadorVersiones::entrar(int ranura)
+{
+    ranuras[ranura].epoca.store(epocaGlobal.load());
+    return actual.load();
+}
+
+// Método para terminar de leer: la versión obtenida en 'entrar' deja de ser válida
+void PublicadorVersiones::salir(int ranura)
+{
+    ranuras[ranura].epoca.store(0, memory_order_release);
+}
+
+// Método para publicar una versión nueva copiando de la agenda solo las particiones que cambiaron
+void PublicadorVersiones::publicar(const AgendaContactos &agenda, const vector<string> &nombresCambiados, bool todoCambio)
+{
+    const ParticionesContactos &particiones = agenda.particiones;
+    const VersionAgenda *anterior = actual.load();
+    vector<bool> cambiadas(particiones.getCantidad(), todoCambio);
+    for (const string &nombre : nombresCambiados)
+    {
+        cambiadas[particiones.ubicar(nombre)] = true;
+    }
+
+    // Un grupo de la versión anterior sirve para una partición sin cambios si cubre el mismo rango: el mismo
+    // límite inferior y el mismo límite siguiente (si la partición de al lado se dividió o se unió, no sirve).
+    // Los límites de las dos listas están ordenados, así que se recorren juntas.
+    VersionAgenda *nueva = new VersionAgenda();
+    nueva->numero = anterior->numero + 1;
+    nueva->grupos.reserve(particiones.getCantidad());
+    vector<bool> compartidos(anterior->grupos.size(), false);
+    size_t candidato = 0;
+    for (size_t particion = 0; particion < particiones.getCantidad(); ++particion)
+    {
+        const Particion &actualParticion = particiones.getParticion(particion);
+        while (candidato < anterior->grupos.size() &&
+               compararClaves(anterior->grupos[candidato]->claveLimite, anterior->grupos[candidato]->limiteInferior,
+                              actualParticion.claveLimite, actualParticion.limiteInferior) < 0)
+        {
+            ++candidato;
+        }
+        bool mismoRango = false;
+        if (!cambiadas[particion] && candidato < anterior->grupos.size() &&
+            anterior->grupos[candidato]->limiteInferior == actualParticion.limiteInferior)
+        {
+            bool ultimaAntes = candidato + 1 == anterior->grupos.size();
+            bool ultimaAhora = particion + 1 == particiones.getCantidad();
+            mismoRango = ultimaAntes == ultimaAhora &&
+                         (ultimaAhora || anterior->grupos[candidato + 1]->limiteInferior ==
+                                             particiones.getParticion(particion + 1).limiteInferior);
+        }
+        if (mismoRango)
+        {
+            nueva->grupos.push_back(anterior->grupos[candidato]);
+            compartidos[candidato] = true;
+        }
+        else
+        {
+            nueva->grupos.push_back(copiarParticion(agenda, particion));
+        }
+    }
+
+    calcularPrefijosLimite(*nueva);
+    vector<const GrupoInmutable *> reemplazados;
+    for (size_t grupo = 0; grupo < anterior->grupos.size(); ++grupo)
+    {
+        if (!compartidos[grupo])
+        {
+            reemplazados.push_back(anterior->grupos[grupo]);
+        }
+    }
+
+    // Solo pueden cambiar los números de los contactos con los nombres cambiados (los que solo pasaron a otro
+    // grupo porque se movió un límite conservan su número): se comparan los de cada nombre en las dos versiones
+    // y se arman de nuevo los fragmentos con algún número que cambió
+    size_t cantidadFragmentos = anterior->telefonos.size();
+    vector<const FragmentoTelefonos *> fragmentosReemplazados;
+    if (todoCambio)
+    {
+        nueva->telefonos = armarTelefonos(nueva->grupos, cantidadFragmentos);
+        fragmentosReemplazados = anterior->telefonos;
+    }
+    else
+    {
+        vector<string_view> nombres(nombresCambiados.begin(), nombresCambiados.end());
+        sort(nombres.begin(), nombres.end());
+        nombres.erase(unique(nombres.begin(), nombres.end()), nombres.end());
+        vector<EntradaTelefono> quitadas;
+        vector<EntradaTelefono> agregadas;
+        vector<EntradaTelefono> antes;
+        vector<EntradaTelefono> despues;
+        for (string_view nombre : nombres)
+        {
+            if (calcularLetraInicial(nombre) < 0)
+            {
+                continue; // No se pudo registrar
+            }
+            ClaveOrden buscada(nombre);
+            antes.clear();
+            despues.clear();
+            juntarTelefonosNombre(*anterior, buscada, cantidadFragmentos, antes);
+            juntarTelefonosNombre(*nueva, buscada, cantidadFragmentos, despues);
+            sort(antes.begin(), antes.end());
+            sort(despues.begin(), despues.end());
+            set_difference(antes.begin(), antes.end(), despues.begin(), despues.end(), back_inserter(quitadas));
+            set_difference(despues.begin(), despues.end(), antes.begin(), antes.end(), back_inserter(agregadas));
+        }
+        sort(quitadas.begin(), quitadas.end());
+        sort(agregadas.begin(), agregadas.end());
+
+        nueva->telefonos = anterior->telefonos;
+        const EntradaTelefono *quitada = quitadas.data();
+        const EntradaTelefono *finQuitadas = quitadas.data() + quitadas.size();
+        const EntradaTelefono *agregada = agregadas.data();
+        const EntradaTelefono *finAgregadas = agregadas.data() + agregadas.size();
+        while (quitada != finQuitadas || agregada != finAgregadas)
+        {
+            size_t fragmento = min(quitada != finQuitadas ? quitada->fragmento : cantidadFragmentos,
+                                   agregada != finAgregadas ? agregada->fragmento : cantidadFragmentos);
+            const EntradaTelefono *finQuitadasFragmento = quitada;
+            while (finQuitadasFragmento != finQuitadas && finQuitadasFragmento->fragmento == fragmento)
+            {
+                ++finQuitadasFragmento;
+            }
+            const EntradaTelefono *finAgregadasFragmento = agregada;
+            while (finAgregadasFragmento != finAgregadas && finAgregadasFragmento->fragmento == fragmento)
+            {
+                ++finAgregadasFragmento;
+            }
+            fragmentosReemplazados.push_back(anterior->telefonos[fragmento]);
+            nueva->telefonos[fragmento] = armarFragmento(anterior->telefonos[fragmento], quitada, finQuitadasFragmento,
+                                                         agregada, finAgregadasFragmento);
+            quitada = finQuitadasFragmento;
+            agregada = finAgregadasFragmento;
+        }
+    }
+
+    // Después del cambio de puntero, los lectores que entren ya no pueden obtener la versión anterior
+    actual.store(nueva);
+    uint64_t epoca = epocaGlobal.fetch_add(1);
+    retirados.push_back(Retirado{epoca, anterior, nullptr, nullptr});
+    for (const GrupoInmutable *grupo : reemplazados)
+    {
+        retirados.push_back(Retirado{epoca, nullptr, grupo, nullptr});
+    }
+    for (const FragmentoTelefonos *fragmento : fragmentosReemplazados)
+    {
+        retirados.push_back(Retirado{epoca, nullptr, nullptr, fragmento});
+    }
+    liberarRetirados();
+}
+
+// Método para liberar lo retirado que ya ningún lector puede estar usando
+// Un lector que entró en la época 'e' puede tener lo retirado en las épocas 'e' o posteriores, así que se
+// libera lo que se retiró antes de la menor época anunciada
+void PublicadorVersiones::liberarRetirados()
+{
+    uint64_t menorEpoca = numeric_limits<uint64_t>::max();
+    for (const RanuraLector &ranura : ranuras)
+    {
+        uint64_t epoca = ranura.epoca.load();
+        if (epoca != 0)
+        {
+            menorEpoca = min(menorEpoca, epoca);
+        }
+    }
+
+    size_t conservados = 0;
+    for (const Retirado &retirado : retirados)
+    {
+        if (retirado.epoca < menorEpoca)
+        {
+            delete retirado.version;
+            delete retirado.grupo;
+            delete retirado.fragmento;
+        }
+        else
+        {
+            retirados[conservados++] = retirado;
+        }
+    }
+    retirados.resize(conservados);
+}
+
+// Función para ubicar el grupo de una versión publicada cuyo rango contiene un nombre
+size_t ubicarEnVersion(const VersionAgenda &version, const ClaveOrden &buscada)
+{
+    // Los prefijos de los límites están juntos en memoria: con ellos se descartan casi todos los grupos sin
+    // leerlos, y solo los que tienen el mismo prefijo que el nombre se comparan completos
+    auto inicioPrefijos = version.prefijosLimite.begin();
+    auto primero = lower_bound(inicioPrefijos + 1, version.prefijosLimite.end(), buscada.prefijo);
+    auto ultimo = upper_bound(primero, version.prefijosLimite.end(), buscada.prefijo);
+
+    // El primer grupo con un límite mayor que el nombre es el siguiente al buscado (ver 'ParticionesContactos::ubicar')
+    auto siguiente = partition_point(version.grupos.begin() + (primero - inicioPrefijos),
+                                     version.grupos.begin() + (ultimo - inicioPrefijos), [&](const GrupoInmutable *grupo)
+                                     { return compararClaves(buscada.clave, buscada.nombre, grupo->claveLimite,
+                                                             grupo->limiteInferior) >= 0; });
+    return static_cast<size_t>(siguiente - version.grupos.begin()) - 1;
+}
+
+// Función para buscar un contacto por su nombre exacto en una versión publicada
+bool buscarEnVersion(const VersionAgenda &version, string_view nombre, const GrupoInmutable *&grupo, uint32_t &contacto)
+{
+    if (calcularLetraInicial(nombre) < 0)
+    {
+        return false;
+    }
+    ClaveOrden buscada(nombre);
+    grupo = version.grupos[ubicarEnVersion(version, buscada)];
+    int posicion;
+    if (!busquedaBinaria(grupo->almacen, grupo->contactos, buscada, posicion))
+    {
+        return false;
+    }
+    contacto = grupo->contactos[posicion];
+    return true;
+}
+
+// Función para buscar un contacto por su número de celular en una versión publicada
+bool buscarNumeroEnVersion(const VersionAgenda &version, uint64_t numero, const GrupoInmutable *&grupo, uint32_t &contacto)
+{
+    size_t fragmentoNumero = calcularFragmentoTelefono(numero, version.telefonos.size());
+    const FragmentoTelefonos &fragmento = *version.telefonos[fragmentoNumero];
+    size_t entrada = static_cast<size_t>(lower_bound(fragmento.numeros.begin(), fragmento.numeros.end(), numero) -
+                                         fragmento.numeros.begin());
+    for (; entrada < fragmento.getCantidad() && fragmento.numeros[entrada] == numero; ++entrada)
+    {
+        // El contacto está en el grupo de su nombre
+        ClaveOrden buscada(fragmento.getNombre(entrada));
+        const GrupoInmutable *candidato = version.grupos[ubicarEnVersion(version, buscada)];
+        if (candidato->indiceTelefonos.buscar(candidato->almacen, numero, contacto))
+        {
+            grupo = candidato;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ALMACENAMIENTO EN DISCO (MODO FUERA DE MEMORIA)
+
+// Constructor: abre (o crea vacío) el archivo y reserva los marcos del búfer
+BuferPaginas::BuferPaginas(const string &ruta, size_t bytesMemoria, bool crear)
+    : ruta(ruta), descriptor(-1), manecilla(0), lecturas(0), escrituras(0)
+{
+#ifndef _WIN32
+    descriptor = open(ruta.c_str(), O_RDWR | (crear ? O_CREAT | O_TRUNC : 0), 0644);
+#else
+    descriptor = _open(ruta.c_str(), _O_RDWR | _O_BINARY | (crear ? _O_CREAT | _O_TRUNC : 0), _S_IREAD | _S_IWRITE);
+#endif
+    if (descriptor < 0)
+    {
+        throw runtime_error("No se pudo abrir el archivo " + ruta + ".");
+    }
+    uint64_t tamano = filesystem::file_size(ruta);
+    if (tamano % TAMANO_PAGINA != 0 || tamano / TAMANO_PAGINA >= PAGINA_NINGUNA)
+    {
+#ifndef _WIN32
+        close(descriptor);
+#else
+        _close(descriptor);
+#endif
+        throw runtime_error("El archivo " + ruta + " no tiene un tamaño válido.");
+    }
+
+    // Hacen falta al menos los marcos de un camino de la raíz a una hoja y los de las divisiones que provoca
+    size_t cantidadMarcos = max<size_t>(64, bytesMemoria / TAMANO_PAGINA);
+    memoria.resize(cantidadMarcos * TAMANO_PAGINA);
+    paginaDelMarco.assign(cantidadMarcos, PAGINA_NINGUNA);
+    fijaciones.assign(cantidadMarcos, 0);
+    usado.assign(cantidadMarcos, 0);
+    modificado.assign(cantidadMarcos, 0);
+    marcoDePagina.assign(tamano / TAMANO_PAGINA, PAGINA_NINGUNA);
+}
+
+// Destructor: cierra el archivo (las páginas modificadas que no se escribieron con 'vaciar' se pierden)
+BuferPaginas::~BuferPaginas()
+{
+#ifndef _WIN32
+    close(descriptor);
+#else
+    _close(descriptor);
+#endif
+}
+
+// Método para leer una página del archivo (lo que esté más allá del final se lee como ceros)
+void BuferPaginas::leerPagina(uint32_t pagina, char *destino)
+{
+    uint64_t posicion = static_cast<uint64_t>(pagina) * TAMANO_PAGINA;
+    size_t leidos = 0;
+    while (leidos < TAMANO_PAGINA)
+    {
+#ifndef _WIN32
+        ssize_t resultado = pread(descriptor, destino + leidos, TAMANO_PAGINA - leidos, static_cast<off_t>(posicion + leidos));
+        if (resultado < 0 && errno == EINTR)
+        {
+            continue;
+        }
+#else
+        _lseeki64(descriptor, static_cast<__int64>(posicion + leidos), SEEK_SET);
+        int resultado = _read(descriptor, destino + leidos, static_cast<unsigned>(TAMANO_PAGINA - leidos));
+#endif
+        if (resultado < 0)
+        {
+            throw runtime_error("No se pudo leer el archivo " + ruta + ".");
+        }
+        if (resultado == 0)
+        {
+            memset(destino + leidos, 0, TAMANO_PAGINA - leidos);
+            break;
+        }
+        leidos += static_cast<size_t>(resultado);
+    }
+    lecturas++;
+}
+
+// Método para escribir una página en su lugar del archivo
+void BuferPaginas::escribirPagina(uint32_t pagina, const char *origen)
+{
+    uint64_t posicion = static_cast<uint64_t>(pagina) * TAMANO_PAGINA;
+    size_t escritos = 0;
+    while (escritos < TAMANO_PAGINA)
+    {
+#ifndef _WIN32
+        ssize_t resultado = pwrite(descriptor, origen + escritos, TAMANO_PAGINA - escritos, static_cast<off_t>(posicion + escritos));
+        if (resultado < 0 && errno == EINTR)
+        {
+            continue;
+        }
+#else
+        _lseeki64(descriptor, static_cast<__int64>(posicion + escritos), SEEK_SET);
+        int resultado = _write(descriptor, origen + escritos, static_cast<unsigned>(TAMANO_PAGINA - escritos));
+#endif
+        if (resultado <= 0)
+        {
+            throw runtime_error("No se pudo escribir el archivo " + ruta + ".");
+        }
+        escritos += static_cast<size_t>(resultado);
+    }
+    escrituras++;
+    contarBytesEscritos(TAMANO_PAGINA);
+}
+
+// Método para conseguir un marco libre, reemplazando una página con el algoritmo del reloj si hace falta
+uint32_t BuferPaginas::conseguirMarco()
+{
+    size_t cantidadMarcos = paginaDelMarco.size();
+    // En la primera vuelta la manecilla quita las marcas, así que en la segunda encuentra un marco sin fijar
+    for (size_t paso = 0; paso <= 2 * cantidadMarcos; ++paso)
+    {
+        uint32_t marco = manecilla;
+        manecilla = static_cast<uint32_t>((manecilla + 1) % cantidadMarcos);
+        if (fijaciones[marco] > 0)
+        {
+            continue;
+        }
+        if (usado[marco])
+        {
+            usado[marco] = 0;
+            continue;
+        }
+        uint32_t pagina = paginaDelMarco[marco];
+        if (pagina != PAGINA_NINGUNA)
+        {
+            if (modificado[marco])
+            {
+                escribirPagina(pagina, &memoria[static_cast<size_t>(marco) * TAMANO_PAGINA]);
+                modificado[marco] = 0;
+            }
+            marcoDePagina[pagina] = PAGINA_NINGUNA;
+            paginaDelMarco[marco] = PAGINA_NINGUNA;
+        }
+        return marco;
+    }
+    throw runtime_error("Todas las páginas del búfer están fijadas.");
+}
+
+// Método para fijar una página: mientras esté fijada no sale del búfer
+char *BuferPaginas::fijar(uint32_t pagina)
+{
+    if (pagina >= marcoDePagina.size())
+    {
+        throw runtime_error("El archivo " + ruta + " está dañado (página fuera del archivo).");
+    }
+    uint32_t marco = marcoDePagina[pagina];
+    if (marco == PAGINA_NINGUNA)
+    {
+        marco = conseguirMarco();
+        leerPagina(pagina, &memoria[static_cast<size_t>(marco) * TAMANO_PAGINA]);
+        paginaDelMarco[marco] = pagina;
+        marcoDePagina[pagina] = marco;
+    }
+    fijaciones[marco]++;
+    usado[marco] = 1;
+    return &memoria[static_cast<size_t>(marco) * TAMANO_PAGINA];
+}
+
+// Método para soltar una página fijada
+void BuferPaginas::soltar(uint32_t pagina, bool modificada)
+{
+    uint32_t marco = marcoDePagina[pagina];
+    fijaciones[marco]--;
+    if (modificada)
+    {
+        modificado[marco] = 1;
+    }
+}
+
+// Método para agregar una página en cero al final del archivo
+// Se escribe en el disco recién cuando sale del búfer o con 'vaciar'
+uint32_t BuferPaginas::agregarPagina()
+{
+    if (marcoDePagina.size() + 1 >= PAGINA_NINGUNA)
+    {
+        throw runtime_error("El archivo " + ruta + " llegó a su cantidad máxima de páginas.");
+    }
+    uint32_t marco = conseguirMarco();
+    uint32_t pagina = static_cast<uint32_t>(marcoDePagina.size());
+    memset(&memoria[static_cast<size_t>(marco) * TAMANO_PAGINA], 0, TAMANO_PAGINA);
+    paginaDelMarco[marco] = pagina;
+    marcoDePagina.push_back(marco);
+    usado[marco] = 1;
+    modificado[marco] = 1;
+    return pagina;
+}
+
+// Método para escribir todas las páginas modificadas y sincronizar el archivo con el disco
+void BuferPaginas::vaciar()
+{
+    // Se escriben en el orden del archivo, así el disco las recibe lo más seguidas posible
+    vector<uint32_t> marcos;
+    for (uint32_t marco = 0; marco < paginaDelMarco.size(); ++marco)
+    {
+        if (modificado[marco])
+        {
+            marcos.push_back(marco);
+        }
+    }
+    sort(marcos.begin(), marcos.end(), [&](uint32_t a, uint32_t b)
+         { return paginaDelMarco[a] < paginaDelMarco[b]; });
+    for (uint32_t marco : marcos)
+    {
+        escribirPagina(paginaDelMarco[marco], &memoria[static_cast<size_t>(marco) * TAMANO_PAGINA]);
+        modificado[marco] = 0;
+    }
+#ifndef _WIN32
+    fsync(descriptor);
+#else
+    _commit(descriptor);
+#endif
+}
+
+// Cabecera del archivo del árbol en disco ("contactos.arbol"), al comienzo de la página 0
+struct CabeceraArbol
+{
+    char magia[4];              // "AGBT"
+    uint32_t version;           // Versión del formato
+    uint32_t tamanoPagina;      // Siempre TAMANO_PAGINA
+    uint32_t raiz;              // Página de la raíz
+    uint32_t altura;            // Cantidad de niveles (1 si la raíz es una hoja)
+    uint32_t cerradoBien;       // 0 desde el primer cambio hasta que se guarda
+    uint64_t cantidadContactos; // Cantidad de contactos guardados
+};
+
+const char MAGIA_ARBOL[4] = {'A', 'G', 'B', 'T'};
+
+// Versión 2: las entradas llevan el número de copia (en la 1 no podía haber dos contactos con el mismo nombre y número)
+const uint32_t VERSION_ARBOL = 2;
+
+// Cabecera de cada página del árbol (al comienzo de la página)
+// Después vienen las ranuras: la posición (16 bits) de cada entrada dentro de la página, en el orden de las
+// entradas. Las entradas se guardan desde el final de la página hacia atrás, así las ranuras y las entradas
+// crecen una hacia la otra y el espacio libre queda en medio.
+// Entrada de una hoja: el número empaquetado (64 bits), la longitud del nombre (16 bits), la copia (16 bits),
+// las longitudes del apellido y el email (16 bits cada una) y los tres textos. Entrada interna: el número
+// (64 bits), la longitud del nombre (16 bits), la copia (16 bits), la página hija (32 bits) y el nombre. La hija
+// tiene los contactos desde ese nombre, número y copia hasta la entrada siguiente.
+// La copia distingue a los contactos con el mismo nombre y número: el primero es la 0, el siguiente la 1, etc.
+struct CabeceraPagina
+{
+    uint16_t hoja;           // 1 si es una hoja, 0 si es una página interna
+    uint16_t cantidad;       // Cantidad de entradas
+    uint16_t inicioEntradas; // Posición de la entrada guardada más atrás (TAMANO_PAGINA si no hay ninguna)
+    uint16_t bytesSueltos;   // Bytes de entradas quitadas que siguen ocupando lugar (se recuperan al compactar)
+    uint32_t enlace;         // Hoja: la hoja siguiente. Interna: la hija con los contactos anteriores a la primera entrada
+    uint32_t reservado;
+};
+
+static_assert(sizeof(CabeceraPagina) == 16, "La cabecera de una página del árbol debe ocupar 16 bytes");
+
+// Tamaño de la parte fija de una entrada (número, copia y longitudes, o número, longitud, copia y página hija)
+const size_t CABECERA_ENTRADA = 16;
+
+// Mayor número de copia: no puede haber más de 65536 contactos con el mismo nombre y el mismo número
+const uint16_t COPIA_MAXIMA = numeric_limits<uint16_t>::max();
+
+// Tamaño máximo de una entrada: así una página siempre tiene lugar para al menos cuatro
+const size_t MAXIMO_ENTRADA = (TAMANO_PAGINA - sizeof(CabeceraPagina)) / 4 - sizeof(uint16_t);
+
+// Parte de cada página que se llena al importar (el resto queda para los contactos que se agreguen después)
+const size_t LLENADO_IMPORTACION = TAMANO_PAGINA * 9 / 10;
+
+// Funciones para acceder a la cabecera y a las ranuras de una página del árbol
+CabeceraPagina *leerCabeceraPagina(char *pagina) { return reinterpret_cast<CabeceraPagina *>(pagina); }
+const CabeceraPagina *leerCabeceraPagina(const char *pagina) { return reinterpret_cast<const CabeceraPagina *>(pagina); }
+uint16_t *leerRanuras(char *pagina) { return reinterpret_cast<uint16_t *>(pagina + sizeof(CabeceraPagina)); }
+const uint16_t *leerRanuras(const char *pagina) { return reinterpret_cast<const uint16_t *>(pagina + sizeof(CabeceraPagina)); }
+
+// Función para dejar una página vacía
+void iniciarPagina(char *pagina, bool hoja, uint32_t enlace)
+{
+    CabeceraPagina *cabecera = leerCabeceraPagina(pagina);
+    cabecera->hoja = hoja ? 1 : 0;
+    cabecera->cantidad = 0;
+    cabecera->inicioEntradas = static_cast<uint16_t>(TAMANO_PAGINA);
+    cabecera->bytesSueltos = 0;
+    cabecera->enlace = enlace;
+    cabecera->reservado = 0;
+}
+
+// Función para obtener dónde comienza la entrada 'indice' de una página
+const char *leerEntrada(const char *pagina, size_t indice) { return pagina + leerRanuras(pagina)[indice]; }
+
+// Función para leer un entero de 16 bits de una entrada (las entradas no están alineadas)
+uint16_t leerLongitud(const char *posicion)
+{
+    uint16_t longitud;
+    memcpy(&longitud, posicion, sizeof(longitud));
+    return longitud;
+}
+
+// Funciones para leer el número, el nombre y la copia de una entrada (están en el mismo lugar en las hojas y en
+// las internas)
+uint64_t leerNumeroEntrada(const char *entrada)
+{
+    uint64_t numero;
+    memcpy(&numero, entrada, sizeof(numero));
+    return numero;
+}
+
+string_view leerNombreEntrada(const char *entrada)
+{
+    return string_view(entrada + CABECERA_ENTRADA, leerLongitud(entrada + 8));
+}
+
+uint16_t leerCopiaEntrada(const char *entrada) { return leerLongitud(entrada + 10); }
+
+// Función para leer la página hija de una entrada interna
+uint32_t leerHijaEntrada(const char *entrada)
+{
+    uint32_t hija;
+    memcpy(&hija, entrada + 12, sizeof(hija));
+    return hija;
+}
+
+// Función para medir una entrada
+size_t medirEntrada(const char *entrada, bool hoja)
+{
+    if (!hoja)
+    {
+        return CABECERA_ENTRADA + leerLongitud(entrada + 8);
+    }
+    return CABECERA_ENTRADA + leerLongitud(entrada + 8) + leerLongitud(entrada + 12) + leerLongitud(entrada + 14);
+}
+
+// Función para armar la entrada de una hoja
+void armarEntradaHoja(vector<char> &entrada, string_view nombre, string_view apellido, uint64_t numero, uint16_t copia,
+                      string_view email)
+{
+    entrada.resize(CABECERA_ENTRADA + nombre.size() + apellido.size() + email.size());
+    uint16_t longitudes[4] = {static_cast<uint16_t>(nombre.size()), copia, static_cast<uint16_t>(apellido.size()),
+                              static_cast<uint16_t>(email.size())};
+    memcpy(entrada.data(), &numero, sizeof(numero));
+    memcpy(entrada.data() + 8, longitudes, sizeof(longitudes));
+    char *cursor = entrada.data() + CABECERA_ENTRADA;
+    for (string_view texto : {nombre, apellido, email})
+    {
+        memcpy(cursor, texto.data(), texto.size());
+        cursor += texto.size();
+    }
+}
+
+// Función para armar una entrada interna
+void armarEntradaInterna(vector<char> &entrada, string_view nombre, uint64_t numero, uint16_t copia, uint32_t hija)
+{
+    entrada.resize(CABECERA_ENTRADA + nombre.size());
+    uint16_t longitud = static_cast<uint16_t>(nombre.size());
+    memcpy(entrada.data(), &numero, sizeof(numero));
+    memcpy(entrada.data() + 8, &longitud, sizeof(longitud));
+    memcpy(entrada.data() + 10, &copia, sizeof(copia));
+    memcpy(entrada.data() + 12, &hija, sizeof(hija));
+    memcpy(entrada.data() + CABECERA_ENTRADA, nombre.data(), nombre.size());
+}
+
+// Función para comparar la entrada 'indice' de una página con un nombre, un número y una copia
+// Retorna un número negativo si la entrada va antes, 0 si es esa misma y positivo si va después
+int compararConEntrada(const char *pagina, size_t indice, string_view nombre, uint64_t numero, uint16_t copia)
+{
+    const char *entrada = leerEntrada(pagina, indice);
+    int comparacion = compararNombres(leerNombreEntrada(entrada), nombre);
+    if (comparacion != 0)
+    {
+        return comparacion;
+    }
+    uint64_t numeroEntrada = leerNumeroEntrada(entrada);
+    if (numeroEntrada != numero)
+    {
+        return numeroEntrada < numero ? -1 : 1;
+    }
+    uint16_t copiaEntrada = leerCopiaEntrada(entrada);
+    return copiaEntrada < copia ? -1 : (copiaEntrada > copia ? 1 : 0);
+}
+
+// Función para buscar en una página la posición de la primera entrada que no va antes de un nombre, un número
+// y una copia
+size_t buscarEnPagina(const char *pagina, string_view nombre, uint64_t numero, uint16_t copia)
+{
+    size_t inicioRango = 0, finRango = leerCabeceraPagina(pagina)->cantidad;
+    while (inicioRango < finRango)
+    {
+        size_t indiceMedio = inicioRango + (finRango - inicioRango) / 2;
+        if (compararConEntrada(pagina, indiceMedio, nombre, numero, copia) < 0)
+        {
+            inicioRango = indiceMedio + 1;
+        }
+        else
+        {
+            finRango = indiceMedio;
+        }
+    }
+    return inicioRango;
+}
+
+// Función para juntar las entradas de una página al final, recuperando el lugar de las que se quitaron
+void compactarPagina(char *pagina)
+{
+    CabeceraPagina *cabecera = leerCabeceraPagina(pagina);
+    uint16_t *ranuras = leerRanuras(pagina);
+    bool hoja = cabecera->hoja != 0;
+    char copia[TAMANO_PAGINA];
+    memcpy(copia, pagina, TAMANO_PAGINA);
+    size_t inicio = TAMANO_PAGINA;
+    for (size_t i = 0; i < cabecera->cantidad; ++i)
+    {
+        const char *entrada = copia + ranuras[i];
+        size_t tamano = medirEntrada(entrada, hoja);
+        inicio -= tamano;
+        memcpy(pagina + inicio, entrada, tamano);
+        ranuras[i] = static_cast<uint16_t>(inicio);
+    }
+    cabecera->inicioEntradas = static_cast<uint16_t>(inicio);
+    cabecera->bytesSueltos = 0;
+}
+
+// Función para insertar una entrada en la posición 'posicion' de una página
+// Retorna 'false' (sin cambiar la página) si con ella la página ocuparía más de 'limite' bytes
+bool insertarEnPagina(char *pagina, size_t posicion, const char *entrada, size_t tamano, size_t limite)
+{
+    CabeceraPagina *cabecera = leerCabeceraPagina(pagina);
+    size_t ocupados = sizeof(CabeceraPagina) + cabecera->cantidad * sizeof(uint16_t) +
+                      (TAMANO_PAGINA - cabecera->inicioEntradas - cabecera->bytesSueltos);
+    if (ocupados + tamano + sizeof(uint16_t) > limite)
+    {
+        return false;
+    }
+    // Si el lugar libre del medio no alcanza, alcanza juntando las entradas
+    size_t finRanuras = sizeof(CabeceraPagina) + (cabecera->cantidad + 1) * sizeof(uint16_t);
+    if (finRanuras + tamano > cabecera->inicioEntradas)
+    {
+        compactarPagina(pagina);
+    }
+    cabecera->inicioEntradas = static_cast<uint16_t>(cabecera->inicioEntradas - tamano);
+    memcpy(pagina + cabecera->inicioEntradas, entrada, tamano);
+    uint16_t *ranuras = leerRanuras(pagina);
+    memmove(ranuras + posicion + 1, ranuras + posicion, (cabecera->cantidad - posicion) * sizeof(uint16_t));
+    ranuras[posicion] = cabecera->inicioEntradas;
+    cabecera->cantidad++;
+    return true;
+}
+
+// Función para quitar la entrada 'posicion' de una página (su lugar queda suelto hasta que se compacte)
+void quitarDePagina(char *pagina, size_t posicion)
+{
+    CabeceraPagina *cabecera = leerCabeceraPagina(pagina);
+    uint16_t *ranuras = leerRanuras(pagina);
+    size_t tamano = medirEntrada(pagina + ranuras[posicion], cabecera->hoja != 0);
+    if (ranuras[posicion] == cabecera->inicioEntradas)
+    {
+        cabecera->inicioEntradas = static_cast<uint16_t>(cabecera->inicioEntradas + tamano);
+    }
+    else
+    {
+        cabecera->bytesSueltos = static_cast<uint16_t>(cabecera->bytesSueltos + tamano);
+    }
+    memmove(ranuras + posicion, ranuras + posicion + 1, (cabecera->cantidad - posicion - 1) * sizeof(uint16_t));
+    cabecera->cantidad--;
+}
+
+// Función para repartir las entradas de una página llena, más una nueva en 'posicion', entre ella y una página
+// nueva ('nueva', que es la página 'numeroNueva' del archivo y se pone a su derecha)
+// Cada una se queda con cerca de la mitad de los bytes. En 'separador' deja la entrada interna que hay que
+// insertar en el padre para llegar a la página nueva: en una hoja es el nombre y número de su primer contacto;
+// en una página interna la entrada del corte sube al padre y su hija pasa a ser el enlace de la página nueva.
+void dividirPagina(char *pagina, char *nueva, uint32_t numeroNueva, size_t posicion, const char *entrada,
+                   size_t tamano, vector<char> &separador)
+{
+    const CabeceraPagina *cabecera = leerCabeceraPagina(pagina);
+    bool hoja = cabecera->hoja != 0;
+    uint32_t enlace = cabecera->enlace;
+
+    // Copia de las entradas en orden, con la nueva en su lugar
+    char copia[TAMANO_PAGINA];
+    memcpy(copia, pagina, TAMANO_PAGINA);
+    vector<pair<const char *, size_t>> entradas;
+    size_t total = 0;
+    for (size_t i = 0; i <= cabecera->cantidad; ++i)
+    {
+        if (i == posicion)
+        {
+            entradas.push_back({entrada, tamano});
+            total += tamano;
+        }
+        if (i < cabecera->cantidad)
+        {
+            const char *actual = leerEntrada(copia, i);
+            entradas.push_back({actual, medirEntrada(actual, hoja)});
+            total += entradas.back().second;
+        }
+    }
+
+    // El corte es la primera entrada que deja a la izquierda al menos la mitad de los bytes
+    size_t corte = 1, izquierda = entradas[0].second;
+    while (corte + 1 < entradas.size() && izquierda + entradas[corte].second <= total / 2)
+    {
+        izquierda += entradas[corte].second;
+        corte++;
+    }
+
+    const char *primera = entradas[corte].first;
+    if (hoja)
+    {
+        iniciarPagina(pagina, true, numeroNueva);
+        iniciarPagina(nueva, true, enlace);
+        armarEntradaInterna(separador, leerNombreEntrada(primera), leerNumeroEntrada(primera), leerCopiaEntrada(primera),
+                            numeroNueva);
+    }
+    else
+    {
+        iniciarPagina(pagina, false, enlace);
+        iniciarPagina(nueva, false, leerHijaEntrada(primera));
+        separador.assign(primera, primera + entradas[corte].second);
+        memcpy(separador.data() + 12, &numeroNueva, sizeof(numeroNueva));
+    }
+    for (size_t i = 0; i < entradas.size(); ++i)
+    {
+        if (i < corte)
+        {
+            insertarEnPagina(pagina, i, entradas[i].first, entradas[i].second, TAMANO_PAGINA);
+        }
+        else if (i > corte || hoja)
+        {
+            insertarEnPagina(nueva, leerCabeceraPagina(nueva)->cantidad, entradas[i].first, entradas[i].second, TAMANO_PAGINA);
+        }
+    }
+}
+
+// Función para escribir la cabecera del archivo del árbol en su página 0
+void escribirCabeceraArbol(BuferPaginas &bufer, uint32_t raiz, uint32_t altura, uint64_t cantidad, bool cerradoBien)
+{
+    CabeceraArbol cabecera = {};
+    memcpy(cabecera.magia, MAGIA_ARBOL, sizeof(cabecera.magia));
+    cabecera.version = VERSION_ARBOL;
+    cabecera.tamanoPagina = static_cast<uint32_t>(TAMANO_PAGINA);
+    cabecera.raiz = raiz;
+    cabecera.altura = altura;
+    cabecera.cerradoBien = cerradoBien ? 1 : 0;
+    cabecera.cantidadContactos = cantidad;
+    PaginaFijada pagina(bufer, 0);
+    memcpy(pagina.modificar(), &cabecera, sizeof(cabecera));
+}
+
+// Constructor: abre el árbol y lee sus páginas internas
+ArbolContactos::ArbolContactos(const string &ruta, size_t bytesMemoria) : bufer(ruta, bytesMemoria, false)
+{
+    if (bufer.getCantidadPaginas() == 0)
+    {
+        throw runtime_error("El archivo " + ruta + " está vacío.");
+    }
+    CabeceraArbol cabecera;
+    {
+        PaginaFijada pagina(bufer, 0);
+        memcpy(&cabecera, pagina.getDatos(), sizeof(cabecera));
+    }
+    if (memcmp(cabecera.magia, MAGIA_ARBOL, sizeof(cabecera.magia)) != 0 || cabecera.tamanoPagina != TAMANO_PAGINA)
+    {
+        throw runtime_error("El archivo " + ruta + " no es un árbol de contactos.");
+    }
+    if (cabecera.version != VERSION_ARBOL)
+    {
+        throw runtime_error("El archivo " + ruta + " es de una versión anterior del árbol; hay que volver a importarlo.");
+    }
+    if (cabecera.cerradoBien != 1)
+    {
+        throw runtime_error("El archivo " + ruta + " no se cerró bien; hay que volver a importarlo.");
+    }
+    raiz = cabecera.raiz;
+    altura = cabecera.altura;
+    cantidad = cabecera.cantidadContactos;
+    cerradoBien = true;
+    precargarInternas();
+}
+
+// Destructor: guarda los cambios pendientes
+ArbolContactos::~ArbolContactos()
+{
+    try
+    {
+        guardar();
+    }
+    catch (const exception &error)
+    {
+        cerr << "Excepción al guardar el árbol de contactos: " << error.what() << endl;
+    }
+}
+
+// Método para escribir la cabecera del árbol con su estado actual
+void ArbolContactos::escribirCabecera()
+{
+    escribirCabeceraArbol(bufer, raiz, altura, cantidad, cerradoBien);
+}
+
+// Método para marcar el archivo como abierto antes del primer cambio desde que se guardó
+// La marca se escribe y sincroniza antes que cualquier página cambiada
+void ArbolContactos::marcarAbierto()
+{
+    if (cerradoBien)
+    {
+        cerradoBien = false;
+        escribirCabecera();
+        bufer.vaciar();
+    }
+}
+
+// Método para leer las páginas internas nivel por nivel, mientras ocupen a lo sumo la mitad del búfer
+// Así quedan en el búfer desde el comienzo y cada búsqueda lee del disco solo su hoja
+void ArbolContactos::precargarInternas()
+{
+    vector<uint32_t> nivel = {raiz}, siguiente;
+    size_t leidas = 0;
+    for (uint32_t profundidad = 1; profundidad < altura; ++profundidad)
+    {
+        if (leidas + nivel.size() > bufer.getCantidadMarcos() / 2)
+        {
+            break;
+        }
+        leidas += nivel.size();
+        sort(nivel.begin(), nivel.end());
+        siguiente.clear();
+        for (uint32_t numero : nivel)
+        {
+            PaginaFijada pagina(bufer, numero);
+            const char *datos = pagina.getDatos();
+            siguiente.push_back(leerCabeceraPagina(datos)->enlace);
+            for (size_t i = 0; i < leerCabeceraPagina(datos)->cantidad; ++i)
+            {
+                siguiente.push_back(leerHijaEntrada(leerEntrada(datos, i)));
+            }
+        }
+        nivel.swap(siguiente);
+    }
+}
+
+// Método para bajar desde la raíz hasta la hoja donde va (o está) el contacto 'nombre', 'numero' y 'copia'
+// Si 'camino' no es nulo, guarda cada página interna recorrida y la posición de la entrada que se siguió
+// (-1 si se siguió el enlace)
+uint32_t ArbolContactos::bajarHastaHoja(string_view nombre, uint64_t numero, uint16_t copia,
+                                        vector<pair<uint32_t, int>> *camino)
+{
+    uint32_t actual = raiz;
+    for (uint32_t nivel = 1; nivel < altura; ++nivel)
+    {
+        PaginaFijada pagina(bufer, actual);
+        const char *datos = pagina.getDatos();
+        // Se sigue la última entrada que no va después del contacto buscado
+        size_t posicion = buscarEnPagina(datos, nombre, numero, copia);
+        if (posicion < leerCabeceraPagina(datos)->cantidad &&
+            compararConEntrada(datos, posicion, nombre, numero, copia) == 0)
+        {
+            posicion++;
+        }
+        int seguida = static_cast<int>(posicion) - 1;
+        if (camino != nullptr)
+        {
+            camino->push_back({actual, seguida});
+        }
+        actual = seguida < 0 ? leerCabeceraPagina(datos)->enlace : leerHijaEntrada(leerEntrada(datos, seguida));
+    }
+    return actual;
+}
+
+// Método para buscar las copias de un nombre y un número
+// Retorna 'false' si no hay ninguna; si no, guarda la primera y la última. Las copias están juntas y en orden,
+// así que se recorren desde la primera (pueden seguir en las hojas siguientes)
+bool ArbolContactos::buscarCopias(string_view nombre, uint64_t numero, uint16_t &primera, uint16_t &ultima)
+{
+    bool encontrada = false;
+    uint32_t numeroHoja = bajarHastaHoja(nombre, numero, 0, nullptr);
+    while (numeroHoja != PAGINA_NINGUNA)
+    {
+        PaginaFijada hoja(bufer, numeroHoja);
+        const char *datos = hoja.getDatos();
+        size_t cantidadEntradas = leerCabeceraPagina(datos)->cantidad;
+        for (size_t posicion = buscarEnPagina(datos, nombre, numero, 0); posicion < cantidadEntradas; ++posicion)
+        {
+            const char *entrada = leerEntrada(datos, posicion);
+            if (leerNumeroEntrada(entrada) != numero || leerNombreEntrada(entrada) != nombre)
+            {
+                return encontrada;
+            }
+            if (!encontrada)
+            {
+                primera = leerCopiaEntrada(entrada);
+                encontrada = true;
+            }
+            ultima = leerCopiaEntrada(entrada);
+        }
+        numeroHoja = leerCabeceraPagina(datos)->enlace;
+    }
+    return encontrada;
+}
+
+// Método para calcular la copia que le toca a un contacto nuevo con un nombre y un número: la siguiente a la
+// última que hay. Retorna 'false' si ya se usó la última copia posible.
+bool ArbolContactos::calcularCopiaNueva(string_view nombre, uint64_t numero, uint16_t &copia)
+{
+    uint16_t primera, ultima;
+    if (!buscarCopias(nombre, numero, primera, ultima))
+    {
+        copia = 0;
+        return true;
+    }
+    if (ultima == COPIA_MAXIMA)
+    {
+        return false;
+    }
+    copia = static_cast<uint16_t>(ultima + 1);
+    return true;
+}
+
+// Método para insertar un contacto en su hoja, dividiendo las páginas que se llenen
+// Retorna 'false' si ya está esa copia del nombre y el número o si no entra en una página
+bool ArbolContactos::insertar(string_view nombre, string_view apellido, uint64_t numero, uint16_t copia,
+                              string_view email)
+{
+    vector<char> entrada;
+    armarEntradaHoja(entrada, nombre, apellido, numero, copia, email);
+    if (entrada.size() > MAXIMO_ENTRADA)
+    {
+        return false;
+    }
+
+    vector<pair<uint32_t, int>> camino;
+    uint32_t numeroHoja = bajarHastaHoja(nombre, numero, copia, &camino);
+    PaginaFijada hoja(bufer, numeroHoja);
+    size_t posicion = buscarEnPagina(hoja.getDatos(), nombre, numero, copia);
+    if (posicion < leerCabeceraPagina(hoja.getDatos())->cantidad &&
+        compararConEntrada(hoja.getDatos(), posicion, nombre, numero, copia) == 0)
+    {
+        return false;
+    }
+    marcarAbierto();
+    cantidad++;
+    if (insertarEnPagina(hoja.modificar(), posicion, entrada.data(), entrada.size(), TAMANO_PAGINA))
+    {
+        return true;
+    }
+
+    // La hoja está llena: se divide, y el separador sube por el camino mientras las páginas internas también se llenen
+    vector<char> separador, siguienteSeparador;
+    {
+        uint32_t numeroNueva = bufer.agregarPagina();
+        PaginaFijada nueva(bufer, numeroNueva);
+        dividirPagina(hoja.modificar(), nueva.modificar(), numeroNueva, posicion, entrada.data(), entrada.size(), separador);
+    }
+    uint32_t izquierda = numeroHoja;
+    while (!camino.empty())
+    {
+        uint32_t numeroPadre = camino.back().first;
+        size_t posicionPadre = static_cast<size_t>(camino.back().second + 1);
+        camino.pop_back();
+        PaginaFijada padre(bufer, numeroPadre);
+        if (insertarEnPagina(padre.modificar(), posicionPadre, separador.data(), separador.size(), TAMANO_PAGINA))
+        {
+            return true;
+        }
+        uint32_t numeroNueva = bufer.agregarPagina();
+        PaginaFijada nueva(bufer, numeroNueva);
+        dividirPagina(padre.modificar(), nueva.modificar(), numeroNueva, posicionPadre, separador.data(), separador.size(),
+                      siguienteSeparador);
+        separador.swap(siguienteSeparador);
+        izquierda = numeroPadre;
+    }
+
+    // Se dividió la raíz: el árbol crece un nivel
+    uint32_t numeroRaiz = bufer.agregarPagina();
+    PaginaFijada nuevaRaiz(bufer, numeroRaiz);
+    iniciarPagina(nuevaRaiz.modificar(), false, izquierda);
+    insertarEnPagina(nuevaRaiz.modificar(), 0, separador.data(), separador.size(), TAMANO_PAGINA);
+    raiz = numeroRaiz;
+    altura++;
+    return true;
+}
+
+// Método para quitar una copia de un contacto de su hoja; retorna 'false' si no existe
+bool ArbolContactos::quitar(string_view nombre, uint64_t numero, uint16_t copia)
+{
+    PaginaFijada hoja(bufer, bajarHastaHoja(nombre, numero, copia, nullptr));
+    size_t posicion = buscarEnPagina(hoja.getDatos(), nombre, numero, copia);
+    if (posicion >= leerCabeceraPagina(hoja.getDatos())->cantidad ||
+        compararConEntrada(hoja.getDatos(), posicion, nombre, numero, copia) != 0)
+    {
+        return false;
+    }
+    marcarAbierto();
+    quitarDePagina(hoja.modificar(), posicion);
+    cantidad--;
+    return true;
+}
+
+// Método para buscar el primer contacto con un nombre exacto
+bool ArbolContactos::buscar(string_view nombre, ContactoArbol &contacto)
+{
+    // Con el número 0 se llega a la hoja del primero con ese nombre; si está al final de la hoja, el contacto
+    // puede estar en la siguiente (o en otra más adelante, si las del medio quedaron vacías)
+    uint32_t numeroHoja = bajarHastaHoja(nombre, 0, 0, nullptr);
+    while (numeroHoja != PAGINA_NINGUNA)
+    {
+        PaginaFijada hoja(bufer, numeroHoja);
+        const char *datos = hoja.getDatos();
+        size_t posicion = buscarEnPagina(datos, nombre, 0, 0);
+        if (posicion < leerCabeceraPagina(datos)->cantidad)
+        {
+            const char *entrada = leerEntrada(datos, posicion);
+            string_view nombreEntrada = leerNombreEntrada(entrada);
+            if (nombreEntrada != nombre)
+            {
+                return false;
+            }
+            const char *textos = entrada + CABECERA_ENTRADA + nombreEntrada.size();
+            size_t longitudApellido = leerLongitud(entrada + 12);
+            contacto.nombre.assign(nombreEntrada);
+            contacto.apellido.assign(textos, longitudApellido);
+            contacto.email.assign(textos + longitudApellido, leerLongitud(entrada + 14));
+            contacto.numero = leerNumeroEntrada(entrada);
+            return true;
+        }
+        numeroHoja = leerCabeceraPagina(datos)->enlace;
+    }
+    return false;
+}
+
+// Método para agregar un contacto
+bool ArbolContactos::agregar(string_view nombre, string_view apellido, string_view numeroDeCelular, string_view email)
+{
+    uint64_t numero = empaquetarNumeroCelular(numeroDeCelular);
+    uint16_t copia;
+    if (calcularLetraInicial(nombre) < 0 || !calcularCopiaNueva(nombre, numero, copia))
+    {
+        return false;
+    }
+    return insertar(nombre, apellido, numero, copia, email);
+}
+
+// Método para reemplazar los datos de un contacto (la primera copia de su nombre y su número)
+// Todo se comprueba antes de cambiar nada, así una edición que no se puede hacer deja el contacto como estaba
+bool ArbolContactos::editar(string_view nombre, uint64_t numero, string_view nuevoNombre, string_view nuevoApellido,
+                            uint64_t nuevoNumero, string_view nuevoEmail)
+{
+    uint16_t copia, ultima;
+    if (calcularLetraInicial(nuevoNombre) < 0 ||
+        CABECERA_ENTRADA + nuevoNombre.size() + nuevoApellido.size() + nuevoEmail.size() > MAXIMO_ENTRADA ||
+        !buscarCopias(nombre, numero, copia, ultima))
+    {
+        return false;
+    }
+    // Si no cambian el nombre ni el número, el contacto conserva su copia; si no, pasa a la última del destino
+    uint16_t nuevaCopia = copia;
+    if ((nombre != nuevoNombre || numero != nuevoNumero) && !calcularCopiaNueva(nuevoNombre, nuevoNumero, nuevaCopia))
+    {
+        return false;
+    }
+    // Se copian los textos nuevos: pueden apuntar a la página del contacto, que cambia al quitarlo
+    string nombreCopia(nuevoNombre), apellidoCopia(nuevoApellido), emailCopia(nuevoEmail);
+    quitar(nombre, numero, copia);
+    return insertar(nombreCopia, apellidoCopia, nuevoNumero, nuevaCopia, emailCopia);
+}
+
+// Método para eliminar un contacto (la primera copia de su nombre y su número)
+bool ArbolContactos::eliminar(string_view nombre, uint64_t numero)
+{
+    uint16_t copia, ultima;
+    return buscarCopias(nombre, numero, copia, ultima) && quitar(nombre, numero, copia);
+}
+
+// Método para escribir todas las páginas modificadas y marcar el archivo como cerrado bien
+// Primero se escriben y sincronizan las páginas y recién después la cabecera con la marca
+void ArbolContactos::guardar()
+{
+    MedicionOperacion medicion(OPERACION_GUARDAR);
+    if (cerradoBien)
+    {
+        return;
+    }
+    bufer.vaciar();
+    cerradoBien = true;
+    escribirCabecera();
+    bufer.vaciar();
+}
+
+// Clase que arma un árbol en disco con contactos que llegan en orden (ver 'importarArbolContactos')
+// Llena las hojas de izquierda a derecha y mantiene abierta la última página de cada nivel interno: cada hoja
+// nueva se agrega a la del nivel de arriba y, cuando esa se llena, se abre otra que a su vez se agrega al
+// nivel siguiente. Las páginas se escriben en el disco a medida que salen del búfer.
+class ConstructorArbol
+{
+private:
+    BuferPaginas &bufer;
+    uint32_t primeraHoja;
+    uint32_t hojaActual;
+    vector<uint32_t> abiertas; // Última página de cada nivel interno (el 0 es el que está sobre las hojas)
+    string ultimoNombre;
+    uint64_t ultimoNumero;
+    uint16_t ultimaCopia;
+    uint64_t cantidad;
+    vector<char> entrada;
+
+    // Método para agregar la página 'hija' del nivel 'nivel - 1' a la derecha de 'izquierda'
+    // 'separador' es su entrada interna (el nombre y número con que comienza y la propia hija)
+    void agregarHija(size_t nivel, vector<char> &separador, uint32_t izquierda)
+    {
+        if (nivel == abiertas.size())
+        {
+            uint32_t numero = bufer.agregarPagina();
+            PaginaFijada pagina(bufer, numero);
+            iniciarPagina(pagina.modificar(), false, izquierda);
+            abiertas.push_back(numero);
+        }
+        uint32_t anterior = abiertas[nivel];
+        {
+            PaginaFijada pagina(bufer, anterior);
+            if (insertarEnPagina(pagina.modificar(), leerCabeceraPagina(pagina.getDatos())->cantidad, separador.data(),
+                                 separador.size(), LLENADO_IMPORTACION))
+            {
+                return;
+            }
+        }
+        // La página del nivel está llena: la hija comienza una nueva, que se agrega al nivel de arriba
+        uint32_t numero = bufer.agregarPagina();
+        {
+            PaginaFijada pagina(bufer, numero);
+            iniciarPagina(pagina.modificar(), false, leerHijaEntrada(separador.data()));
+        }
+        abiertas[nivel] = numero;
+        memcpy(separador.data() + 12, &numero, sizeof(numero));
+        agregarHija(nivel + 1, separador, anterior);
+    }
+
+public:
+    explicit ConstructorArbol(BuferPaginas &bufer)
+        : bufer(bufer), primeraHoja(PAGINA_NINGUNA), hojaActual(PAGINA_NINGUNA), ultimoNumero(0), ultimaCopia(0),
+          cantidad(0) {}
+
+    // Método para agregar el siguiente contacto (debe ir después del anterior o tener su mismo nombre y número,
+    // y entonces es la copia siguiente)
+    // Retorna 'false' si no entra en una página o si ya se usó la última copia; lanza una excepción si está fuera
+    // de orden
+    bool agregar(string_view nombre, string_view apellido, uint64_t numero, string_view email)
+    {
+        uint16_t copia = 0;
+        if (cantidad > 0)
+        {
+            int comparacion = compararNombres(nombre, ultimoNombre);
+            if (comparacion == 0)
+            {
+                comparacion = numero < ultimoNumero ? -1 : (numero > ultimoNumero ? 1 : 0);
+            }
+            if (comparacion < 0)
+            {
+                throw runtime_error("Los contactos a importar no están ordenados por nombre.");
+            }
+            if (comparacion == 0)
+            {
+                if (ultimaCopia == COPIA_MAXIMA)
+                {
+                    return false;
+                }
+                copia = static_cast<uint16_t>(ultimaCopia + 1);
+            }
+        }
+        armarEntradaHoja(entrada, nombre, apellido, numero, copia, email);
+        if (entrada.size() > MAXIMO_ENTRADA)
+        {
+            return false;
+        }
+
+        if (hojaActual == PAGINA_NINGUNA)
+        {
+            hojaActual = primeraHoja = bufer.agregarPagina();
+            PaginaFijada hoja(bufer, hojaActual);
+            iniciarPagina(hoja.modificar(), true, PAGINA_NINGUNA);
+        }
+        PaginaFijada hoja(bufer, hojaActual);
+        if (!insertarEnPagina(hoja.modificar(), leerCabeceraPagina(hoja.getDatos())->cantidad, entrada.data(),
+                              entrada.size(), LLENADO_IMPORTACION))
+        {
+            // La hoja está llena: el contacto comienza la siguiente
+            uint32_t numeroNueva = bufer.agregarPagina();
+            {
+                PaginaFijada nueva(bufer, numeroNueva);
+                iniciarPagina(nueva.modificar(), true, PAGINA_NINGUNA);
+                insertarEnPagina(nueva.modificar(), 0, entrada.data(), entrada.size(), TAMANO_PAGINA);
+            }
+            leerCabeceraPagina(hoja.modificar())->enlace = numeroNueva;
+            vector<char> separador;
+            armarEntradaInterna(separador, nombre, numero, copia, numeroNueva);
+            agregarHija(0, separador, hojaActual);
+            hojaActual = numeroNueva;
+        }
+        ultimoNombre.assign(nombre);
+        ultimoNumero = numero;
+        ultimaCopia = copia;
+        cantidad++;
+        return true;
+    }
+
+    // Método para terminar el árbol: retorna su raíz y guarda su altura y su cantidad de contactos
+    uint32_t terminar(uint32_t &altura, uint64_t &contactos)
+    {
+        if (primeraHoja == PAGINA_NINGUNA)
+        {
+            primeraHoja = hojaActual = bufer.agregarPagina();
+            PaginaFijada hoja(bufer, hojaActual);
+            iniciarPagina(hoja.modificar(), true, PAGINA_NINGUNA);
+        }
+        altura = static_cast<uint32_t>(abiertas.size()) + 1;
+        contactos = cantidad;
+        return abiertas.empty() ? primeraHoja : abiertas.back();
+    }
+};
+
+// Función para crear el árbol en disco con los contactos del archivo binario
+uint64_t importarArbolContactos(const string &rutaInstantanea, const string &rutaArbol, size_t bytesMemoria)
+{
+    uint32_t version = leerVersionInstantanea(rutaInstantanea);
+    string rutaTemporal = rutaArbol + ".tmp";
+    uint64_t cantidad;
+    uint64_t demasiadasCopias = 0, demasiadoLargos = 0; // Contactos que el árbol no admite
+    {
+        BuferPaginas bufer(rutaTemporal, bytesMemoria, true);
+        bufer.agregarPagina(); // La página 0 es la cabecera
+        ConstructorArbol constructor(bufer);
+
+        // Los contactos con el mismo nombre están juntos, pero no necesariamente ordenados por número: se
+        // juntan en una tanda y se ordenan antes de agregarlos (los textos se copian en strings que se reutilizan)
+        vector<ContactoArbol> tanda;
+        size_t enTanda = 0;
+        auto agregarTanda = [&]()
+        {
+            sort(tanda.begin(), tanda.begin() + enTanda, [](const ContactoArbol &a, const ContactoArbol &b)
+                 { return a.numero < b.numero; });
+            for (size_t i = 0; i < enTanda; ++i)
+            {
+                const ContactoArbol &contacto = tanda[i];
+                if (!constructor.agregar(contacto.nombre, contacto.apellido, contacto.numero, contacto.email))
+                {
+                    bool cabe = CABECERA_ENTRADA + contacto.nombre.size() + contacto.apellido.size() +
+                                    contacto.email.size() <= MAXIMO_ENTRADA;
+                    (cabe ? demasiadasCopias : demasiadoLargos)++;
+                }
+            }
+            enTanda = 0;
+        };
+        auto visitar = [&](string_view nombre, string_view apellido, uint64_t numero, string_view email)
+        {
+            if (enTanda > 0 && tanda[0].nombre != nombre)
+            {
+                agregarTanda();
+            }
+            if (enTanda == tanda.size())
+            {
+                tanda.emplace_back();
+            }
+            ContactoArbol &contacto = tanda[enTanda++];
+            contacto.nombre.assign(nombre);
+            contacto.apellido.assign(apellido);
+            contacto.numero = numero;
+            contacto.email.assign(email);
+        };
+
+        if (version == VERSION_INSTANTANEA_COMPRIMIDA)
+        {
+            InstantaneaComprimida instantanea(rutaInstantanea);
+            instantanea.recorrerBloques(0, instantanea.getCantidadBloques(), visitar);
+        }
+        else
+        {
+            InstantaneaMapeada instantanea(rutaInstantanea);
+            for (size_t i = 0; i < instantanea.getCantidad(); ++i)
+            {
+                Agenda contacto = instantanea.getContacto(i);
+                visitar(contacto.getNombre(), contacto.getApellido(), contacto.getNumeroEmpaquetado(), contacto.getEmail());
+            }
+        }
+        agregarTanda();
+
+        uint32_t altura;
+        uint32_t raiz = constructor.terminar(altura, cantidad);
+        escribirCabeceraArbol(bufer, raiz, altura, cantidad, true);
+        bufer.vaciar();
+    }
+
+    // No se deja un árbol con menos contactos que la agenda: se descarta y se informa cuántos faltarían
+    if (demasiadasCopias > 0 || demasiadoLargos > 0)
+    {
+        remove(rutaTemporal.c_str());
+        throw runtime_error("No se creó el árbol en disco: " + to_string(demasiadoLargos) +
+                            " contactos no entran en una página y " + to_string(demasiadasCopias) +
+                            " pasan de 65536 con el mismo nombre y número. El árbol no los admite; se pueden "
+                            "editar o fusionar en el modo en memoria (por ejemplo con el comando \"dedup\") antes "
+                            "de importar.");
+    }
+    reemplazarArchivo(rutaTemporal, rutaArbol);
+    return cantidad;
+}
@@ -0,0 +1,2289 @@
+// Núcleo de la agenda de contactos: almacén, índices, búsquedas, archivos y diario de cambios
+// No lee del teclado ni muestra menús, así lo comparten el programa con el menú (Proyecto_AgendaContactos.cpp)
+// y el programa de mediciones (Benchmark_Agenda.cpp). Las funciones están definidas en AgendaContactos.cpp.
+#ifndef AGENDA_CONTACTOS_H
+#define AGENDA_CONTACTOS_H
+
+#include <iostream>  // Para operaciones de entrada/salida (cout y cin)
+#include <vector>    // Para usar el contenedor vector (una lista dinámica)
+#include <string>    // Para trabajar con cadenas de texto (tipo string)
+#include <fstream>   // Para operaciones de archivo
+#include <limits>    // Para manejar los límites de los tipos de datos (como el valor máximo de un tipo int)
+#include <stdexcept> //Para el manejo de excepciones (errores que pueden ser capturados por try-catch)
+#include <algorithm> // Para usar funciones algoritmicas (ejemplo "sort")
+#include <chrono>    // Para medir el tiempo de carga de los contactos
+#include <thread>    // Para procesar el archivo de contactos en paralelo
+#include <cstring>   // Para buscar caracteres en bloques de memoria (memchr)
+#include <cstdint>   // Para los enteros de tamaño fijo del almacén de contactos (uint32_t, uint64_t)
+#include <string_view> // Para leer los textos guardados en el almacén sin copiarlos
+#include <mutex>     // Para proteger el diario de cambios entre el menú y su hilo de confirmación
+#include <condition_variable> // Para despertar al hilo que confirma el diario de cambios
+#include <atomic>    // Para saber si hay una compactación del diario en curso
+#include <filesystem> // Para revisar, renombrar y recortar los archivos del diario
+#include <cmath>     // Para la desviación estándar del tamaño de las particiones
+#include <optional>  // Para los campos que cambian al actualizar un contacto
+#include <unordered_map> // Para la lista de contactos de cada apellido y de cada dominio (índices invertidos)
+#ifdef _MSC_VER
+#include <intrin.h>   // Para ubicar el bit más alto de un entero en MSVC (_BitScanReverse64)
+#endif
+#ifndef _WIN32
+#include <fcntl.h>    // Para abrir el archivo a bajo nivel (open)
+#include <sys/mman.h> // Para mapear el archivo en memoria (mmap)
+#include <sys/stat.h> // Para conocer el tamaño del archivo (fstat)
+#include <unistd.h>   // Para cerrar el descriptor del archivo (close), sincronizar el diario (fsync) y leer y escribir las páginas del árbol (pread y pwrite)
+#else
+#include <fcntl.h>    // Para las opciones de _open
+#include <sys/stat.h> // Para los permisos del archivo creado con _open
+#include <io.h>       // Equivalentes de open/read/write/close en Windows para el diario y el árbol en disco
+#endif
+
+using namespace std;
+
+// Función para empaquetar un número de celular de 10 dígitos en un entero
+// El número debe estar validado previamente con 'validarNumeroCelular'
+uint64_t empaquetarNumeroCelular(string_view numero);
+
+// Función para recuperar los 10 dígitos de un número de celular empaquetado (con ceros a la izquierda)
+string desempaquetarNumeroCelular(uint64_t valor);
+
+// Clase que representa un contacto en la agenda
+// Los textos no le pertenecen: apuntan al almacén de contactos (AlmacenContactos) donde está guardado,
+// por eso un objeto Agenda solo es válido hasta la siguiente modificación de la agenda.
+class Agenda
+{
+    // Atributo privado
+private:
+    string_view nombre;
+    string_view apellido;
+    uint64_t numeroDeCelular; // Número empaquetado como entero (10 dígitos)
+    string_view email;
+
+    // Interfaz pública para interactuar con los atributos
+public:
+    // Constructor e inicializacion de las variables
+    Agenda(string_view nombre, string_view apellido, uint64_t numeroDeCelular, string_view email)
+        : nombre(nombre), apellido(apellido), numeroDeCelular(numeroDeCelular), email(email) {}
+
+    // Método para mostrar la información del contacto en la consola
+    void mostrarContacto() const
+    {
+        cout << "Nombre: " << nombre << endl;                                                 // Muestra el contacto
+        cout << "Apellido: " << apellido << endl;                                             // Muestra el apellido
+        cout << "Numero de Celular: " << desempaquetarNumeroCelular(numeroDeCelular) << endl; // Muestra el número de celular
+        cout << "Email: " << email << endl;                                                   // Muestra el email
+    }
+
+    // Método para guardar un contacto en un archivo - toma una referencia a objetos de tipo ofstream como parámetro
+    void contactoArchivado(ofstream &archivo) const
+    {
+        // Guarda el nombre, apellido, número de celular y email en el archivo
+        // Se usa '\n' en lugar de endl para no vaciar el búfer del archivo en cada contacto
+        archivo << nombre << " " << apellido << " " << desempaquetarNumeroCelular(numeroDeCelular) << " " << email << '\n';
+    }
+
+    // Getters: Métodos para obtener los datos del contacto
+    string_view getNombre() const { return nombre; }
+    string_view getApellido() const { return apellido; }
+    string getNumeroDeCelular() const { return desempaquetarNumeroCelular(numeroDeCelular); }
+    uint64_t getNumeroEmpaquetado() const { return numeroDeCelular; }
+    string_view getEmail() const { return email; }
+};
+
+// Función para validar el número de celular (10 dígitos)
+bool validarNumeroCelular(string_view numero);
+
+// Función para validar un email
+// Verifica si el correo electrónico contiene los símbolos '@' y '.', y que el '@' aparece antes del '.'.
+bool validarEmail(string_view email);
+
+// Función para pasar una letra (A-Z) a minúscula; los demás caracteres quedan igual
+inline unsigned char plegarLetra(char c)
+{
+    unsigned char letra = static_cast<unsigned char>(c);
+    return (letra >= 'A' && letra <= 'Z') ? letra + ('a' - 'A') : letra;
+}
+
+// ORDEN ALFABÉTICO EN ESPAÑOL
+// Cada carácter de un nombre tiene un peso de orden: las mayúsculas pesan lo mismo que las minúsculas, las
+// vocales acentuadas (y la ü, la ç, ...) lo mismo que su letra sin acento, y la ñ va entre la n y la o.
+// La clave de orden de un nombre es la secuencia de sus pesos, así que comparar dos nombres es comparar sus
+// claves byte a byte (memcmp). Para los caracteres ASCII el orden es el mismo de antes (el de las letras
+// pasadas a minúscula), así que los archivos ya guardados siguen ordenados.
+// Los nombres están en UTF-8: los acentos y la ñ ocupan dos bytes (0xC3 y otro), pero pesan uno solo.
+
+// Letra sin acento (en minúscula) de los caracteres U+00C0 a U+00FF, que en UTF-8 son 0xC3 seguido de 0x80-0xBF
+// 'N' marca la Ñ y la ñ; 0 marca los que no son una letra con acento (Æ, ×, ß, ...) y quedan como están
+constexpr char PLEGADO_LATIN1[65] = "aaaaaa\0ceeeeiiii\0Nooooo\0\0uuuuy\0\0aaaaaa\0ceeeeiiii\0Nooooo\0\0uuuuy\0y";
+
+// Peso de la ñ: justo después del de la n (los caracteres ASCII de la 'o' en adelante se corren un lugar)
+constexpr unsigned char PESO_ENIE = 'n' + 1;
+
+// Función para calcular el peso de orden de un carácter ASCII
+inline unsigned char calcularPesoAscii(unsigned char c)
+{
+    c = plegarLetra(static_cast<char>(c));
+    return c <= 'n' ? c : static_cast<unsigned char>(c < 0x7F ? c + 1 : 0x7F);
+}
+
+// Función para leer el siguiente carácter de un texto y retornar su peso de orden
+// Avanza 'posicion' uno o dos bytes. Los bytes que no forman una letra conocida pesan su propio valor
+// (siempre más que los ASCII), así que los nombres en otros alfabetos quedan al final, pero ordenados.
+inline unsigned char leerPesoOrden(string_view texto, size_t &posicion)
+{
+    unsigned char c = static_cast<unsigned char>(texto[posicion++]);
+    if (c < 0x80)
+    {
+        return calcularPesoAscii(c);
+    }
+    if (c == 0xC3 && posicion < texto.size())
+    {
+        unsigned char siguiente = static_cast<unsigned char>(texto[posicion]);
+        if (siguiente >= 0x80 && siguiente < 0xC0 && PLEGADO_LATIN1[siguiente - 0x80] != 0)
+        {
+            posicion++;
+            char plegado = PLEGADO_LATIN1[siguiente - 0x80];
+            return plegado == 'N' ? PESO_ENIE : calcularPesoAscii(static_cast<unsigned char>(plegado));
+        }
+    }
+    return c;
+}
+
+// Función para calcular la clave de orden de un nombre (la secuencia de los pesos de sus caracteres)
+// Nunca es más larga que el nombre.
+string calcularClaveOrden(string_view nombre);
+
+// Función para juntar los primeros 8 bytes de una clave en un entero (big-endian, completado con ceros)
+// Comparar dos de estos enteros da el mismo resultado que comparar esos 8 bytes con memcmp
+inline uint64_t calcularPrefijoClave(string_view clave)
+{
+    uint64_t prefijo = 0;
+    for (size_t i = 0; i < 8; ++i)
+    {
+        prefijo = (prefijo << 8) | (i < clave.size() ? static_cast<unsigned char>(clave[i]) : 0);
+    }
+    return prefijo;
+}
+
+// Función para comparar dos nombres por sus claves de orden ya calculadas
+// Si las claves son iguales (por ejemplo "María" y "maria") se desempata por los bytes del nombre, así el orden es total
+// Retorna un número negativo si 'a' va antes que 'b', 0 si son el mismo nombre y positivo si va después
+inline int compararClaves(string_view claveA, string_view nombreA, string_view claveB, string_view nombreB)
+{
+    int comparacion = claveA.compare(claveB);
+    return comparacion != 0 ? comparacion : nombreA.compare(nombreB);
+}
+
+// Función para comparar el comienzo de una clave con la clave de un prefijo
+// Retorna 0 si la clave comienza con el prefijo, negativo si va antes que todas las que comienzan con él y
+// positivo si va después
+inline int compararClaveConPrefijo(string_view clave, string_view clavePrefijo)
+{
+    return clave.substr(0, clavePrefijo.size()).compare(clavePrefijo);
+}
+
+// Nombre buscado con su clave de orden ya calculada (para compararlo con muchos contactos)
+// El nombre no se copia: debe seguir existiendo mientras se use la clave.
+struct ClaveOrden
+{
+    string clave;
+    uint64_t prefijo; // Primeros 8 bytes de la clave (ver 'calcularPrefijoClave')
+    string_view nombre;
+
+    explicit ClaveOrden(string_view nombre)
+        : clave(calcularClaveOrden(nombre)), prefijo(calcularPrefijoClave(clave)), nombre(nombre) {}
+};
+
+// Función para obtener la posición (0 a 63) del bit encendido más alto de un entero distinto de 0
+inline int calcularBitMasAlto(uint64_t valor)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(valor);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long posicion;
+    _BitScanReverse64(&posicion, valor);
+    return static_cast<int>(posicion);
+#else
+    int posicion = 0;
+    while (valor >>= 1)
+    {
+        posicion++;
+    }
+    return posicion;
+#endif
+}
+
+
+// Registro compacto de un contacto dentro del almacén (32 bytes por contacto)
+// Los textos del contacto se guardan uno tras otro (nombre, apellido, email y la clave de orden del nombre)
+// en el depósito de cadenas. Los primeros 8 bytes de la clave van también en el registro: casi todas las
+// comparaciones entre nombres se deciden con ellos, sin leer el depósito.
+struct RegistroContacto
+{
+    uint64_t desplazamiento;    // Posición del nombre en el depósito de cadenas
+    uint64_t numeroEmpaquetado; // Número de celular de 10 dígitos guardado como entero (o NUMERO_LIBRE / NUMERO_BORRADO)
+    uint64_t prefijoClave;      // Ver 'calcularPrefijoClave'
+    uint16_t longitudNombre;
+    uint16_t longitudApellido;
+    uint16_t longitudEmail;
+    uint16_t longitudClave;
+};
+
+static_assert(sizeof(RegistroContacto) == 32, "El registro de contacto debe ocupar 32 bytes");
+
+// Marcas de los registros libres y de los borrados que todavía ocupan su lugar en una partición (ver
+// 'ParticionesContactos::quitar'); ningún número de 10 dígitos llega a estos valores
+constexpr uint64_t NUMERO_LIBRE = numeric_limits<uint64_t>::max();
+constexpr uint64_t NUMERO_BORRADO = numeric_limits<uint64_t>::max() - 1;
+
+// Clase que guarda todos los contactos en memoria contigua
+// Los registros viven en un solo vector y los textos en un depósito de cadenas compartido, así que
+// no hay un objeto en el heap por contacto. Cada contacto se identifica por su índice de 32 bits.
+class AlmacenContactos
+{
+private:
+    vector<RegistroContacto> registros;
+    vector<char> cadenas;     // Depósito de cadenas: textos de todos los contactos
+    vector<uint32_t> libres;  // Índices de registros eliminados que se pueden reutilizar
+    size_t bytesLiberados;    // Bytes del depósito que ya no usa ningún contacto
+    size_t cantidadActivos;
+
+    // Método para copiar los textos de un contacto (y la clave de orden de su nombre) al final de 'destino'
+    // y completar las longitudes del registro
+    static void armarCadenas(vector<char> &destino, RegistroContacto &registro, string_view nombre, string_view apellido,
+                             string_view email)
+    {
+        // Las longitudes se guardan en 16 bits (la clave nunca es más larga que el nombre)
+        const size_t maximo = numeric_limits<uint16_t>::max();
+        if (nombre.size() > maximo || apellido.size() > maximo || email.size() > maximo)
+        {
+            throw runtime_error("Los datos del contacto son demasiado largos.");
+        }
+        destino.insert(destino.end(), nombre.begin(), nombre.end());
+        destino.insert(destino.end(), apellido.begin(), apellido.end());
+        destino.insert(destino.end(), email.begin(), email.end());
+        size_t inicioClave = destino.size();
+        for (size_t posicion = 0; posicion < nombre.size();)
+        {
+            destino.push_back(static_cast<char>(leerPesoOrden(nombre, posicion)));
+        }
+        registro.longitudNombre = static_cast<uint16_t>(nombre.size());
+        registro.longitudApellido = static_cast<uint16_t>(apellido.size());
+        registro.longitudEmail = static_cast<uint16_t>(email.size());
+        registro.longitudClave = static_cast<uint16_t>(destino.size() - inicioClave);
+        registro.prefijoClave = calcularPrefijoClave(string_view(destino.data() + inicioClave, registro.longitudClave));
+    }
+
+    // Método para copiar los textos de un contacto al final del depósito y completar el registro con sus posiciones
+    void guardarCadenas(RegistroContacto &registro, string_view nombre, string_view apellido, string_view email)
+    {
+        registro.desplazamiento = cadenas.size();
+        armarCadenas(cadenas, registro, nombre, apellido, email);
+    }
+
+    // Método para calcular cuántos bytes del depósito usa un registro
+    static size_t calcularBytesRegistro(const RegistroContacto &registro)
+    {
+        return registro.longitudNombre + registro.longitudApellido + registro.longitudEmail + registro.longitudClave;
+    }
+
+    // Método para leer la clave de orden de un registro
+    string_view getClave(const RegistroContacto &registro) const
+    {
+        return string_view(cadenas.data() + registro.desplazamiento + registro.longitudNombre + registro.longitudApellido +
+                               registro.longitudEmail,
+                           registro.longitudClave);
+    }
+
+    // Método para descartar del depósito los textos que ya no usa ningún contacto
+    // Solo se hace cuando más de la mitad del depósito está liberado, así el costo se reparte entre muchas operaciones
+    void compactarSiHaceFalta()
+    {
+        if (bytesLiberados < (1 << 16) || bytesLiberados * 2 < cadenas.size())
+        {
+            return;
+        }
+        vector<char> compactadas;
+        compactadas.reserve(cadenas.size() - bytesLiberados);
+        for (RegistroContacto &registro : registros)
+        {
+            // Los borrados todavía se comparan por su clave, así que sus textos se conservan
+            if (registro.numeroEmpaquetado == NUMERO_LIBRE)
+            {
+                continue;
+            }
+            size_t longitud = calcularBytesRegistro(registro);
+            uint64_t nuevoDesplazamiento = compactadas.size();
+            compactadas.insert(compactadas.end(), cadenas.begin() + registro.desplazamiento,
+                               cadenas.begin() + registro.desplazamiento + longitud);
+            registro.desplazamiento = nuevoDesplazamiento;
+        }
+        cadenas.swap(compactadas);
+        bytesLiberados = 0;
+    }
+
+    // Método para guardar un registro nuevo (ya con sus textos en el depósito) y retornar su índice
+    uint32_t ocuparRegistro(const RegistroContacto &registro)
+    {
+        cantidadActivos++;
+
+        // Se reutiliza el registro de un contacto eliminado si hay alguno
+        if (!libres.empty())
+        {
+            uint32_t indice = libres.back();
+            libres.pop_back();
+            registros[indice] = registro;
+            return indice;
+        }
+        if (registros.size() >= numeric_limits<uint32_t>::max())
+        {
+            throw runtime_error("Se alcanzó el máximo de contactos del almacén.");
+        }
+        registros.push_back(registro);
+        return static_cast<uint32_t>(registros.size() - 1);
+    }
+
+public:
+    // Constructor: el almacén empieza vacío
+    AlmacenContactos() : bytesLiberados(0), cantidadActivos(0) {}
+
+    // Método para reservar memoria antes de agregar muchos contactos
+    // Recibe cuántos contactos y cuántos bytes de texto se van a agregar
+    void reservar(size_t cantidadRegistros, size_t bytesDeCadenas)
+    {
+        registros.reserve(registros.size() + cantidadRegistros);
+        cadenas.reserve(cadenas.size() + bytesDeCadenas);
+    }
+
+    // Método para agregar un contacto y retornar su índice
+    // El número de celular debe estar validado (10 dígitos)
+    uint32_t agregar(string_view nombre, string_view apellido, string_view numeroDeCelular, string_view email)
+    {
+        return agregar(nombre, apellido, empaquetarNumeroCelular(numeroDeCelular), email);
+    }
+
+    // Método para agregar un contacto cuyo número ya está empaquetado y retornar su índice
+    uint32_t agregar(string_view nombre, string_view apellido, uint64_t numeroEmpaquetado, string_view email)
+    {
+        RegistroContacto registro;
+        guardarCadenas(registro, nombre, apellido, email);
+        registro.numeroEmpaquetado = numeroEmpaquetado;
+        return ocuparRegistro(registro);
+    }
+
+    // Método para agregar la copia de un contacto activo de otro almacén y retornar su índice
+    // Copia los textos y la clave de orden tal como están, sin volver a calcular la clave
+    uint32_t agregarCopia(const AlmacenContactos &origen, uint32_t contacto)
+    {
+        RegistroContacto registro = origen.registros[contacto];
+        auto textos = origen.cadenas.begin() + static_cast<ptrdiff_t>(registro.desplazamiento);
+        registro.desplazamiento = cadenas.size();
+        cadenas.insert(cadenas.end(), textos, textos + static_cast<ptrdiff_t>(calcularBytesRegistro(registro)));
+        return ocuparRegistro(registro);
+    }
+
+    // Método para calcular cuántos bytes del depósito usa un contacto (sus textos y su clave)
+    size_t getBytesCadenas(uint32_t contacto) const { return calcularBytesRegistro(registros[contacto]); }
+
+    // Método para reemplazar los textos de un contacto conservando su índice (el número no cambia)
+    // Si los textos nuevos (con la clave) entran en el lugar que ocupaban los anteriores se escriben ahí mismo y
+    // no crece el depósito; si no, se copian al final. Los textos nuevos pueden apuntar a los del mismo contacto
+    // (por ejemplo, el apellido que no cambia), por eso se arman primero en un búfer aparte.
+    void reemplazarTextos(uint32_t indice, string_view nombre, string_view apellido, string_view email)
+    {
+        RegistroContacto &registro = registros[indice];
+        thread_local vector<char> textos;
+        textos.clear();
+        RegistroContacto nuevo = registro;
+        armarCadenas(textos, nuevo, nombre, apellido, email);
+
+        size_t bytesAnteriores = calcularBytesRegistro(registro);
+        if (textos.size() <= bytesAnteriores)
+        {
+            copy(textos.begin(), textos.end(), cadenas.begin() + static_cast<ptrdiff_t>(registro.desplazamiento));
+            bytesLiberados += bytesAnteriores - textos.size();
+        }
+        else
+        {
+            nuevo.desplazamiento = cadenas.size();
+            cadenas.insert(cadenas.end(), textos.begin(), textos.end());
+            bytesLiberados += bytesAnteriores;
+        }
+        registro = nuevo;
+        compactarSiHaceFalta();
+    }
+
+    // Método para cambiar el número de un contacto (ya empaquetado)
+    void cambiarNumero(uint32_t indice, uint64_t numeroEmpaquetado) { registros[indice].numeroEmpaquetado = numeroEmpaquetado; }
+
+    // Método para marcar un contacto como borrado sin liberar su registro
+    // Deja de contarse y de estar activo, pero sus textos y su clave se conservan hasta que se libere
+    void marcarBorrado(uint32_t indice)
+    {
+        registros[indice].numeroEmpaquetado = NUMERO_BORRADO;
+        cantidadActivos--;
+    }
+
+    // Método para eliminar un contacto (activo o ya marcado como borrado); su registro queda libre para el
+    // siguiente contacto agregado
+    void liberar(uint32_t indice)
+    {
+        RegistroContacto &registro = registros[indice];
+        if (registro.numeroEmpaquetado != NUMERO_BORRADO)
+        {
+            cantidadActivos--;
+        }
+        bytesLiberados += calcularBytesRegistro(registro);
+        registro.numeroEmpaquetado = NUMERO_LIBRE;
+        libres.push_back(indice);
+        compactarSiHaceFalta();
+    }
+
+    // Método para agregar al final todos los contactos de otro almacén (se usa al unir la carga paralela)
+    // Retorna el índice que recibió el primer registro del otro almacén: el índice i de 'otro' pasa a ser base + i
+    uint32_t anexar(AlmacenContactos &&otro)
+    {
+        // Si este almacén está vacío basta con tomar los datos del otro, sin copiarlos
+        if (registros.empty())
+        {
+            *this = move(otro);
+            return 0;
+        }
+        if (registros.size() + otro.registros.size() >= numeric_limits<uint32_t>::max())
+        {
+            throw runtime_error("Se alcanzó el máximo de contactos del almacén.");
+        }
+        uint32_t base = static_cast<uint32_t>(registros.size());
+        uint64_t baseCadenas = cadenas.size();
+        cadenas.insert(cadenas.end(), otro.cadenas.begin(), otro.cadenas.end());
+        registros.insert(registros.end(), otro.registros.begin(), otro.registros.end());
+        for (size_t i = base; i < registros.size(); ++i)
+        {
+            registros[i].desplazamiento += baseCadenas;
+        }
+        for (uint32_t indiceLibre : otro.libres)
+        {
+            libres.push_back(base + indiceLibre);
+        }
+        bytesLiberados += otro.bytesLiberados;
+        cantidadActivos += otro.cantidadActivos;
+        return base;
+    }
+
+    // Getters: Métodos para leer los datos de un contacto sin copiarlos
+    string_view getNombre(uint32_t indice) const
+    {
+        const RegistroContacto &registro = registros[indice];
+        return string_view(cadenas.data() + registro.desplazamiento, registro.longitudNombre);
+    }
+    string_view getApellido(uint32_t indice) const
+    {
+        const RegistroContacto &registro = registros[indice];
+        return string_view(cadenas.data() + registro.desplazamiento + registro.longitudNombre, registro.longitudApellido);
+    }
+    string_view getEmail(uint32_t indice) const
+    {
+        const RegistroContacto &registro = registros[indice];
+        return string_view(cadenas.data() + registro.desplazamiento + registro.longitudNombre + registro.longitudApellido,
+                           registro.longitudEmail);
+    }
+    string_view getClave(uint32_t indice) const { return getClave(registros[indice]); }
+    uint64_t getPrefijoClave(uint32_t indice) const { return registros[indice].prefijoClave; }
+
+    // Método para leer la clave de orden de un contacto sin ir al depósito cuando entra en los 8 bytes del
+    // registro: en ese caso se copia a 'corta' (que debe seguir existiendo mientras se use la clave)
+    string_view getClaveCorta(uint32_t indice, char (&corta)[8]) const
+    {
+        const RegistroContacto &registro = registros[indice];
+        if (registro.longitudClave > sizeof(corta))
+        {
+            return getClave(registro);
+        }
+        for (size_t i = 0; i < registro.longitudClave; ++i)
+        {
+            corta[i] = static_cast<char>(registro.prefijoClave >> (56 - 8 * i));
+        }
+        return string_view(corta, registro.longitudClave);
+    }
+    uint64_t getNumeroEmpaquetado(uint32_t indice) const { return registros[indice].numeroEmpaquetado; }
+    size_t getLongitudClave(uint32_t indice) const { return registros[indice].longitudClave; }
+
+    // Métodos para comparar el nombre de un contacto con el de otro, con un nombre buscado o con un prefijo
+    // (por clave de orden; ver 'compararClaves'). Primero se comparan los 8 bytes guardados en el registro.
+    int compararContactos(uint32_t a, uint32_t b) const
+    {
+        const RegistroContacto &registroA = registros[a], &registroB = registros[b];
+        if (registroA.prefijoClave != registroB.prefijoClave)
+        {
+            return registroA.prefijoClave < registroB.prefijoClave ? -1 : 1;
+        }
+        return compararClaves(getClave(registroA), getNombre(a), getClave(registroB), getNombre(b));
+    }
+    int compararConClave(uint32_t contacto, const ClaveOrden &buscada) const
+    {
+        const RegistroContacto &registro = registros[contacto];
+        if (registro.prefijoClave != buscada.prefijo)
+        {
+            return registro.prefijoClave < buscada.prefijo ? -1 : 1;
+        }
+        return compararClaves(getClave(registro), getNombre(contacto), buscada.clave, buscada.nombre);
+    }
+    int compararConPrefijoClave(uint32_t contacto, string_view clavePrefijo) const
+    {
+        const RegistroContacto &registro = registros[contacto];
+        if (clavePrefijo.size() > 8)
+        {
+            return compararClaveConPrefijo(getClave(registro), clavePrefijo);
+        }
+        // El prefijo entra en los 8 bytes del registro: no hace falta leer la clave del depósito
+        uint64_t mascara = clavePrefijo.empty() ? 0 : ~0ULL << (64 - 8 * clavePrefijo.size());
+        uint64_t buscado = calcularPrefijoClave(clavePrefijo);
+        if ((registro.prefijoClave & mascara) != buscado)
+        {
+            return (registro.prefijoClave & mascara) < buscado ? -1 : 1;
+        }
+        // Los ceros de relleno de una clave más corta que el prefijo no cuentan como coincidencia
+        return registro.longitudClave < clavePrefijo.size() ? -1 : 0;
+    }
+
+    // Métodos para recorrer todos los registros: los índices válidos van de 0 a getTotalRegistros() - 1,
+    // incluidos los libres y los borrados (que se reconocen con 'estaActivo')
+    size_t getTotalRegistros() const { return registros.size(); }
+    bool estaActivo(uint32_t indice) const { return registros[indice].numeroEmpaquetado < NUMERO_BORRADO; }
+
+    // Método para obtener el contacto completo; sus textos apuntan al almacén
+    Agenda getContacto(uint32_t indice) const
+    {
+        return Agenda(getNombre(indice), getApellido(indice), getNumeroEmpaquetado(indice), getEmail(indice));
+    }
+
+    // Método para obtener la cantidad de contactos guardados
+    size_t getCantidad() const { return cantidadActivos; }
+
+    // Método para obtener la memoria ocupada por registros y cadenas (en bytes)
+    size_t getBytesOcupados() const
+    {
+        return registros.capacity() * sizeof(RegistroContacto) + cadenas.capacity() +
+               libres.capacity() * sizeof(uint32_t);
+    }
+};
+
+// Clase que indexa los contactos por número de celular (búsqueda inversa: número -> contacto)
+// Es una tabla hash de direccionamiento abierto con sondeo lineal. Cada casilla ocupa 8 bytes: una huella
+// de 32 bits del número (que también decide la casilla inicial) y el índice del contacto en el almacén.
+// Cuando la huella coincide se confirma el número en el almacén, así la tabla no guarda el número completo.
+// Un mismo número puede pertenecer a varios contactos; todos quedan en la misma secuencia de sondeo.
+class IndiceTelefonos
+{
+private:
+    struct Casilla
+    {
+        uint32_t huella;
+        uint32_t contacto; // 'VACIA' si la casilla está libre
+    };
+
+    static constexpr uint32_t VACIA = numeric_limits<uint32_t>::max();
+
+    vector<Casilla> casillas;
+    size_t mascara; // Capacidad - 1 (la capacidad siempre es potencia de 2)
+    size_t cantidad;
+
+    // Método para calcular la huella de 32 bits de un número empaquetado (mezcla de splitmix64)
+    static uint32_t calcularHuella(uint64_t numero)
+    {
+        numero ^= numero >> 30;
+        numero *= 0xBF58476D1CE4E5B9ULL;
+        numero ^= numero >> 27;
+        numero *= 0x94D049BB133111EBULL;
+        numero ^= numero >> 31;
+        return static_cast<uint32_t>(numero);
+    }
+
+    // Método para duplicar la capacidad de la tabla y volver a colocar todas las casillas
+    // No necesita el almacén: la casilla inicial sale de la huella
+    void crecer(size_t nuevaCapacidad)
+    {
+        vector<Casilla> anteriores(nuevaCapacidad, Casilla{0, VACIA});
+        anteriores.swap(casillas);
+        mascara = nuevaCapacidad - 1;
+        for (const Casilla &casilla : anteriores)
+        {
+            if (casilla.contacto == VACIA)
+            {
+                continue;
+            }
+            size_t posicion = casilla.huella & mascara;
+            while (casillas[posicion].contacto != VACIA)
+            {
+                posicion = (posicion + 1) & mascara;
+            }
+            casillas[posicion] = casilla;
+        }
+    }
+
+public:
+    // Constructor: la tabla empieza con 1024 casillas
+    IndiceTelefonos() : casillas(1024, Casilla{0, VACIA}), mascara(1023), cantidad(0) {}
+
+    // Método para preparar la tabla para 'total' contactos (evita crecer varias veces en una carga masiva)
+    void reservar(size_t total)
+    {
+        size_t capacidad = casillas.size();
+        while (total * 10 > capacidad * 7)
+        {
+            capacidad *= 2;
+        }
+        if (capacidad != casillas.size())
+        {
+            crecer(capacidad);
+        }
+    }
+
+    // Método para agregar un contacto con su número al índice
+    void agregar(uint64_t numero, uint32_t contacto)
+    {
+        // Se mantiene la ocupación por debajo del 70% para que las secuencias de sondeo sean cortas
+        reservar(cantidad + 1);
+        uint32_t huella = calcularHuella(numero);
+        size_t posicion = huella & mascara;
+        while (casillas[posicion].contacto != VACIA)
+        {
+            posicion = (posicion + 1) & mascara;
+        }
+        casillas[posicion] = Casilla{huella, contacto};
+        cantidad++;
+    }
+
+    // Método para quitar un contacto del índice
+    // Al vaciar la casilla se recorren hacia atrás las siguientes de la secuencia (sin marcas de borrado)
+    void quitar(uint64_t numero, uint32_t contacto)
+    {
+        size_t posicion = calcularHuella(numero) & mascara;
+        while (casillas[posicion].contacto != contacto)
+        {
+            if (casillas[posicion].contacto == VACIA)
+            {
+                return; // El contacto no estaba en el índice
+            }
+            posicion = (posicion + 1) & mascara;
+        }
+
+        size_t hueco = posicion;
+        size_t siguiente = posicion;
+        while (true)
+        {
+            siguiente = (siguiente + 1) & mascara;
+            if (casillas[siguiente].contacto == VACIA)
+            {
+                break;
+            }
+            // La casilla se puede mover al hueco si su posición inicial no queda entre el hueco y ella
+            size_t inicial = casillas[siguiente].huella & mascara;
+            bool inicialEntre = (hueco <= siguiente) ? (hueco < inicial && inicial <= siguiente)
+                                                     : (hueco < inicial || inicial <= siguiente);
+            if (!inicialEntre)
+            {
+                casillas[hueco] = casillas[siguiente];
+                hueco = siguiente;
+            }
+        }
+        casillas[hueco] = Casilla{0, VACIA};
+        cantidad--;
+    }
+
+    // Método para recorrer todos los contactos que tienen un número
+    // 'visitar' recibe el índice de cada contacto y retorna 'false' para detener el recorrido
+    template <typename Visitante>
+    void buscarTodos(const AlmacenContactos &almacen, uint64_t numero, Visitante visitar) const
+    {
+        uint32_t huella = calcularHuella(numero);
+        size_t posicion = huella & mascara;
+        while (casillas[posicion].contacto != VACIA)
+        {
+            const Casilla &casilla = casillas[posicion];
+            if (casilla.huella == huella && almacen.getNumeroEmpaquetado(casilla.contacto) == numero)
+            {
+                if (!visitar(casilla.contacto))
+                {
+                    return;
+                }
+            }
+            posicion = (posicion + 1) & mascara;
+        }
+    }
+
+    // Método para buscar el primer contacto con un número
+    // Retorna 'true' y guarda su índice en 'contacto' si lo encuentra
+    bool buscar(const AlmacenContactos &almacen, uint64_t numero, uint32_t &contacto) const
+    {
+        bool encontrado = false;
+        buscarTodos(almacen, numero, [&](uint32_t indice)
+                    {
+                        contacto = indice;
+                        encontrado = true;
+                        return false;
+                    });
+        return encontrado;
+    }
+
+    // Método para obtener la cantidad de contactos indexados
+    size_t getCantidad() const { return cantidad; }
+};
+
+// ÍNDICES INVERTIDOS (APELLIDO Y DOMINIO DEL EMAIL)
+// Para cada apellido y cada dominio de email se guarda la lista de los contactos que lo tienen (sus índices
+// en el almacén, de menor a mayor), así "todos los Hernández" o "todos los de @empresa.com" se responden
+// recorriendo solo esos contactos y no toda la agenda. Los apellidos y los dominios se comparan por su clave
+// de orden (ver 'calcularClaveOrden'): sin distinguir mayúsculas, minúsculas ni acentos.
+
+// Punto de salto de una lista comprimida: cada 'SALTO_LISTA' contactos (desde el contacto 'SALTO_LISTA') se
+// anota el contacto y dónde comienza el siguiente, así un cursor puede saltar hasta un contacto sin
+// decodificar los del medio
+struct SaltoLista
+{
+    uint32_t contacto;
+    uint32_t desplazamiento;
+};
+
+constexpr size_t SALTO_LISTA = 64;
+
+// Clase con la lista de contactos de un apellido o de un dominio
+// La parte principal está comprimida: cada índice se guarda como la diferencia con el anterior en un entero
+// de largo variable (7 bits por byte; casi siempre 1 o 2 bytes por contacto). Un contacto mayor que el último
+// comprimido se agrega al final; los demás cambios se anotan aparte en 'agregados' y 'quitados' (ordenados)
+// y, cuando son más de la octava parte de la lista, se vuelve a comprimir completa. Así cada cambio cuesta
+// O(1) amortizado y recorrer la lista cuesta lo que mide la lista.
+class ListaContactos
+{
+private:
+    vector<uint8_t> comprimidos;
+    vector<SaltoLista> saltos;
+    uint32_t cantidadComprimidos; // Contactos en 'comprimidos' (incluidos los que están en 'quitados')
+    uint32_t ultimoComprimido;
+    vector<uint32_t> agregados; // Contactos fuera de orden que todavía no están en 'comprimidos'
+    vector<uint32_t> quitados;  // Contactos de 'comprimidos' que ya no están en la lista
+
+    void anexarComprimido(uint32_t contacto);
+    void recomprimirSiHaceFalta();
+
+    friend class CursorLista;
+
+public:
+    ListaContactos() : cantidadComprimidos(0), ultimoComprimido(0) {}
+
+    // Métodos para agregar y quitar un contacto (quien llama sabe si ya está en la lista)
+    void agregar(uint32_t contacto);
+    void quitar(uint32_t contacto);
+
+    size_t getCantidad() const { return cantidadComprimidos - quitados.size() + agregados.size(); }
+    size_t getBytesOcupados() const
+    {
+        return comprimidos.capacity() + saltos.capacity() * sizeof(SaltoLista) +
+               (agregados.capacity() + quitados.capacity()) * sizeof(uint32_t);
+    }
+};
+
+// Clase para recorrer una lista de contactos de menor a mayor
+// Junta la parte comprimida (sin los quitados) con los agregados. 'avanzarHasta' usa los puntos de salto,
+// así intersecar una lista corta con una larga no decodifica toda la larga.
+class CursorLista
+{
+private:
+    const ListaContactos &lista;
+    uint32_t indiceComprimido; // Posición en la parte comprimida del contacto 'valorComprimido'
+    uint32_t valorComprimido;
+    size_t siguienteByte; // Dónde comienza el contacto comprimido siguiente
+    size_t posicionAgregados;
+    size_t posicionQuitados;
+    uint32_t actual;
+    bool terminado;
+
+    // Método para leer el siguiente contacto de la parte comprimida
+    void leerComprimido()
+    {
+        if (++indiceComprimido >= lista.cantidadComprimidos)
+        {
+            return;
+        }
+        uint32_t diferencia = 0;
+        int desplazamiento = 0;
+        uint8_t byte;
+        do
+        {
+            byte = lista.comprimidos[siguienteByte++];
+            diferencia |= static_cast<uint32_t>(byte & 0x7F) << desplazamiento;
+            desplazamiento += 7;
+        } while (byte & 0x80);
+        valorComprimido += diferencia;
+    }
+
+    // Método para saltear los contactos comprimidos que están en 'quitados' y elegir el contacto actual
+    void ubicarActual()
+    {
+        const vector<uint32_t> &quitados = lista.quitados;
+        while (indiceComprimido < lista.cantidadComprimidos)
+        {
+            while (posicionQuitados < quitados.size() && quitados[posicionQuitados] < valorComprimido)
+            {
+                posicionQuitados++;
+            }
+            if (posicionQuitados == quitados.size() || quitados[posicionQuitados] != valorComprimido)
+            {
+                break;
+            }
+            leerComprimido();
+        }
+        bool hayComprimido = indiceComprimido < lista.cantidadComprimidos;
+        bool hayAgregado = posicionAgregados < lista.agregados.size();
+        terminado = !hayComprimido && !hayAgregado;
+        if (hayComprimido && (!hayAgregado || valorComprimido < lista.agregados[posicionAgregados]))
+        {
+            actual = valorComprimido;
+        }
+        else if (hayAgregado)
+        {
+            actual = lista.agregados[posicionAgregados];
+        }
+    }
+
+public:
+    explicit CursorLista(const ListaContactos &lista)
+        : lista(lista), indiceComprimido(numeric_limits<uint32_t>::max()), valorComprimido(0), siguienteByte(0),
+          posicionAgregados(0), posicionQuitados(0), actual(0), terminado(false)
+    {
+        leerComprimido();
+        ubicarActual();
+    }
+
+    bool haTerminado() const { return terminado; }
+    uint32_t getContacto() const { return actual; }
+
+    // Método para pasar al contacto siguiente
+    void avanzar()
+    {
+        if (indiceComprimido < lista.cantidadComprimidos && valorComprimido == actual)
+        {
+            leerComprimido();
+        }
+        else
+        {
+            posicionAgregados++;
+        }
+        ubicarActual();
+    }
+
+    // Método para pasar al primer contacto mayor o igual que 'contacto'
+    void avanzarHasta(uint32_t contacto)
+    {
+        if (terminado || actual >= contacto)
+        {
+            return;
+        }
+        // Salta al último punto de salto que no pasa de 'contacto' (si está más adelante que la posición actual)
+        const vector<SaltoLista> &saltos = lista.saltos;
+        auto salto = upper_bound(saltos.begin(), saltos.end(), contacto, [](uint32_t buscado, const SaltoLista &punto)
+                                 { return buscado < punto.contacto; });
+        if (salto != saltos.begin() && indiceComprimido < lista.cantidadComprimidos)
+        {
+            --salto;
+            uint32_t indiceSalto = static_cast<uint32_t>(static_cast<size_t>(salto - saltos.begin() + 1) * SALTO_LISTA);
+            if (indiceSalto > indiceComprimido)
+            {
+                indiceComprimido = indiceSalto;
+                valorComprimido = salto->contacto;
+                siguienteByte = salto->desplazamiento;
+            }
+        }
+        while (indiceComprimido < lista.cantidadComprimidos && valorComprimido < contacto)
+        {
+            leerComprimido();
+        }
+        const vector<uint32_t> &agregados = lista.agregados;
+        posicionAgregados = static_cast<size_t>(
+            lower_bound(agregados.begin() + static_cast<ptrdiff_t>(posicionAgregados), agregados.end(), contacto) -
+            agregados.begin());
+        ubicarActual();
+    }
+};
+
+// Clase con un índice invertido: la lista de contactos de cada clave (apellido o dominio)
+class IndiceInvertido
+{
+private:
+    unordered_map<string, ListaContactos> listas;
+
+public:
+    // Métodos para agregar y quitar un contacto de la lista de una clave (ya calculada con 'calcularClaveOrden')
+    void agregar(const string &clave, uint32_t contacto) { listas[clave].agregar(contacto); }
+    void quitar(const string &clave, uint32_t contacto);
+
+    // Método para obtener la lista de una clave; retorna 'nullptr' si ningún contacto la tiene
+    const ListaContactos *buscar(const string &clave) const
+    {
+        auto lista = listas.find(clave);
+        return lista == listas.end() ? nullptr : &lista->second;
+    }
+
+    size_t getCantidadClaves() const { return listas.size(); }
+    size_t getBytesOcupados() const;
+};
+
+// Clase con los índices por apellido y por dominio del email de la agenda
+// Se construyen la primera vez que se consultan (con una pasada por el almacén, en orden de índice, así todas
+// las listas se arman agregando al final) y desde entonces se mantienen con cada cambio. Hasta esa primera
+// consulta los cambios no hacen nada, así cargar la agenda no cuesta más si nunca se consulta por grupos.
+class IndicesGrupos
+{
+private:
+    IndiceInvertido apellidos;
+    IndiceInvertido dominios;
+    bool construidos = false;
+
+public:
+    // Funciones para calcular la clave de un apellido y la del dominio de un email (vacía si no tiene '@')
+    static string calcularClaveApellido(string_view apellido) { return calcularClaveOrden(apellido); }
+    static string calcularClaveDominio(string_view email)
+    {
+        size_t arroba = email.rfind('@');
+        return arroba == string_view::npos ? string() : calcularClaveOrden(email.substr(arroba + 1));
+    }
+
+    // Método para construir los índices con todos los contactos activos (solo la primera vez)
+    void construir(const AlmacenContactos &almacen);
+    bool estanConstruidos() const { return construidos; }
+
+    // Métodos para mantener los índices: un contacto nuevo, uno que se borra y los que cambian de apellido
+    // o de email (con los textos anterior y nuevo). No hacen nada si los índices todavía no se construyeron.
+    void agregar(const AlmacenContactos &almacen, uint32_t contacto);
+    void quitar(const AlmacenContactos &almacen, uint32_t contacto);
+    void cambiarApellido(uint32_t contacto, string_view anterior, string_view nuevo);
+    void cambiarEmail(uint32_t contacto, string_view anterior, string_view nuevo);
+
+    // Métodos para obtener la lista de un apellido o de un dominio ('nullptr' si no hay ningún contacto)
+    const ListaContactos *buscarApellido(string_view apellido) const { return apellidos.buscar(calcularClaveApellido(apellido)); }
+    const ListaContactos *buscarDominio(string_view dominio) const { return dominios.buscar(calcularClaveOrden(dominio)); }
+
+    size_t getCantidadApellidos() const { return apellidos.getCantidadClaves(); }
+    size_t getCantidadDominios() const { return dominios.getCantidadClaves(); }
+    size_t getBytesOcupados() const { return apellidos.getBytesOcupados() + dominios.getBytesOcupados(); }
+};
+
+// ESTADÍSTICAS DE LAS OPERACIONES
+// Si se compila con -DAGENDA_ESTADISTICAS, las operaciones principales de la agenda cuentan cuántas veces se
+// hicieron y anotan su duración en un histograma de latencias; también se cuentan los bytes escritos en los
+// archivos. Sin esa opción 'MedicionOperacion' y 'contarBytesEscritos' no hacen nada y el compilador las
+// elimina, así que no cuestan nada.
+// Agregar, buscar, editar y eliminar se miden donde el usuario las pide (el menú, el modo por lotes y el modo
+// servicio) y no en 'registrarContacto' y las demás, así no se mezclan con las que hace la propia agenda al
+// aplicar el diario al iniciar, al compactarlo o al fusionar duplicados.
+
+// Reservas de memoria de todo el programa
+// Conteo_Memoria.cpp reemplaza todas las formas globales de 'operator new' y 'operator delete' para contarlas
+// aquí; lo enlazan el programa de mediciones y el menú compilado con -DAGENDA_ESTADISTICAS. En los programas
+// que no lo enlazan queda en 0.
+extern atomic<uint64_t> reservasMemoria;
+
+// Operaciones que se miden
+enum OperacionAgenda
+{
+    OPERACION_AGREGAR,     // Agregar un contacto
+    OPERACION_BUSCAR,      // Buscar un contacto por su nombre exacto
+    OPERACION_EDITAR,      // Editar un contacto (en el modo por lotes, también ubicarlo por su nombre)
+    OPERACION_ELIMINAR,    // Ubicar un contacto por su nombre y eliminarlo
+    OPERACION_GUARDAR,     // Confirmar un grupo de entradas del diario (escribirlas y sincronizarlas)
+    OPERACION_INSTANTANEA, // 'guardarInstantanea' (el archivo binario completo)
+    CANTIDAD_OPERACIONES
+};
+
+// Nombres de las operaciones en la salida de las estadísticas
+inline const char *const NOMBRES_OPERACIONES[CANTIDAD_OPERACIONES] = {
+    "agregar", "buscar", "editar", "eliminar", "guardar", "instantanea"};
+
+#ifdef AGENDA_ESTADISTICAS
+// Histograma de latencias con precisión relativa fija (al estilo de HdrHistogram)
+// Los valores (en nanosegundos) se agrupan por su potencia de 2 y cada potencia se divide en 16 casillas
+// iguales, así que un percentil se informa con un error de a lo sumo 1/16 (6%), tanto si la operación tarda
+// 50 ns como 5 s, con menos de mil contadores. Registrar un valor es sumar 1 a su casilla: los contadores son
+// atómicos (sin orden de memoria) para que los hilos del modo servicio registren a la vez sin candados.
+// No tiene constructor: los objetos globales empiezan en cero.
+class HistogramaLatencias
+{
+private:
+    static constexpr int BITS_SUBRANGO = 4;
+    static constexpr int SUBRANGOS = 1 << BITS_SUBRANGO;
+    static constexpr int CASILLAS = (64 - BITS_SUBRANGO + 1) * SUBRANGOS;
+
+    atomic<uint64_t> casillas[CASILLAS];
+    atomic<uint64_t> cantidad;
+    atomic<uint64_t> suma;
+    atomic<uint64_t> maximo;
+
+    // Método para calcular la casilla de un valor: los menores que 16 tienen una casilla cada uno y los demás
+    // van a la de su potencia de 2 y sus 4 bits siguientes al más alto
+    static int calcularCasilla(uint64_t valor)
+    {
+        if (valor < SUBRANGOS)
+        {
+            return static_cast<int>(valor);
+        }
+        int exponente = calcularBitMasAlto(valor);
+        return (exponente - BITS_SUBRANGO + 1) * SUBRANGOS +
+               static_cast<int>((valor >> (exponente - BITS_SUBRANGO)) & (SUBRANGOS - 1));
+    }
+
+    // Método para obtener el mayor valor que cae en una casilla
+    static uint64_t calcularLimiteSuperior(int casilla);
+
+public:
+    // Método para anotar una duración
+    void registrar(uint64_t nanosegundos)
+    {
+        casillas[calcularCasilla(nanosegundos)].fetch_add(1, memory_order_relaxed);
+        cantidad.fetch_add(1, memory_order_relaxed);
+        suma.fetch_add(nanosegundos, memory_order_relaxed);
+        uint64_t anterior = maximo.load(memory_order_relaxed);
+        while (nanosegundos > anterior && !maximo.compare_exchange_weak(anterior, nanosegundos, memory_order_relaxed))
+        {
+        }
+    }
+
+    // Método para calcular un percentil (0-100): el mayor valor de la casilla donde cae, sin pasar del máximo
+    uint64_t calcularPercentil(double percentil) const;
+
+    uint64_t getCantidad() const { return cantidad.load(memory_order_relaxed); }
+    uint64_t getMaximo() const { return maximo.load(memory_order_relaxed); }
+    uint64_t getPromedio() const
+    {
+        uint64_t total = getCantidad();
+        return total > 0 ? suma.load(memory_order_relaxed) / total : 0;
+    }
+};
+
+// Contadores de toda la agenda (un solo objeto global, 'estadisticasAgenda')
+struct EstadisticasAgenda
+{
+    HistogramaLatencias latencias[CANTIDAD_OPERACIONES];
+    atomic<uint64_t> bytesEscritos; // En el diario de cambios y en los archivos binarios
+};
+
+extern EstadisticasAgenda estadisticasAgenda;
+
+// Clase que mide la duración de una operación: desde que se crea hasta que termina el bloque donde está
+class MedicionOperacion
+{
+private:
+    OperacionAgenda operacion;
+    chrono::steady_clock::time_point inicio;
+
+public:
+    explicit MedicionOperacion(OperacionAgenda operacion) : operacion(operacion), inicio(chrono::steady_clock::now()) {}
+
+    ~MedicionOperacion()
+    {
+        auto duracion = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - inicio);
+        estadisticasAgenda.latencias[operacion].registrar(static_cast<uint64_t>(duracion.count()));
+    }
+
+    // La medición no se puede copiar (se anotaría dos veces)
+    MedicionOperacion(const MedicionOperacion &) = delete;
+    MedicionOperacion &operator=(const MedicionOperacion &) = delete;
+};
+
+// Función para sumar bytes escritos en los archivos de la agenda
+inline void contarBytesEscritos(uint64_t bytes) { estadisticasAgenda.bytesEscritos.fetch_add(bytes, memory_order_relaxed); }
+#else
+// Sin estadísticas no se mide nada
+class MedicionOperacion
+{
+public:
+    explicit MedicionOperacion(OperacionAgenda) {}
+};
+
+inline void contarBytesEscritos(uint64_t) {}
+#endif
+
+class DiarioCambios;
+
+// Función para calcular el grupo (0 = 'A',...,25 = 'Z') de un nombre
+// Las iniciales acentuadas van en el grupo de su letra y la Ñ en el de la N (justo después de los que
+// comienzan con N), así cada grupo sigue siendo un tramo contiguo del orden alfabético.
+// Retorna -1 si el nombre está vacío o no comienza con una letra del alfabeto
+int calcularLetraInicial(string_view nombre);
+
+// Función para comparar dos nombres en orden alfabético español (ver 'calcularClaveOrden')
+// Es lo mismo que comparar sus claves con 'compararClaves', pero sin calcularlas (no reserva memoria).
+// Retorna un número negativo si 'a' va antes que 'b', 0 si son iguales y positivo si va después
+int compararNombres(string_view a, string_view b);
+
+// Función para comparar el comienzo de un nombre con un prefijo, en orden alfabético español
+// Retorna 0 si el nombre comienza con el prefijo (sin distinguir mayúsculas ni acentos), negativo si el nombre
+// va antes que todos los que comienzan con el prefijo y positivo si va después
+int compararConPrefijo(string_view nombre, string_view prefijo);
+
+// Función de búsqueda binaria
+// Realiza una búsqueda binaria en un grupo de índices de contactos (del almacén) para encontrar un contacto por su nombre.
+// Si encuentra el nombre, devuelve 'true' y guarda la posición del contacto dentro del grupo en la variable 'index'.
+// Si no encuentra el nombre, devuelve 'false'
+// La búsqueda binaria asume que el grupo de contactos está previamente ordenado por nombre (con 'CompararContactosPorNombre').
+bool busquedaBinaria(const AlmacenContactos &almacen, const vector<uint32_t> &contactos, const ClaveOrden &buscada, int &index);
+bool busquedaBinaria(const AlmacenContactos &almacen, const vector<uint32_t> &contactos, string_view nombre, int &index);
+
+// Estructura para comparar los nombres de dos contactos (a y b) en orden alfabético español ascendente,
+// por sus claves de orden (ver 'AlmacenContactos::compararContactos')
+// Es el criterio con el que se mantiene ordenada cada partición; recibe índices del almacén
+struct CompararContactosPorNombre
+{
+    const AlmacenContactos *almacen;
+
+    bool operator()(uint32_t a, uint32_t b) const
+    {
+        return almacen->compararContactos(a, b) < 0;
+    }
+};
+
+// Partición de la agenda: un rango contiguo de nombres en el orden de 'CompararContactosPorNombre'
+// El rango comienza en 'limiteInferior' (incluido) y termina donde comienza el de la partición siguiente.
+// 'contactos' puede tener lápidas: contactos borrados (no activos en el almacén) que siguen en su lugar
+// hasta que se compacta la partición; quien la recorre debe saltearlos.
+struct Particion
+{
+    string limiteInferior;
+    string claveLimite;         // Clave de orden de 'limiteInferior'
+    vector<uint32_t> contactos; // Índices de los contactos en el almacén, ordenados por nombre
+    size_t borrados = 0;        // Cantidad de lápidas en 'contactos'
+
+    size_t getActivos() const { return contactos.size() - borrados; }
+};
+
+// Estadísticas del tamaño de las particiones, para comprobar que están equilibradas
+struct EstadisticasParticiones
+{
+    size_t cantidad = 0;  // Cantidad de particiones
+    size_t contactos = 0; // Contactos en total (sin contar las lápidas)
+    size_t borrados = 0;  // Lápidas que todavía no se compactaron
+    size_t minimo = 0;    // Contactos de la partición más chica
+    size_t maximo = 0;    // Contactos de la partición más grande
+    double promedio = 0.0;
+    double desviacion = 0.0; // Desviación estándar del tamaño
+};
+
+// Clase que reparte los contactos, ordenados por nombre, en particiones de tamaño parecido
+// Repartirlos por la letra inicial dejaba grupos enormes (M, J, A, L con nombres en español) y otros casi
+// vacíos (Q, X, W), y ordenar, insertar y borrar costaba lo que mide el grupo más grande. Las particiones son
+// rangos del orden alfabético con límites tomados de los propios datos: la que supera el doble de
+// 'tamanoObjetivo' se divide en partes iguales por sus cuantiles (los nombres de las posiciones de corte) y
+// la que baja de la cuarta parte se une con su vecina más chica. Así se reequilibran mientras la agenda cambia.
+// Un límite nunca separa dos nombres iguales, así que los repetidos siempre quedan en la misma partición.
+// Los tamaños se miden en contactos activos (sin las lápidas, ver 'quitar').
+class ParticionesContactos
+{
+private:
+    vector<Particion> particiones; // Siempre hay al menos una; la primera tiene límite "" (cubre desde el comienzo)
+    size_t tamanoObjetivo;
+
+    void compactar(AlmacenContactos &almacen, size_t particion);
+    void dividir(AlmacenContactos &almacen, size_t particion);
+    void unirConVecina(AlmacenContactos &almacen, size_t particion);
+    void unirSiHaceFalta(AlmacenContactos &almacen, size_t particion)
+    {
+        if (particiones[particion].getActivos() < tamanoObjetivo / 4 && particiones.size() > 1)
+        {
+            unirConVecina(almacen, particion);
+        }
+    }
+
+public:
+    explicit ParticionesContactos(size_t tamanoObjetivo = 2048)
+        : particiones(1), tamanoObjetivo(max<size_t>(tamanoObjetivo, 4)) {}
+
+    size_t getCantidad() const { return particiones.size(); }
+    size_t getTamanoObjetivo() const { return tamanoObjetivo; }
+    const Particion &getParticion(size_t particion) const { return particiones[particion]; }
+    const vector<uint32_t> &getContactos(size_t particion) const { return particiones[particion].contactos; }
+
+    // Método para ubicar la partición cuyo rango contiene el nombre de clave 'clave' (búsqueda binaria sobre los límites)
+    size_t ubicar(string_view clave, string_view nombre) const
+    {
+        // La primera partición con un límite mayor que el nombre es la siguiente a la buscada
+        auto siguiente = partition_point(particiones.begin() + 1, particiones.end(), [&](const Particion &particion)
+                                         { return compararClaves(clave, nombre, particion.claveLimite,
+                                                                 particion.limiteInferior) >= 0; });
+        return static_cast<size_t>(siguiente - particiones.begin()) - 1;
+    }
+    size_t ubicar(const ClaveOrden &buscada) const { return ubicar(buscada.clave, buscada.nombre); }
+    size_t ubicar(string_view nombre) const { return ubicar(ClaveOrden(nombre)); }
+
+    // Método para ubicar la primera partición que puede tener nombres cuya clave comienza con 'clavePrefijo'
+    // (los siguientes pueden seguir en las particiones posteriores)
+    size_t ubicarPrefijo(string_view clavePrefijo) const
+    {
+        auto siguiente = partition_point(particiones.begin() + 1, particiones.end(), [&](const Particion &particion)
+                                         { return compararClaveConPrefijo(particion.claveLimite, clavePrefijo) < 0; });
+        return static_cast<size_t>(siguiente - particiones.begin()) - 1;
+    }
+
+    // Método para insertar un contacto del almacén en su partición, después de los que tienen el mismo nombre
+    // (respeta el orden de llegada). Si la partición queda demasiado grande, se divide.
+    void insertar(AlmacenContactos &almacen, uint32_t contacto)
+    {
+        size_t particion = ubicar(almacen.getClave(contacto), almacen.getNombre(contacto));
+        vector<uint32_t> &grupo = particiones[particion].contactos;
+        CompararContactosPorNombre comparar{&almacen};
+        grupo.insert(upper_bound(grupo.begin(), grupo.end(), contacto, comparar), contacto);
+        if (particiones[particion].getActivos() > 2 * tamanoObjetivo)
+        {
+            dividir(almacen, particion);
+        }
+    }
+
+    // Método para borrar el contacto de la posición 'posicion' de una partición
+    // No corre los siguientes: el contacto se marca como borrado en el almacén y queda como lápida en su lugar
+    // (conserva su nombre y su clave, así la partición sigue ordenada para la búsqueda binaria). Cuando las
+    // lápidas pasan de la cuarta parte de la partición se compacta (se descartan todas de una pasada y se
+    // liberan sus registros), así cada borrado cuesta O(1) amortizado y borrar muchos es lineal.
+    // Si la partición queda demasiado chica, se une con una vecina.
+    void quitar(AlmacenContactos &almacen, size_t particion, size_t posicion)
+    {
+        Particion &actual = particiones[particion];
+        almacen.marcarBorrado(actual.contactos[posicion]);
+        actual.borrados++;
+        if (actual.borrados * 4 > actual.contactos.size())
+        {
+            compactar(almacen, particion);
+        }
+        unirSiHaceFalta(almacen, particion);
+    }
+
+    // Método para sacar de una partición el contacto de la posición 'posicion' sin borrarlo del almacén
+    // (para volver a insertarlo en otro lugar, por ejemplo cuando cambia su nombre). Corre los siguientes un lugar.
+    void extraer(AlmacenContactos &almacen, size_t particion, size_t posicion)
+    {
+        vector<uint32_t> &grupo = particiones[particion].contactos;
+        grupo.erase(grupo.begin() + static_cast<ptrdiff_t>(posicion));
+        unirSiHaceFalta(almacen, particion);
+    }
+
+    void incorporar(AlmacenContactos &almacen, const vector<uint32_t> &nuevos);
+    EstadisticasParticiones calcularEstadisticas() const;
+};
+
+// Estructura que agrupa el almacén de contactos, sus particiones por nombre, el índice por número y los
+// índices por apellido y por dominio del email
+// Si tiene un diario, cada cambio hecho con 'registrarContacto', 'modificarContacto' o 'borrarContacto' se anota en él
+struct AgendaContactos
+{
+    AlmacenContactos almacen;
+    ParticionesContactos particiones;
+    IndiceTelefonos indiceTelefonos;
+    IndicesGrupos indicesGrupos;
+    DiarioCambios *diario = nullptr;
+};
+
+// Función para insertar un contacto del almacén en su partición sin reordenar toda la agenda
+// Busca la partición por su nombre y, dentro de ella, la posición con 'upper_bound', así que solo se recorre
+// y desplaza esa partición.
+// Retorna 'false' si el nombre no comienza con una letra (ver 'calcularLetraInicial').
+bool insertarContactoOrdenado(AgendaContactos &agenda, uint32_t contacto);
+
+// Clase para agregar muchos contactos de una sola vez (importaciones y carga del archivo)
+// Los contactos se juntan sin ordenar; al confirmar el lote se ordenan una sola vez y se mezclan con los
+// que ya estaban en cada partición (ver 'ParticionesContactos::incorporar').
+class LoteDeContactos
+{
+private:
+    AgendaContactos &agenda;
+    vector<uint32_t> pendientes; // Contactos agregados desde la última confirmación, en orden de llegada
+    vector<uint8_t> letrasPendientes; // Letra inicial de cada pendiente (para repartirlos sin volver a leer el nombre)
+
+    struct ClaveYContacto
+    {
+        uint64_t prefijo; // Ver 'AlmacenContactos::getPrefijoClave'
+        uint32_t contacto;
+    };
+
+public:
+    // Constructor: el lote trabaja directamente sobre las particiones de la agenda
+    explicit LoteDeContactos(AgendaContactos &agenda) : agenda(agenda) {}
+
+    // Destructor: confirma los contactos pendientes para que ninguno quede fuera de las particiones
+    ~LoteDeContactos() { confirmar(); }
+
+    // El lote no se puede copiar (confirmaría dos veces los mismos contactos)
+    LoteDeContactos(const LoteDeContactos &) = delete;
+    LoteDeContactos &operator=(const LoteDeContactos &) = delete;
+
+    // Método para reservar lugar para 'cantidad' contactos pendientes
+    void reservar(size_t cantidad)
+    {
+        pendientes.reserve(cantidad);
+        letrasPendientes.reserve(cantidad);
+    }
+
+    // Método para agregar al lote un contacto que ya está en el almacén
+    // Retorna 'false' si el nombre no comienza con una letra (ver 'calcularLetraInicial')
+    bool agregar(uint32_t contacto)
+    {
+        int letraInicial = calcularLetraInicial(agenda.almacen.getNombre(contacto));
+        if (letraInicial < 0)
+        {
+            return false;
+        }
+        pendientes.push_back(contacto);
+        letrasPendientes.push_back(static_cast<uint8_t>(letraInicial));
+
+        // Los índices por número, apellido y dominio no dependen del orden, se actualizan de inmediato
+        agenda.indiceTelefonos.agregar(agenda.almacen.getNumeroEmpaquetado(contacto), contacto);
+        agenda.indicesGrupos.agregar(agenda.almacen, contacto);
+        return true;
+    }
+
+    // Método para confirmar el lote: ordena los pendientes y los mezcla con las particiones
+    void confirmar()
+    {
+        if (pendientes.empty())
+        {
+            return;
+        }
+        // 'stable_sort' respeta el orden de llegada de los nombres repetidos
+        // Si ya llegan ordenados (por ejemplo, desde el archivo binario) no se reordenan
+        const AlmacenContactos &almacen = agenda.almacen;
+        if (!is_sorted(pendientes.begin(), pendientes.end(), CompararContactosPorNombre{&almacen}))
+        {
+            // Primero se reparten por letra inicial (conteo estable) y después se ordena cada letra por separado:
+            // las letras van seguidas en el orden de los nombres y ordenar tramos chicos es más rápido que uno grande
+            size_t inicioLetra[27] = {};
+            for (uint8_t letra : letrasPendientes)
+            {
+                inicioLetra[letra + 1]++;
+            }
+            for (int letra = 0; letra < 26; ++letra)
+            {
+                inicioLetra[letra + 1] += inicioLetra[letra];
+            }
+            // Se ordenan pares (primeros 8 bytes de la clave, contacto) que están seguidos en memoria: casi todas
+            // las comparaciones se deciden con el entero, sin ir a buscar el registro ni el nombre al almacén
+            vector<ClaveYContacto> repartidos(pendientes.size());
+            size_t siguiente[26];
+            copy(inicioLetra, inicioLetra + 26, siguiente);
+            for (size_t i = 0; i < pendientes.size(); ++i)
+            {
+                repartidos[siguiente[letrasPendientes[i]]++] = {almacen.getPrefijoClave(pendientes[i]), pendientes[i]};
+            }
+            auto comparar = [&almacen](const ClaveYContacto &a, const ClaveYContacto &b)
+            {
+                if (a.prefijo != b.prefijo)
+                {
+                    return a.prefijo < b.prefijo;
+                }
+                return almacen.compararContactos(a.contacto, b.contacto) < 0;
+            };
+            for (int letra = 0; letra < 26; ++letra)
+            {
+                stable_sort(repartidos.begin() + inicioLetra[letra], repartidos.begin() + inicioLetra[letra + 1], comparar);
+            }
+            for (size_t i = 0; i < repartidos.size(); ++i)
+            {
+                pendientes[i] = repartidos[i].contacto;
+            }
+        }
+        agenda.particiones.incorporar(agenda.almacen, pendientes);
+        pendientes.clear();
+        letrasPendientes.clear();
+    }
+};
+
+// Configuración del diario de cambios (ver 'DiarioCambios')
+struct ConfiguracionDiario
+{
+    size_t entradasPorGrupo = 64;                     // Se escribe el grupo cuando junta tantas entradas...
+    chrono::milliseconds intervaloConfirmacion{20};   // ...o cuando la entrada más vieja lleva este tiempo esperando
+    bool sincronizarDisco = true;                     // Forzar la escritura en disco (fsync) en cada grupo
+    uint64_t bytesParaCompactar = 64ULL << 20;        // Tamaño del diario a partir del cual se compacta en segundo plano
+    size_t cambiosParaCompactar = 200000;             // ...o cantidad de cambios (0 = no se cuentan)
+    chrono::milliseconds intervaloCompactacion{chrono::minutes(5)}; // ...o tiempo que lleva el cambio más viejo fuera del archivo binario (0 = no se mide)
+    uint64_t bytesMaximosDiario = 256ULL << 20;       // Con una compactación en curso, el diario que llega a este tamaño se rota a un segmento nuevo (0 = no se rota)
+    bool comprimirInstantanea = false;                // Escribir el archivo binario compactado en el formato comprimido
+};
+
+// Tipos de entrada del diario de cambios
+enum TipoEntradaDiario : uint32_t
+{
+    ENTRADA_ALTA = 1,           // Contacto agregado
+    ENTRADA_EDICION = 2,        // Contacto modificado (se identifica por su nombre y número anteriores)
+    ENTRADA_BAJA = 3,           // Contacto eliminado (se identifica por su nombre y número)
+    ENTRADA_EDICION_EXACTA = 4, // Contacto modificado (se identifica por todos sus datos anteriores)
+    ENTRADA_BAJA_EXACTA = 5     // Contacto eliminado (se identifica por todos sus datos)
+};
+// Las ediciones y bajas se anotan con los tipos exactos: puede haber varios contactos con el mismo nombre y
+// número, y al reproducir el diario debe cambiar o desaparecer uno con los mismos datos que en memoria. Los
+// tipos 2 y 3 solo se leen (de diarios escritos antes).
+
+// Clase que registra cada cambio de la agenda al final de un archivo ("contactos.diario")
+// Así guardar cuesta lo que miden los cambios y no lo que mide la agenda, y un corte inesperado no pierde
+// lo que ya se confirmó. Cada entrada lleva un número de secuencia y su propia suma de verificación.
+// Las entradas se confirman por grupos: se escriben y sincronizan juntas cuando se juntan
+// 'entradasPorGrupo' o cuando pasa 'intervaloConfirmacion' (un hilo se encarga de esto último).
+// Cuando el diario crece más de 'bytesParaCompactar', junta 'cambiosParaCompactar' cambios o tiene un cambio
+// confirmado hace más de 'intervaloCompactacion', se rota: se renombra como un segmento ("contactos.diario.1",
+// ".2", ...) y un hilo en segundo plano aplica los segmentos sobre el archivo binario ("contactos.agdb") para
+// escribir uno nuevo (el guardado automático). La compactación lee los archivos y no la agenda en memoria, así
+// que el menú no la espera ni tiene que copiar nada. Si el diario llega a 'bytesMaximosDiario' antes de que
+// termine, también se rota y los cambios siguen en un diario nuevo (nunca esperan a la compactación); los
+// segmentos que se rotan así se compactan juntos apenas termina la compactación en curso.
+class DiarioCambios
+{
+private:
+    string rutaDiario;
+    string rutaInstantanea;
+    ConfiguracionDiario configuracion;
+    int descriptor;
+    uint64_t siguienteSecuencia;
+    uint64_t bytesEnArchivo;
+
+    mutex candado;
+    condition_variable avisoPendientes;
+    vector<char> pendientes; // Entradas ya serializadas que todavía no se escriben en el archivo
+    size_t entradasPendientes;
+    chrono::steady_clock::time_point inicioPendientes;
+    bool terminando;
+    thread hiloConfirmacion;
+
+    size_t cambiosSinCompactar; // Entradas confirmadas en el diario actual (que todavía no están en el archivo binario)
+    chrono::steady_clock::time_point inicioCambios; // Cuándo se confirmó la más vieja de ellas
+    thread hiloCompactacion;
+    atomic<bool> compactando;
+    bool segmentosEnEspera; // Se rotaron segmentos mientras se compactaba (se compactan cuando termine)
+
+    void abrirArchivo();
+    void rotarBloqueado();
+    void agregarEntrada(TipoEntradaDiario tipo, const vector<char> &carga);
+    void confirmarBloqueado();
+    void iniciarCompactacionBloqueado();
+    void esperarConfirmaciones();
+
+public:
+    DiarioCambios(const string &rutaDiario, const string &rutaInstantanea, uint64_t siguienteSecuencia,
+                  const ConfiguracionDiario &configuracion = ConfiguracionDiario());
+    ~DiarioCambios();
+
+    // El diario no se puede copiar (tiene hilos y un archivo abierto)
+    DiarioCambios(const DiarioCambios &) = delete;
+    DiarioCambios &operator=(const DiarioCambios &) = delete;
+
+    void registrarAlta(const AlmacenContactos &almacen, uint32_t contacto);
+    void registrarEdicion(string_view nombreAnterior, string_view apellidoAnterior, uint64_t numeroAnterior,
+                          string_view emailAnterior, const AlmacenContactos &almacen, uint32_t contacto);
+    void registrarBaja(const AlmacenContactos &almacen, uint32_t contacto);
+    size_t confirmar();
+};
+
+// Función para registrar un contacto nuevo en la agenda (almacén, partición por nombre e índice por número)
+// El número de celular debe estar validado. Retorna el índice del contacto en el almacén, o
+// 'numeric_limits<uint32_t>::max()' si el nombre no comienza con una letra (ver 'calcularLetraInicial') y no se registró.
+uint32_t registrarContacto(AgendaContactos &agenda, string_view nombre, string_view apellido,
+                           string_view numeroDeCelular, string_view email);
+
+// Cambios para 'actualizarContacto': solo se consideran los campos que tienen valor
+// Los textos no se copian: deben seguir existiendo hasta que termine la actualización.
+struct CambiosContacto
+{
+    optional<string_view> nombre;
+    optional<string_view> apellido;
+    optional<uint64_t> numero; // Número de celular empaquetado (ver 'empaquetarNumeroCelular')
+    optional<string_view> email;
+};
+
+// Función para actualizar los campos de un contacto registrado que realmente cambian
+// Compara cada campo con el actual y solo toca lo que difiere:
+//  - los textos se reescriben en su mismo lugar del almacén si entran (ver 'AlmacenContactos::reemplazarTextos');
+//  - el índice por número solo se actualiza si cambia el número;
+//  - el contacto solo se saca de su partición y se vuelve a insertar donde le corresponde si cambia su nombre
+//    (si no, quedaría fuera de orden y ni él ni sus vecinos se encontrarían con la búsqueda binaria).
+// El contacto conserva su índice en el almacén. Retorna 'false' si no cambió nada (y entonces no se anota en el diario).
+bool actualizarContacto(AgendaContactos &agenda, uint32_t contacto, const CambiosContacto &cambios);
+
+// Función para actualizar muchos contactos de una sola vez (por ejemplo, cambiar el dominio de miles de emails)
+// Igual que 'actualizarContacto' para cada uno, pero los que cambian de nombre se sacan de sus particiones y se
+// insertan todos juntos al final: se ordenan y se mezclan de una pasada, como en 'LoteDeContactos'.
+// Retorna la cantidad de contactos que cambiaron.
+size_t actualizarContactos(AgendaContactos &agenda, const vector<pair<uint32_t, CambiosContacto>> &cambios);
+
+// Función para cambiar el dominio de los emails de toda la agenda ("usuario@viejo" pasa a "usuario@nuevo")
+// Recorre el almacén una vez; ningún contacto cambia de partición. Retorna la cantidad de emails cambiados.
+size_t cambiarDominioEmails(AgendaContactos &agenda, string_view dominioViejo, string_view dominioNuevo);
+
+// Función para reemplazar todos los datos de un contacto registrado (ver 'actualizarContacto')
+void modificarContacto(AgendaContactos &agenda, uint32_t contacto, string_view nombre, string_view apellido,
+                       string_view numeroDeCelular, string_view email);
+
+// Función para borrar el contacto que está en la posición 'posicion' de la partición 'particion'
+// Lo quita del índice por número, libera su registro en el almacén y lo saca de la partición
+void borrarContacto(AgendaContactos &agenda, size_t particion, size_t posicion);
+
+// Función para localizar un contacto por su nombre exacto y su número de celular
+// Si hay varios contactos con el mismo nombre, se recorren todos hasta encontrar el del número.
+// Retorna 'true' y guarda su partición y su posición dentro de la partición si lo encuentra.
+bool localizarContacto(const AgendaContactos &agenda, string_view nombre, uint64_t numero, size_t &particion, size_t &posicion);
+
+// Función para localizar un contacto por su número de celular (búsqueda inversa)
+// Retorna 'true' y guarda en 'contacto' el índice del primer contacto con ese número si lo encuentra
+bool localizarPorNumero(const AgendaContactos &agenda, uint64_t numero, uint32_t &contacto);
+
+// Función para recorrer los contactos de un grupo ordenado cuyo nombre comienza con un prefijo
+// Recibe la clave de orden del prefijo (ver 'calcularClaveOrden'), así no se calcula en cada grupo.
+// Como el grupo está ordenado, los nombres que comienzan con el prefijo están juntos: se ubica el primero
+// con 'lower_bound' y se recorren en orden hasta 'limite' resultados. Retorna la cantidad de contactos visitados.
+template <typename Visitante>
+size_t recorrerPrefijoEnGrupo(const AlmacenContactos &almacen, const vector<uint32_t> &grupo, string_view clavePrefijo,
+                              size_t limite, Visitante visitar)
+{
+    auto primero = lower_bound(grupo.begin(), grupo.end(), clavePrefijo, [&](uint32_t contacto, string_view buscada)
+                               { return almacen.compararConPrefijoClave(contacto, buscada) < 0; });
+
+    size_t visitados = 0;
+    for (auto posicion = primero; posicion != grupo.end() && visitados < limite; ++posicion)
+    {
+        if (almacen.compararConPrefijoClave(*posicion, clavePrefijo) != 0)
+        {
+            break;
+        }
+        // Las lápidas (contactos borrados que siguen en la partición) no se visitan
+        if (!almacen.estaActivo(*posicion))
+        {
+            continue;
+        }
+        visitar(*posicion);
+        visitados++;
+    }
+    return visitados;
+}
+
+// Función para buscar los contactos cuyo nombre comienza con un prefijo (autocompletado)
+// No distingue mayúsculas, minúsculas ni acentos. Recorre con 'recorrerPrefijoEnGrupo' la primera partición que puede
+// tener esos nombres y sigue con las siguientes mientras terminen con nombres que comienzan con el prefijo.
+// 'visitar' recibe el índice de cada contacto en el almacén (no se copia ningún contacto).
+// Retorna la cantidad de contactos visitados.
+template <typename Visitante>
+size_t buscarPorPrefijo(const AgendaContactos &agenda, string_view prefijo, size_t limite, Visitante visitar)
+{
+    if (calcularLetraInicial(prefijo) < 0 || limite == 0)
+    {
+        return 0;
+    }
+    const ParticionesContactos &particiones = agenda.particiones;
+    string clavePrefijo = calcularClaveOrden(prefijo);
+    size_t visitados = 0;
+    for (size_t particion = particiones.ubicarPrefijo(clavePrefijo); particion < particiones.getCantidad() && visitados < limite;
+         ++particion)
+    {
+        const vector<uint32_t> &grupo = particiones.getContactos(particion);
+        visitados += recorrerPrefijoEnGrupo(agenda.almacen, grupo, clavePrefijo, limite - visitados, visitar);
+        if (!grupo.empty() && agenda.almacen.compararConPrefijoClave(grupo.back(), clavePrefijo) > 0)
+        {
+            break;
+        }
+    }
+    return visitados;
+}
+
+// Función para buscar los contactos con un apellido, con un dominio de email o con los dos a la vez
+// Un criterio vacío no se usa (al menos uno debe tener valor). No distingue mayúsculas, minúsculas ni acentos.
+// Con un solo criterio recorre solo su lista en el índice, así tarda lo que mide el resultado y no lo que mide
+// la agenda; con los dos, avanza por las dos listas a la vez saltando en cada una hasta el contacto actual de
+// la otra, así tarda a lo sumo lo que mide la más corta. La primera consulta construye los índices.
+// 'visitar' recibe el índice en el almacén de los primeros 'limite' contactos (de menor a mayor índice).
+// Retorna la cantidad total de contactos que cumplen los criterios, aunque sean más que 'limite'.
+template <typename Visitante>
+size_t buscarPorGrupo(AgendaContactos &agenda, string_view apellido, string_view dominio, size_t limite, Visitante visitar)
+{
+    if (apellido.empty() && dominio.empty())
+    {
+        return 0;
+    }
+    agenda.indicesGrupos.construir(agenda.almacen);
+    const ListaContactos *porApellido = apellido.empty() ? nullptr : agenda.indicesGrupos.buscarApellido(apellido);
+    const ListaContactos *porDominio = dominio.empty() ? nullptr : agenda.indicesGrupos.buscarDominio(dominio);
+    if ((!apellido.empty() && porApellido == nullptr) || (!dominio.empty() && porDominio == nullptr))
+    {
+        return 0;
+    }
+
+    // Un solo criterio: la cantidad ya está en la lista
+    if (porApellido == nullptr || porDominio == nullptr)
+    {
+        const ListaContactos &lista = porApellido != nullptr ? *porApellido : *porDominio;
+        size_t visitados = 0;
+        for (CursorLista cursor(lista); !cursor.haTerminado() && visitados < limite; cursor.avanzar())
+        {
+            visitar(cursor.getContacto());
+            visitados++;
+        }
+        return lista.getCantidad();
+    }
+
+    // Los dos criterios: intersección de las listas
+    CursorLista cursorApellido(*porApellido), cursorDominio(*porDominio);
+    size_t encontrados = 0;
+    while (!cursorApellido.haTerminado())
+    {
+        uint32_t contacto = cursorApellido.getContacto();
+        cursorDominio.avanzarHasta(contacto);
+        if (cursorDominio.haTerminado())
+        {
+            break;
+        }
+        if (cursorDominio.getContacto() == contacto)
+        {
+            if (encontrados < limite)
+            {
+                visitar(contacto);
+            }
+            encontrados++;
+            cursorApellido.avanzar();
+        }
+        else
+        {
+            cursorApellido.avanzarHasta(cursorDominio.getContacto());
+        }
+    }
+    return encontrados;
+}
+
+// Función de referencia para la distancia de edición (Levenshtein) entre dos nombres
+// Programación dinámica clásica, fila por fila, sobre las claves de orden de los nombres: las mayúsculas y los
+// acentos no cuentan como ediciones ("Jose" y "José" están a distancia 0) y la ñ es un solo carácter.
+// Es lenta (O(n*m)) pero simple; el programa de mediciones la usa para comprobar 'buscarAproximado'.
+int distanciaLevenshtein(string_view a, string_view b);
+
+// Clase con el patrón de búsqueda preparado para el algoritmo de bits en paralelo de Myers (variante de Hyyrö)
+// Cada columna de la matriz de programación dinámica se representa con dos palabras de 64 bits (diferencias
+// verticales positivas y negativas), así que cada carácter del texto se procesa con unas pocas operaciones
+// de bits en lugar de recorrer toda la columna. Solo sirve para patrones de hasta 64 caracteres.
+// El patrón y los textos son claves de orden (ver 'calcularClaveOrden'), que ya vienen sin mayúsculas ni
+// acentos y con un byte por carácter, así que se comparan byte a byte.
+class PatronAproximado
+{
+private:
+    uint64_t mascaraPorCaracter[256]; // Bits de las posiciones del patrón donde aparece cada carácter
+    string_view patron;
+
+public:
+    // Constructor: prepara las máscaras del patrón
+    explicit PatronAproximado(string_view patron) : patron(patron)
+    {
+        fill(begin(mascaraPorCaracter), end(mascaraPorCaracter), 0);
+        for (size_t i = 0; i < patron.size() && i < 64; ++i)
+        {
+            mascaraPorCaracter[static_cast<unsigned char>(patron[i])] |= 1ULL << i;
+        }
+    }
+
+    // Método que indica si el patrón cabe en una palabra de 64 bits
+    bool cabeEnPalabra() const { return !patron.empty() && patron.size() <= 64; }
+
+    // Método para calcular la distancia de edición entre el patrón y un texto
+    // Si se sabe que la distancia será mayor que 'maximo', se detiene antes y retorna un valor mayor que 'maximo'
+    int distanciaEdicionBits(string_view texto, int maximo) const
+    {
+        const int longitud = static_cast<int>(patron.size());
+        const uint64_t ultimoBit = 1ULL << (longitud - 1);
+        uint64_t positivosVerticales = ~0ULL;
+        uint64_t negativosVerticales = 0;
+        int distancia = longitud;
+        const int largoTexto = static_cast<int>(texto.size());
+
+        for (int j = 0; j < largoTexto; ++j)
+        {
+            uint64_t coincidencias = mascaraPorCaracter[static_cast<unsigned char>(texto[j])];
+            uint64_t xVertical = coincidencias | negativosVerticales;
+            uint64_t xHorizontal = (((coincidencias & positivosVerticales) + positivosVerticales) ^ positivosVerticales) | coincidencias;
+            uint64_t positivosHorizontales = negativosVerticales | ~(xHorizontal | positivosVerticales);
+            uint64_t negativosHorizontales = positivosVerticales & xHorizontal;
+
+            // La última fila de la columna es la distancia entre el patrón y el texto leído hasta ahora
+            if (positivosHorizontales & ultimoBit)
+            {
+                distancia++;
+            }
+            else if (negativosHorizontales & ultimoBit)
+            {
+                distancia--;
+            }
+
+            // Cada carácter restante del texto puede bajar la distancia en 1 como mucho
+            if (distancia - (largoTexto - j - 1) > maximo)
+            {
+                return maximo + 1;
+            }
+
+            // La fila 0 crece en 1 por columna (distancia contra el texto vacío), por eso entra un 1 por la derecha
+            positivosHorizontales = (positivosHorizontales << 1) | 1;
+            negativosHorizontales <<= 1;
+            positivosVerticales = negativosHorizontales | ~(xVertical | positivosHorizontales);
+            negativosVerticales = positivosHorizontales & xVertical;
+        }
+        return distancia;
+    }
+};
+
+// Estructura con un resultado de la búsqueda aproximada
+struct ResultadoAproximado
+{
+    uint32_t contacto; // Índice del contacto en el almacén
+    int distancia;     // Distancia de edición entre su nombre y la consulta (sin contar mayúsculas ni acentos)
+};
+
+// Función para buscar los contactos cuyo nombre está a lo sumo a 'distanciaMaxima' ediciones de la consulta
+// (tolera errores de escritura como "Jaun" por "Juan"). Retorna los 'cantidadMaxima' más cercanos, ordenados
+// por distancia y luego por nombre. Se comparan las claves de orden, así "Jose" encuentra a "José" a distancia 0.
+// Se recorren las particiones, que tienen las claves en orden, como si fueran un árbol de prefijos: la tabla
+// de la distancia de edición se calcula una fila por carácter y las claves que comienzan igual que la anterior
+// reutilizan esas filas. Cuando ninguna casilla de una fila llega al límite, ningún nombre que comience con
+// esos caracteres puede estar cerca y se saltan todos juntos (con una búsqueda en la partición), así que solo
+// se leen los contactos de las ramas cercanas a la consulta y no toda la agenda.
+vector<ResultadoAproximado> buscarAproximado(const AgendaContactos &agenda, string_view consulta, int distanciaMaxima,
+                                             size_t cantidadMaxima);
+
+// DETECCIÓN Y FUSIÓN DE CONTACTOS DUPLICADOS
+// Agregar un contacto no revisa si ya existe, así que importar dos veces el mismo archivo repite todos sus
+// contactos (y buscar por nombre encuentra cualquiera de las copias). 'detectarDuplicados' junta los contactos
+// que probablemente son la misma persona y 'fusionarDuplicados' deja uno solo por grupo.
+// La detección no compara todos con todos: cada contacto produce una clave por criterio (su número, su email
+// normalizado o su nombre completo plegado) y las claves se reparten por su valor de dispersión entre varios
+// hilos. Cada hilo ordena su parte y solo compara los contactos con la misma clave; los que coinciden se unen
+// en una estructura de conjuntos disjuntos (union-find) compartida y sin candados, así los grupos salen
+// completos aunque cada par se haya encontrado por un criterio distinto o en otro hilo.
+
+// Criterios por los que dos contactos se consideran duplicados (se combinan con '|')
+enum CriterioDuplicado : uint8_t
+{
+    DUPLICADO_NUMERO = 1, // Mismo número de celular
+    DUPLICADO_EMAIL = 2,  // Mismo email normalizado (ver 'normalizarEmail')
+    DUPLICADO_NOMBRE = 4  // Mismo nombre y apellido, sin distinguir mayúsculas, minúsculas ni acentos
+};
+
+// Políticas para fusionar un grupo de duplicados
+enum PoliticaFusion
+{
+    FUSION_PRIMERO, // Se conserva el contacto de menor índice en el almacén (normalmente el más antiguo)
+    FUSION_ULTIMO,  // Se conserva el de mayor índice (normalmente el último importado)
+    FUSION_MAYORIA  // Se conserva el de menor índice, pero cada campo toma el valor más repetido del grupo
+};
+
+// Configuración de 'detectarDuplicados'
+struct ConfiguracionDuplicados
+{
+    uint8_t criterios = DUPLICADO_NUMERO | DUPLICADO_EMAIL;
+    int distanciaNombre = 2; // Por número o por email, además los nombres completos deben estar a lo sumo a esta
+                             // distancia de edición (ver 'sonNombresParecidos'); -1 = no se exige
+    size_t hilos = 0;        // 0 = uno por núcleo
+};
+
+// Grupos de contactos duplicados que encontró 'detectarDuplicados'
+// Los contactos de todos los grupos van seguidos en 'contactos': el grupo g ocupa de 'inicioGrupos[g]' a
+// 'inicioGrupos[g + 1]' (sin incluirlo), de menor a mayor índice. Los grupos van ordenados por su primer contacto.
+struct GruposDuplicados
+{
+    vector<uint32_t> contactos;
+    vector<size_t> inicioGrupos{0};
+    vector<uint8_t> criterios; // Criterios que unieron a los contactos de cada grupo ('CriterioDuplicado')
+    size_t comparaciones = 0;  // Pares de contactos con la misma clave que se compararon
+
+    size_t getCantidadGrupos() const { return criterios.size(); }
+    size_t getCantidadDuplicados() const { return contactos.size() - criterios.size(); } // Los que sobran
+};
+
+// Función para normalizar un email antes de compararlo: pasa las letras a minúscula y descarta la etiqueta
+// del usuario ("Juan.Perez+trabajo@Correo.com" queda "juan.perez@correo.com"). El resultado va en 'normalizado'.
+void normalizarEmail(string_view email, string &normalizado);
+
+// Función para decidir si dos contactos tienen nombres completos parecidos: la distancia de edición entre sus
+// nombres más la distancia entre sus apellidos no pasa de 'distanciaMaxima' (sin distinguir mayúsculas,
+// minúsculas ni acentos)
+bool sonNombresParecidos(const AlmacenContactos &almacen, uint32_t a, uint32_t b, int distanciaMaxima);
+
+// Función para encontrar los grupos de contactos duplicados de la agenda (no la modifica)
+// Un contacto puede unirse a un grupo por cualquiera de los criterios de la configuración, así que un grupo puede
+// tener contactos que solo coinciden de a pares (A con B por el número y B con C por el email).
+GruposDuplicados detectarDuplicados(const AgendaContactos &agenda, const ConfiguracionDuplicados &configuracion);
+
+// Función para decidir cómo se fusiona el grupo 'grupo' según la política
+// Retorna el contacto que se conserva; con FUSION_MAYORIA guarda en 'cambios' los valores que recibe (apuntan
+// al almacén, así que solo valen hasta la siguiente modificación de la agenda).
+uint32_t prepararFusion(const AlmacenContactos &almacen, const GruposDuplicados &grupos, size_t grupo,
+                        PoliticaFusion politica, CambiosContacto &cambios);
+
+// Función para fusionar los grupos de duplicados: en cada grupo conserva un contacto (ver 'prepararFusion') y
+// borra los demás. Los grupos deben venir de 'detectarDuplicados' sobre la agenda tal como está.
+// Retorna la cantidad de contactos borrados.
+size_t fusionarDuplicados(AgendaContactos &agenda, const GruposDuplicados &grupos, PoliticaFusion politica);
+
+// Clase que mapea un archivo completo en memoria para leerlo sin copias intermedias
+// En sistemas POSIX usa mmap; en Windows lee el archivo completo a un búfer
+class ArchivoMapeado
+{
+private:
+    const char *datos;
+    size_t tamano;
+#ifndef _WIN32
+    void *mapeo;
+#else
+    string contenido;
+#endif
+
+public:
+    // Constructor: abre y mapea el archivo, lanza una excepción si no se puede leer
+    explicit ArchivoMapeado(const string &ruta) : datos(nullptr), tamano(0)
+    {
+#ifndef _WIN32
+        mapeo = nullptr;
+        int descriptor = open(ruta.c_str(), O_RDONLY);
+        if (descriptor < 0)
+        {
+            throw runtime_error("No se pudo abrir el archivo " + ruta + ".");
+        }
+
+        struct stat informacion;
+        if (fstat(descriptor, &informacion) != 0)
+        {
+            close(descriptor);
+            throw runtime_error("No se pudo leer el tamaño del archivo " + ruta + ".");
+        }
+        tamano = static_cast<size_t>(informacion.st_size);
+
+        // Un archivo vacío no se puede mapear, simplemente no tiene datos
+        if (tamano > 0)
+        {
+            mapeo = mmap(nullptr, tamano, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (mapeo == MAP_FAILED)
+            {
+                close(descriptor);
+                throw runtime_error("No se pudo mapear el archivo " + ruta + " en memoria.");
+            }
+            // Se avisa al sistema que el archivo se leerá de principio a fin
+            madvise(mapeo, tamano, MADV_SEQUENTIAL);
+            datos = static_cast<const char *>(mapeo);
+        }
+        // El mapeo sigue siendo válido después de cerrar el descriptor
+        close(descriptor);
+#else
+        ifstream archivo(ruta, ios::in | ios::binary);
+        if (!archivo.is_open())
+        {
+            throw runtime_error("No se pudo abrir el archivo " + ruta + ".");
+        }
+        contenido.assign(istreambuf_iterator<char>(archivo), istreambuf_iterator<char>());
+        datos = contenido.data();
+        tamano = contenido.size();
+#endif
+    }
+
+    // Destructor: libera el mapeo del archivo
+    ~ArchivoMapeado()
+    {
+#ifndef _WIN32
+        if (mapeo != nullptr)
+        {
+            munmap(mapeo, tamano);
+        }
+#endif
+    }
+
+    // El mapeo no se puede copiar (se liberaría dos veces)
+    ArchivoMapeado(const ArchivoMapeado &) = delete;
+    ArchivoMapeado &operator=(const ArchivoMapeado &) = delete;
+
+    // Getters: Métodos para obtener los datos mapeados y su tamaño
+    const char *getDatos() const { return datos; }
+    size_t getTamano() const { return tamano; }
+};
+
+// Estructura con los campos de un contacto leídos de una línea del archivo
+struct CamposContacto
+{
+    string_view nombre;
+    string_view apellido;
+    string_view numeroDeCelular;
+    string_view email;
+};
+
+// Función para interpretar una línea de "contactos.txt" con el formato que escribe 'contactoArchivado'
+// El nombre es la primera palabra, el email la última y el número la penúltima; lo que queda en medio es el apellido.
+// Los campos quedan en 'campos' apuntando a la propia línea (sin copiarlos). Solo separa los campos: la carga
+// los valida por lotes con 'validarCamposEnLote'.
+// Retorna 'false' si la línea no tiene al menos cuatro palabras.
+bool interpretarLineaContacto(const char *inicio, const char *fin, CamposContacto &campos);
+
+// Función para validar de una vez muchos contactos leídos del archivo (importación masiva)
+// Aplica las mismas reglas que al agregar un contacto desde el menú (letra inicial, 'validarNumeroCelular' y
+// 'validarEmail'), pero con instrucciones vectoriales (SSE2, y AVX2 si se compila con -mavx2): los 10 dígitos
+// del número se comprueban con una sola comparación y el '@' y el '.' del email se buscan de a 16 (o 32) bytes.
+// Marca en 'fallas' los contactos no válidos, un bit por contacto (el bit i % 64 de fallas[i / 64]); los bits
+// de los contactos válidos no se tocan, así que 'fallas' debe empezar en cero.
+void validarCamposEnLote(const CamposContacto *campos, size_t cantidad, uint64_t *fallas);
+
+// Función para cargar los contactos guardados en "contactos.txt" al iniciar el programa
+// El archivo se mapea en memoria y se divide en fragmentos (cortados en saltos de línea) que se
+// interpretan en paralelo. Cada hilo llena su propio almacén; al final se unen al de la agenda y un lote
+// ordena los contactos una sola vez y los reparte en las particiones. Retorna la cantidad de contactos cargados.
+size_t cargarContactos(AgendaContactos &agenda, const string &rutaArchivo);
+
+// Función para guardar la agenda completa en el formato binario (ver 'CabeceraInstantanea')
+// 'secuenciaDiario' es la última entrada del diario de cambios que ya está aplicada en la agenda.
+// Si 'comprimir' es verdadero usa el formato comprimido (ver 'CabeceraComprimida'): nombres y apellidos con
+// prefijo común, números de cada bloque ordenados y guardados como diferencias (o empaquetados en 34 bits si
+// están muy dispersos) y diccionarios de apellidos y dominios de email.
+// Se escribe primero un archivo temporal y luego se renombra sobre el anterior.
+// Lanza una excepción si no se puede escribir el archivo.
+void guardarInstantanea(const AgendaContactos &agenda, const string &rutaArchivo, uint64_t secuenciaDiario = 0,
+                        bool comprimir = false);
+
+// Función para cargar en la agenda los contactos del archivo binario (en cualquiera de los dos formatos)
+// Los registros ya vienen ordenados por nombre, así que el lote no tiene que reordenarlos.
+// Guarda en 'secuenciaDiario' la última entrada del diario incluida en el archivo y, si 'informar'
+// es verdadero, muestra el tiempo de carga.
+// Retorna la cantidad de contactos cargados; lanza una excepción si el archivo no es válido.
+size_t cargarInstantanea(AgendaContactos &agenda, const string &rutaArchivo, uint64_t &secuenciaDiario, bool informar = true);
+
+// Función para listar los segmentos rotados de un diario ("contactos.diario.1", ".2", ...) que existen,
+// del más viejo al más nuevo (el orden de sus entradas)
+vector<string> listarSegmentosDiario(const string &rutaDiario);
+
+// Función para aplicar a la agenda las entradas de un archivo del diario posteriores a 'secuenciaBase'
+// La lectura se detiene en la primera entrada incompleta o con la suma de verificación equivocada (lo que
+// queda de un corte inesperado). Actualiza 'ultimaSecuencia' con la mayor secuencia leída y suma a
+// 'aplicadas' las entradas aplicadas. Retorna cuántos bytes del archivo son entradas válidas.
+uint64_t reproducirDiario(AgendaContactos &agenda, const string &rutaDiario, uint64_t secuenciaBase,
+                          uint64_t &ultimaSecuencia, size_t &aplicadas);
+
+// Función para recuperar la agenda al iniciar el programa
+// Carga el archivo binario (o, si no lo hay o está dañado, el de texto) y le aplica las entradas del diario
+// de cambios posteriores a él: primero las de los segmentos rotados que quedaron (del más viejo al más nuevo)
+// y luego las del diario actual.
+// Si el archivo binario no existe o no está en el formato pedido con 'comprimir', lo vuelve a escribir.
+// Retorna la secuencia de la última entrada del diario que quedó aplicada.
+uint64_t recuperarAgenda(AgendaContactos &agenda, bool comprimir = false);
+
+// Copia inmutable de una partición de la agenda, para los lectores del modo servicio
+// Se arma una sola vez a partir de la agenda y después nadie la modifica, así que muchos hilos pueden leerla
+// a la vez sin candados. Tiene su propio almacén (con los contactos activos ya en orden por nombre: el
+// contacto i del grupo es el registro i del almacén), su índice por número y el límite inferior de la
+// partición, para ubicarla.
+struct GrupoInmutable
+{
+    string limiteInferior;
+    string claveLimite;
+    AlmacenContactos almacen;
+    vector<uint32_t> contactos; // 0, 1, ..., n - 1 (para usar 'busquedaBinaria' y 'recorrerPrefijoEnGrupo')
+    IndiceTelefonos indiceTelefonos;
+};
+
+// Función para armar la copia inmutable de la partición 'particion' de la agenda
+GrupoInmutable *copiarParticion(const AgendaContactos &agenda, size_t particion);
+
+// Fragmento inmutable del índice por número de una versión publicada
+// Los números se reparten entre los fragmentos con un hash, así un cambio copia solo el fragmento de su número
+// (unos cientos de entradas) y no todo el índice. Cada entrada tiene el número y el nombre del contacto (con
+// el nombre se ubica su grupo, y en el grupo se busca el número); están ordenadas por número y, entre los
+// iguales, por nombre.
+struct FragmentoTelefonos
+{
+    vector<uint64_t> numeros;
+    vector<uint32_t> finNombres; // Fin del nombre de cada entrada en 'nombres' (comienza donde termina el anterior)
+    string nombres;
+
+    size_t getCantidad() const { return numeros.size(); }
+    string_view getNombre(size_t entrada) const
+    {
+        uint32_t inicio = entrada == 0 ? 0 : finNombres[entrada - 1];
+        return string_view(nombres.data() + inicio, finNombres[entrada] - inicio);
+    }
+};
+
+// Versión publicada de la agenda: un grupo inmutable por partición (en el orden de las particiones) y el índice
+// por número repartido en fragmentos (la cantidad de fragmentos es una potencia de 2)
+// Al publicar una versión nueva solo se copian los grupos y los fragmentos que cambiaron; los demás se
+// comparten con la anterior.
+struct VersionAgenda
+{
+    vector<const GrupoInmutable *> grupos;
+    vector<uint64_t> prefijosLimite; // Prefijo de la clave del límite de cada grupo (ver 'calcularPrefijoClave')
+    vector<const FragmentoTelefonos *> telefonos;
+    uint64_t numero; // Crece de uno en uno con cada publicación
+};
+
+// Clase que publica versiones de la agenda para lectores concurrentes (RCU con épocas)
+// Los lectores nunca se bloquean: anuncian la época en la que entran, leen la versión actual y al salir
+// borran su anuncio. Quien publica reemplaza la versión de un solo golpe (puntero atómico) y guarda la
+// anterior (y sus grupos y fragmentos reemplazados) como retirada; la libera recién cuando todos los lectores
+// que siguen dentro entraron en una época posterior, porque esos ya no pueden estar leyéndola.
+// Solo un hilo a la vez puede llamar a 'publicar'; cada hilo lector usa su propia ranura.
+class PublicadorVersiones
+{
+private:
+    static constexpr size_t MAXIMO_LECTORES = 256;
+
+    // Cada ranura ocupa su propia línea de caché, así los lectores no se estorban entre sí
+    struct alignas(64) RanuraLector
+    {
+        atomic<uint64_t> epoca{0}; // 0 si el lector no está leyendo
+        atomic<bool> ocupada{false};
+    };
+
+    // Versión, grupo o fragmento reemplazado que espera a que ningún lector pueda estar usándolo
+    struct Retirado
+    {
+        uint64_t epoca;
+        const VersionAgenda *version;
+        const GrupoInmutable *grupo;
+        const FragmentoTelefonos *fragmento;
+    };
+
+    RanuraLector ranuras[MAXIMO_LECTORES];
+    atomic<const VersionAgenda *> actual;
+    atomic<uint64_t> epocaGlobal;
+    vector<Retirado> retirados; // Solo lo usa el hilo que publica
+
+    void liberarRetirados();
+
+public:
+    // Constructor: publica la primera versión con una copia de todas las particiones de la agenda
+    explicit PublicadorVersiones(const AgendaContactos &agenda);
+    ~PublicadorVersiones();
+
+    // El publicador no se puede copiar (es dueño de las versiones)
+    PublicadorVersiones(const PublicadorVersiones &) = delete;
+    PublicadorVersiones &operator=(const PublicadorVersiones &) = delete;
+
+    // Métodos para que un hilo lector obtenga y devuelva su ranura (retorna -1 si no quedan ranuras)
+    int registrarLector();
+    void liberarLector(int ranura);
+
+    // Métodos para leer: 'entrar' retorna la versión actual, que sigue siendo válida hasta 'salir'
+    const VersionAgenda *entrar(int ranura);
+    void salir(int ranura);
+
+    // Método para publicar una versión nueva copiando de la agenda las particiones donde van 'nombresCambiados'
+    // (todas si 'todoCambio' es verdadero) y las que cambiaron de límites al dividirse o unirse. Las demás se
+    // comparten con la versión anterior, así que una escritura copia una partición y no la agenda.
+    // La agenda no debe cambiar mientras se copia (quien publica debe tener el candado de los escritores).
+    void publicar(const AgendaContactos &agenda, const vector<string> &nombresCambiados, bool todoCambio);
+
+    uint64_t getNumeroVersion() const { return actual.load(memory_order_acquire)->numero; }
+};
+
+// Funciones de consulta sobre una versión publicada (las mismas búsquedas del menú, sin tocar la agenda)
+// 'ubicarEnVersion' retorna el grupo cuyo rango contiene el nombre (búsqueda binaria sobre los límites).
+size_t ubicarEnVersion(const VersionAgenda &version, const ClaveOrden &buscada);
+// 'buscarEnVersion' retorna 'true' y guarda el grupo y el contacto (índice en el almacén del grupo) si encuentra el nombre.
+bool buscarEnVersion(const VersionAgenda &version, string_view nombre, const GrupoInmutable *&grupo, uint32_t &contacto);
+// 'buscarNumeroEnVersion' busca el número en su fragmento del índice y el contacto en el grupo de su nombre.
+bool buscarNumeroEnVersion(const VersionAgenda &version, uint64_t numero, const GrupoInmutable *&grupo, uint32_t &contacto);
+
+// Función para recorrer los contactos de una versión publicada cuyo nombre comienza con un prefijo (como
+// 'buscarPorPrefijo': desde el primer grupo que puede tenerlos y siguiendo mientras terminen con el prefijo)
+// 'visitar' recibe el grupo y el índice del contacto en su almacén. Retorna la cantidad de contactos visitados.
+template <typename Visitante>
+size_t buscarPrefijoEnVersion(const VersionAgenda &version, string_view prefijo, size_t limite, Visitante visitar)
+{
+    if (calcularLetraInicial(prefijo) < 0 || limite == 0)
+    {
+        return 0;
+    }
+    string clavePrefijo = calcularClaveOrden(prefijo);
+    auto primero = partition_point(version.grupos.begin() + 1, version.grupos.end(), [&](const GrupoInmutable *grupo)
+                                   { return compararClaveConPrefijo(grupo->claveLimite, clavePrefijo) < 0; }) - 1;
+    size_t visitados = 0;
+    for (auto actual = primero; actual != version.grupos.end() && visitados < limite; ++actual)
+    {
+        const GrupoInmutable &grupo = **actual;
+        visitados += recorrerPrefijoEnGrupo(grupo.almacen, grupo.contactos, clavePrefijo, limite - visitados,
+                                            [&](uint32_t contacto) { visitar(grupo, contacto); });
+        if (!grupo.contactos.empty() && grupo.almacen.compararConPrefijoClave(grupo.contactos.back(), clavePrefijo) > 0)
+        {
+            break;
+        }
+    }
+    return visitados;
+}
+
+// ALMACENAMIENTO EN DISCO (MODO FUERA DE MEMORIA)
+// Para agendas que no entran en la memoria, los contactos pueden vivir en un árbol B+ guardado en un archivo
+// ("contactos.arbol") de páginas de 8 KB, del que solo una cantidad fija de páginas está en memoria a la vez
+// (ver 'BuferPaginas'). Las hojas tienen los contactos ordenados por nombre (y por número entre los que se
+// llaman igual, y por número de copia entre los que además tienen el mismo número) y cada una apunta a la
+// siguiente; las páginas internas guardan el nombre, el número y la copia con que comienza cada hija. Con 100 millones de contactos hay cerca de un millón de hojas y las páginas
+// internas ocupan unos 25 MB, así que quedan en el búfer y buscar un contacto lee del disco solo su hoja.
+
+// Tamaño de cada página del archivo del árbol
+constexpr size_t TAMANO_PAGINA = 8192;
+
+// Marca de "ninguna página" (marco libre, página que no está en el búfer, hoja sin siguiente)
+constexpr uint32_t PAGINA_NINGUNA = numeric_limits<uint32_t>::max();
+
+// Clase que mantiene en memoria una cantidad fija de páginas de un archivo (búfer de páginas)
+// Una página se lee del disco la primera vez que se pide y queda en un marco del búfer. Cuando no hay marcos
+// libres se reemplaza una con el algoritmo del reloj (CLOCK): una manecilla recorre los marcos en círculo,
+// a los que se usaron desde su vuelta anterior les quita la marca y reemplaza el primero que no la tiene
+// (si está modificado, antes lo escribe en el disco). Así se parece a reemplazar la usada hace más tiempo
+// (LRU) sin reordenar nada en cada acceso. Una página fijada no se reemplaza hasta que se suelta.
+// No es seguro usarlo desde varios hilos.
+class BuferPaginas
+{
+private:
+    string ruta;
+    int descriptor;
+    vector<char> memoria;            // Los marcos, uno tras otro
+    vector<uint32_t> paginaDelMarco; // Página que está en cada marco (PAGINA_NINGUNA si está libre)
+    vector<uint32_t> fijaciones;     // Cuántas veces está fijada la página de cada marco
+    vector<uint8_t> usado;           // Marca del reloj: la página se usó desde la última vuelta de la manecilla
+    vector<uint8_t> modificado;      // La página cambió y hay que escribirla antes de reemplazarla
+    vector<uint32_t> marcoDePagina;  // Marco de cada página del archivo (PAGINA_NINGUNA si no está en el búfer)
+    uint32_t manecilla;
+    uint64_t lecturas;
+    uint64_t escrituras;
+
+    void leerPagina(uint32_t pagina, char *destino);
+    void escribirPagina(uint32_t pagina, const char *origen);
+    uint32_t conseguirMarco();
+
+public:
+    // Constructor: abre (o, si 'crear' es verdadero, crea vacío) el archivo y reserva los marcos que entran
+    // en 'bytesMemoria'. Lanza una excepción si no se puede abrir el archivo.
+    BuferPaginas(const string &ruta, size_t bytesMemoria, bool crear);
+    ~BuferPaginas();
+
+    // El búfer no se puede copiar (tiene el archivo abierto)
+    BuferPaginas(const BuferPaginas &) = delete;
+    BuferPaginas &operator=(const BuferPaginas &) = delete;
+
+    // Métodos para fijar una página (la lee si no está en el búfer) y soltarla; 'modificada' indica si se cambió
+    char *fijar(uint32_t pagina);
+    void soltar(uint32_t pagina, bool modificada);
+
+    // Método para agregar una página en cero al final del archivo; queda en el búfer (sin fijar)
+    uint32_t agregarPagina();
+
+    // Método para escribir todas las páginas modificadas y sincronizar el archivo con el disco
+    void vaciar();
+
+    uint32_t getCantidadPaginas() const { return static_cast<uint32_t>(marcoDePagina.size()); }
+    size_t getCantidadMarcos() const { return paginaDelMarco.size(); }
+    uint64_t getLecturas() const { return lecturas; }
+    uint64_t getEscrituras() const { return escrituras; }
+};
+
+// Página fijada en el búfer mientras exista el objeto (la suelta al destruirse, incluso si hay una excepción)
+class PaginaFijada
+{
+private:
+    BuferPaginas &bufer;
+    uint32_t numero;
+    char *datos;
+    bool modificada;
+
+public:
+    PaginaFijada(BuferPaginas &bufer, uint32_t numero)
+        : bufer(bufer), numero(numero), datos(bufer.fijar(numero)), modificada(false) {}
+    ~PaginaFijada() { bufer.soltar(numero, modificada); }
+
+    // La página fijada no se puede copiar (se soltaría dos veces)
+    PaginaFijada(const PaginaFijada &) = delete;
+    PaginaFijada &operator=(const PaginaFijada &) = delete;
+
+    uint32_t getNumero() const { return numero; }
+    const char *getDatos() const { return datos; }
+
+    // Método para obtener la página para cambiarla (queda marcada para escribirse en el disco)
+    char *modificar()
+    {
+        modificada = true;
+        return datos;
+    }
+};
+
+// Contacto leído del árbol, con sus propias copias de los textos (la página puede salir del búfer)
+struct ContactoArbol
+{
+    string nombre;
+    string apellido;
+    uint64_t numero = 0; // Empaquetado (ver 'empaquetarNumeroCelular')
+    string email;
+
+    Agenda getContacto() const { return Agenda(nombre, apellido, numero, email); }
+};
+
+// Clase que guarda los contactos en un árbol B+ en disco (ver "ALMACENAMIENTO EN DISCO")
+// Cada contacto se identifica por su nombre, su número y un número de copia que distingue a los que tienen el
+// mismo nombre y el mismo número (como en el modo en memoria, puede haber varios; se agregan como la copia
+// siguiente a la última). Editar y eliminar por nombre y número afectan a la primera copia. Al eliminar, la hoja no se une con sus vecinas: el espacio se reutiliza con los contactos que
+// caigan en su rango (como las lápidas de las particiones, pero sin compactación).
+// Los cambios se escriben en el disco cuando sus páginas salen del búfer y con 'guardar'. El archivo queda
+// marcado como abierto desde el primer cambio hasta el siguiente 'guardar', así que si el programa se corta
+// en ese intervalo el archivo no se vuelve a abrir (hay que importarlo de nuevo).
+class ArbolContactos
+{
+private:
+    BuferPaginas bufer;
+    uint32_t raiz;
+    uint32_t altura; // Cantidad de niveles (1 si la raíz es una hoja)
+    uint64_t cantidad;
+    bool cerradoBien;
+
+    void escribirCabecera();
+    void marcarAbierto();
+    uint32_t bajarHastaHoja(string_view nombre, uint64_t numero, uint16_t copia, vector<pair<uint32_t, int>> *camino);
+    bool buscarCopias(string_view nombre, uint64_t numero, uint16_t &primera, uint16_t &ultima);
+    bool calcularCopiaNueva(string_view nombre, uint64_t numero, uint16_t &copia);
+    bool insertar(string_view nombre, string_view apellido, uint64_t numero, uint16_t copia, string_view email);
+    bool quitar(string_view nombre, uint64_t numero, uint16_t copia);
+    void precargarInternas();
+
+public:
+    // Constructor: abre el árbol del archivo 'ruta' con un búfer de 'bytesMemoria'
+    // Lanza una excepción si el archivo no es un árbol válido o no se cerró bien.
+    ArbolContactos(const string &ruta, size_t bytesMemoria);
+
+    // Destructor: guarda los cambios pendientes
+    ~ArbolContactos();
+
+    // El árbol no se puede copiar (tiene el archivo abierto)
+    ArbolContactos(const ArbolContactos &) = delete;
+    ArbolContactos &operator=(const ArbolContactos &) = delete;
+
+    // Método para buscar el primer contacto (por número) con un nombre exacto
+    // Retorna 'true' y lo copia en 'contacto' si lo encuentra
+    bool buscar(string_view nombre, ContactoArbol &contacto);
+
+    // Método para agregar un contacto (el número debe estar validado)
+    // Retorna 'false' si el nombre no comienza con una letra, si no entra en una página o si ya hay 65536
+    // contactos con el mismo nombre y número
+    bool agregar(string_view nombre, string_view apellido, string_view numeroDeCelular, string_view email);
+
+    // Método para reemplazar los datos del contacto 'nombre' y 'numero' (empaquetado; la primera copia)
+    // Retorna 'false' si no existe, si los datos nuevos no entran en una página o si ya hay 65536 contactos con
+    // el nombre y el número nuevos
+    bool editar(string_view nombre, uint64_t numero, string_view nuevoNombre, string_view nuevoApellido,
+                uint64_t nuevoNumero, string_view nuevoEmail);
+
+    // Método para eliminar el contacto 'nombre' y 'numero' (empaquetado; la primera copia); retorna 'false' si
+    // no existe
+    bool eliminar(string_view nombre, uint64_t numero);
+
+    // Método para escribir en el disco todas las páginas modificadas y marcar el archivo como cerrado bien
+    void guardar();
+
+    uint64_t getCantidad() const { return cantidad; }
+    uint32_t getAltura() const { return altura; }
+    const BuferPaginas &getBufer() const { return bufer; }
+};
+
+// Función para crear el árbol en disco 'rutaArbol' con los contactos del archivo binario 'rutaInstantanea'
+// (en cualquiera de sus formatos). Los contactos del archivo binario ya están ordenados por nombre, así que
+// se recorren una sola vez sin cargarlos en memoria y se llenan las hojas de izquierda a derecha, dejando
+// libre un 10% de cada página para los que se agreguen después. Retorna la cantidad de contactos del árbol.
+// Los que repiten el nombre y el número de otro se guardan como copias. Si algún contacto no entra en una
+// página (o pasa de 65536 copias), el árbol no lo admite: no se crea el árbol y se lanza una excepción con
+// cuántos son (nunca se importa la agenda incompleta).
+uint64_t importarArbolContactos(const string &rutaInstantanea, const string &rutaArbol, size_t bytesMemoria);
+
+#endif // AGENDA_CONTACTOS_H
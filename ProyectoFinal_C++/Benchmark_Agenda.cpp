@@ -0,0 +1,738 @@
+// Programa de mediciones de las operaciones principales de la agenda de contactos
+// Genera agendas sintéticas de distintos tamaños y mide, para cada operación, el tiempo por operación (ns),
+// las asignaciones de memoria por operación y el pico de memoria residente del proceso.
+// Compilar con CMake (objetivo 'benchmark_agenda', ver CMakeLists.txt) o a mano junto con el núcleo de la agenda
+// y el conteo de reservas de memoria:
+//   g++ -std=c++17 -O2 -pthread Benchmark_Agenda.cpp AgendaContactos.cpp Conteo_Memoria.cpp -o benchmark_agenda
+// Uso:
+//   benchmark_agenda [--tamanos 1000,10000,100000,1000000] [--salida resultados.csv]
+//                    [--comparar anterior.csv] [--tolerancia 0.10]
+// Con "--comparar" se informan las operaciones que se volvieron más lentas que en la corrida anterior por más
+// de la tolerancia, y el programa termina con código 1 si hay alguna (sirve para detectar regresiones; CMake
+// lo corre como la prueba "regresion_benchmark" si se configura con -DAGENDA_BENCHMARK_ANTERIOR=anterior.csv).
+#include "AgendaContactos.h" // Núcleo de la agenda (almacén, índices, búsquedas y archivos)
+#include <random>            // Para generar los contactos sintéticos (mt19937_64)
+#include <sstream>           // Para leer los campos del archivo de resultados anterior
+#include <iomanip>           // Para alinear la tabla de resultados (setw)
+#include <map>               // Para buscar las mediciones de la corrida anterior
+#ifndef _WIN32
+#include <sys/resource.h> // Para consultar el pico de memoria residente (getrusage)
+#endif
+
+// Función para consultar el pico de memoria residente del proceso (en KB)
+// Retorna 0 donde no se puede consultar
+long consultarPicoMemoriaKb()
+{
+#ifndef _WIN32
+    struct rusage uso;
+    getrusage(RUSAGE_SELF, &uso);
+    return uso.ru_maxrss;
+#else
+    return 0;
+#endif
+}
+
+// GENERACIÓN DE CONTACTOS SINTÉTICOS
+
+// Frecuencia aproximada de la letra inicial de los nombres (A-Z), sesgada como en una agenda real:
+// muchos nombres con M, J, A, C y L, y casi ninguno con K, Q, U, W o X
+const double FRECUENCIA_INICIAL[26] = {10.0, 3.0, 8.0, 5.0, 6.0, 4.0, 5.0, 2.0, 3.0, 11.0, 0.5, 7.0, 13.0,
+                                       3.0, 2.0, 4.0, 0.2, 5.0, 5.0, 2.0, 0.3, 3.0, 0.2, 0.3, 1.0, 0.5};
+
+// Estructura con los datos de un contacto sintético (en texto, como los escribiría el usuario)
+struct ContactoSintetico
+{
+    string nombre;
+    string apellido;
+    string numeroDeCelular;
+    string email;
+};
+
+// Clase que genera contactos sintéticos reproducibles (la misma semilla da los mismos contactos)
+class GeneradorContactos
+{
+private:
+    mt19937_64 aleatorio;
+    discrete_distribution<int> letraInicial;
+
+    // Método para formar una palabra pronunciable alternando consonantes y vocales
+    string generarPalabra(char inicial, size_t longitud)
+    {
+        static const char consonantes[] = "bcdfglmnprstvz";
+        static const char vocales[] = "aeiou";
+        string palabra(1, inicial);
+        bool esVocal = inicial == 'A' || inicial == 'E' || inicial == 'I' || inicial == 'O' || inicial == 'U';
+        while (palabra.size() < longitud)
+        {
+            esVocal = !esVocal;
+            palabra += esVocal ? vocales[aleatorio() % 5] : consonantes[aleatorio() % 14];
+        }
+        return palabra;
+    }
+
+public:
+    explicit GeneradorContactos(uint64_t semilla)
+        : aleatorio(semilla), letraInicial(begin(FRECUENCIA_INICIAL), end(FRECUENCIA_INICIAL)) {}
+
+    // Método para generar un nombre con la letra inicial sesgada según 'FRECUENCIA_INICIAL'
+    string generarNombre()
+    {
+        return generarPalabra(static_cast<char>('A' + letraInicial(aleatorio)), 4 + aleatorio() % 6);
+    }
+
+    // Método para generar un contacto completo
+    ContactoSintetico generarContacto()
+    {
+        ContactoSintetico contacto;
+        contacto.nombre = generarNombre();
+        contacto.apellido = generarPalabra(static_cast<char>('A' + aleatorio() % 26), 5 + aleatorio() % 5);
+        contacto.numeroDeCelular = desempaquetarNumeroCelular(aleatorio() % 10000000000ULL);
+        contacto.email = contacto.nombre + "." + contacto.apellido + "@correo.com";
+        return contacto;
+    }
+
+    // Método para elegir un índice al azar entre 0 y 'cantidad' - 1
+    size_t elegir(size_t cantidad) { return static_cast<size_t>(aleatorio() % cantidad); }
+};
+
+// MEDICIÓN
+
+// Estructura con el resultado de medir una operación
+struct Medicion
+{
+    string operacion;
+    size_t contactos;                // Tamaño de la agenda
+    size_t operaciones;              // Cantidad de operaciones medidas
+    double nanosegundosPorOperacion;
+    double asignacionesPorOperacion;
+    long picoMemoriaKb;              // Pico de memoria residente del proceso al terminar la medición
+};
+
+// Evita que el compilador descarte los resultados de las operaciones medidas
+volatile uint64_t sumidero = 0;
+
+// Función para medir una operación
+// 'ejecutar' hace las 'operaciones' operaciones completas; el tiempo y las asignaciones se reparten entre ellas
+template <typename Funcion>
+Medicion medir(const string &operacion, size_t contactos, size_t operaciones, Funcion ejecutar)
+{
+    uint64_t asignacionesAntes = reservasMemoria.load(memory_order_relaxed);
+    auto inicio = chrono::steady_clock::now();
+    ejecutar();
+    double nanosegundos = chrono::duration<double, nano>(chrono::steady_clock::now() - inicio).count();
+    uint64_t asignacionesHechas = reservasMemoria.load(memory_order_relaxed) - asignacionesAntes;
+
+    Medicion medicion;
+    medicion.operacion = operacion;
+    medicion.contactos = contactos;
+    medicion.operaciones = operaciones;
+    medicion.nanosegundosPorOperacion = nanosegundos / static_cast<double>(max<size_t>(operaciones, 1));
+    medicion.asignacionesPorOperacion =
+        static_cast<double>(asignacionesHechas) / static_cast<double>(max<size_t>(operaciones, 1));
+    medicion.picoMemoriaKb = consultarPicoMemoriaKb();
+    return medicion;
+}
+
+// Función para mostrar una medición en la tabla de la consola
+void mostrarMedicion(const Medicion &medicion)
+{
+    cout << left << setw(30) << medicion.operacion << right << setw(10) << medicion.contactos << setw(10)
+         << medicion.operaciones << setw(14) << fixed << setprecision(1) << medicion.nanosegundosPorOperacion
+         << setw(12) << setprecision(2) << medicion.asignacionesPorOperacion << setw(12) << medicion.picoMemoriaKb
+         << endl;
+}
+
+// Función para comprobar que 'validarCamposEnLote' da lo mismo que las validaciones de referencia
+// Además de los contactos sintéticos (todos válidos) se prueban variantes no válidas de los primeros: números
+// de 9 y 11 dígitos o con una letra, emails sin '@' o sin '.', y nombres que no empiezan con una letra.
+// Lanza 'runtime_error' si algún resultado no coincide.
+void comprobarValidacionEnLote(const vector<CamposContacto> &campos)
+{
+    size_t base = min<size_t>(campos.size(), 1000);
+    vector<string> textos; // Los campos modificados (las variantes apuntan a estos textos)
+    textos.reserve(base * 6);
+    vector<CamposContacto> pruebas(campos.begin(), campos.begin() + base);
+    for (size_t i = 0; i < base; ++i)
+    {
+        const CamposContacto &contacto = campos[i];
+        string numero(contacto.numeroDeCelular), email(contacto.email);
+        textos.push_back(numero.substr(0, numero.size() - 1));
+        textos.push_back(numero + "7");
+        textos.push_back(numero);
+        textos.back()[i % numero.size()] = 'x';
+        textos.push_back(email);
+        textos.back().erase(textos.back().find('@'), 1);
+        textos.push_back(email.substr(0, email.rfind('.')));
+        textos.push_back("1" + string(contacto.nombre));
+        for (size_t variante = 0; variante < 6; ++variante)
+        {
+            CamposContacto prueba = contacto;
+            string_view texto = textos[textos.size() - 6 + variante];
+            if (variante < 3)
+            {
+                prueba.numeroDeCelular = texto;
+            }
+            else if (variante < 5)
+            {
+                prueba.email = texto;
+            }
+            else
+            {
+                prueba.nombre = texto;
+            }
+            pruebas.push_back(prueba);
+        }
+    }
+
+    vector<uint64_t> fallas((pruebas.size() + 63) / 64);
+    validarCamposEnLote(pruebas.data(), pruebas.size(), fallas.data());
+    for (size_t i = 0; i < pruebas.size(); ++i)
+    {
+        const CamposContacto &prueba = pruebas[i];
+        bool valido = calcularLetraInicial(prueba.nombre) >= 0 && validarNumeroCelular(prueba.numeroDeCelular) &&
+                      validarEmail(prueba.email);
+        bool validoEnLote = (fallas[i / 64] >> (i % 64) & 1) == 0;
+        if (valido != validoEnLote)
+        {
+            throw runtime_error("validarCamposEnLote no coincide con la validación de referencia para el contacto " +
+                                string(prueba.nombre) + " " + string(prueba.numeroDeCelular) + " " +
+                                string(prueba.email) + ".");
+        }
+    }
+}
+
+// Función para comprobar 'buscarAproximado' contra una búsqueda exhaustiva con 'distanciaLevenshtein'
+// Cada resultado debe estar a la distancia que dice y las distancias de los resultados deben ser las de los
+// 'cantidadMaxima' contactos más cercanos (entre los empatados puede elegir cualquiera).
+// Lanza 'runtime_error' si algún resultado no coincide.
+void comprobarBusquedaAproximada(const AgendaContactos &agenda, const vector<string> &consultas, int distanciaMaxima,
+                                 size_t cantidadMaxima)
+{
+    const AlmacenContactos &almacen = agenda.almacen;
+    for (const string &consulta : consultas)
+    {
+        vector<int> esperadas;
+        for (uint32_t contacto = 0; contacto < almacen.getTotalRegistros(); ++contacto)
+        {
+            int distancia = almacen.estaActivo(contacto) ? distanciaLevenshtein(consulta, almacen.getNombre(contacto))
+                                                         : distanciaMaxima + 1;
+            if (distancia <= distanciaMaxima)
+            {
+                esperadas.push_back(distancia);
+            }
+        }
+        sort(esperadas.begin(), esperadas.end());
+        esperadas.resize(min(esperadas.size(), cantidadMaxima));
+
+        vector<int> obtenidas;
+        for (const ResultadoAproximado &resultado : buscarAproximado(agenda, consulta, distanciaMaxima, cantidadMaxima))
+        {
+            if (resultado.distancia != distanciaLevenshtein(consulta, almacen.getNombre(resultado.contacto)))
+            {
+                throw runtime_error("buscarAproximado informa una distancia equivocada para la consulta " + consulta +
+                                    ".");
+            }
+            obtenidas.push_back(resultado.distancia);
+        }
+        if (obtenidas != esperadas)
+        {
+            throw runtime_error("buscarAproximado no encuentra los contactos más cercanos a la consulta " + consulta +
+                                ".");
+        }
+    }
+}
+
+// Función para medir todas las operaciones sobre una agenda sintética de 'contactos' contactos
+void medirTamano(size_t contactos, vector<Medicion> &mediciones)
+{
+    GeneradorContactos generador(20240601 + contactos);
+    vector<ContactoSintetico> datos(contactos);
+    for (ContactoSintetico &contacto : datos)
+    {
+        contacto = generador.generarContacto();
+    }
+
+    // Las operaciones que modifican la agenda se miden con una cantidad fija, para no cambiar mucho su tamaño
+    const size_t consultas = 200000;
+    const size_t cambios = min<size_t>(contactos, 20000);
+    vector<ContactoSintetico> nuevos(cambios);
+    for (ContactoSintetico &contacto : nuevos)
+    {
+        contacto = generador.generarContacto();
+    }
+    vector<size_t> elegidos(consultas);
+    for (size_t &elegido : elegidos)
+    {
+        elegido = generador.elegir(contactos);
+    }
+    vector<string> ausentes(consultas);
+    for (string &nombre : ausentes)
+    {
+        nombre = generador.generarNombre() + "x"; // Los nombres generados nunca terminan en 'x'
+    }
+
+    // Se llena el almacén y un lote sin confirmar, como al terminar de leer el archivo
+    AgendaContactos agenda;
+    LoteDeContactos lote(agenda);
+    lote.reservar(contactos);
+    size_t contactosPorLetra[26] = {};
+    for (const ContactoSintetico &contacto : datos)
+    {
+        uint32_t id = agenda.almacen.agregar(contacto.nombre, contacto.apellido, contacto.numeroDeCelular, contacto.email);
+        lote.agregar(id);
+        contactosPorLetra[calcularLetraInicial(contacto.nombre)]++;
+    }
+
+    auto registrar = [&](Medicion medicion)
+    {
+        mostrarMedicion(medicion);
+        mediciones.push_back(medicion);
+    };
+
+    registrar(medir("ordenar (LoteDeContactos)", contactos, contactos, [&]()
+                    { lote.confirmar(); }));
+
+    // Equilibrio de las particiones frente a los grupos por letra inicial (que reparten muy desparejo)
+    EstadisticasParticiones estadisticas = agenda.particiones.calcularEstadisticas();
+    cout << "  particiones: " << estadisticas.cantidad << " (min " << estadisticas.minimo << ", max "
+         << estadisticas.maximo << ", promedio " << fixed << setprecision(1) << estadisticas.promedio
+         << ", desviacion " << estadisticas.desviacion << "); letra mas grande: "
+         << *max_element(begin(contactosPorLetra), end(contactosPorLetra)) << " contactos" << endl;
+
+    // Validación de la importación: las funciones de referencia contra la validación por lotes
+    vector<CamposContacto> campos(contactos);
+    for (size_t i = 0; i < contactos; ++i)
+    {
+        campos[i] = CamposContacto{datos[i].nombre, datos[i].apellido, datos[i].numeroDeCelular, datos[i].email};
+    }
+    registrar(medir("validar (escalar)", contactos, contactos, [&]()
+                    {
+                        for (const CamposContacto &contacto : campos)
+                        {
+                            sumidero += calcularLetraInicial(contacto.nombre) >= 0 &&
+                                        validarNumeroCelular(contacto.numeroDeCelular) && validarEmail(contacto.email);
+                        }
+                    }));
+    vector<uint64_t> fallas((contactos + 63) / 64);
+    registrar(medir("validarCamposEnLote", contactos, contactos, [&]()
+                    {
+                        validarCamposEnLote(campos.data(), campos.size(), fallas.data());
+                        sumidero += fallas[0];
+                    }));
+    comprobarValidacionEnLote(campos);
+
+    registrar(medir("busquedaBinaria (encontrado)", contactos, consultas, [&]()
+                    {
+                        for (size_t elegido : elegidos)
+                        {
+                            const string &nombre = datos[elegido].nombre;
+                            int posicion;
+                            sumidero += busquedaBinaria(agenda.almacen,
+                                                        agenda.particiones.getContactos(agenda.particiones.ubicar(nombre)),
+                                                        nombre, posicion);
+                        }
+                    }));
+
+    registrar(medir("busquedaBinaria (ausente)", contactos, consultas, [&]()
+                    {
+                        for (const string &nombre : ausentes)
+                        {
+                            int posicion;
+                            sumidero += busquedaBinaria(agenda.almacen,
+                                                        agenda.particiones.getContactos(agenda.particiones.ubicar(nombre)),
+                                                        nombre, posicion);
+                        }
+                    }));
+
+    registrar(medir("localizarPorNumero", contactos, consultas, [&]()
+                    {
+                        for (size_t elegido : elegidos)
+                        {
+                            uint32_t contacto;
+                            sumidero += localizarPorNumero(agenda, empaquetarNumeroCelular(datos[elegido].numeroDeCelular), contacto);
+                        }
+                    }));
+
+    registrar(medir("buscarPorPrefijo", contactos, consultas, [&]()
+                    {
+                        for (size_t elegido : elegidos)
+                        {
+                            string_view prefijo = string_view(datos[elegido].nombre).substr(0, 3);
+                            sumidero += buscarPorPrefijo(agenda, prefijo, 10, [](uint32_t contacto)
+                                                         { sumidero += contacto; });
+                        }
+                    }));
+
+    const size_t consultasAproximadas = 200;
+    vector<string> consultasConErrores(consultasAproximadas);
+    for (size_t i = 0; i < consultasAproximadas; ++i)
+    {
+        consultasConErrores[i] = datos[elegidos[i]].nombre;
+        swap(consultasConErrores[i][1], consultasConErrores[i][2]); // Un error de escritura típico
+    }
+    registrar(medir("buscarAproximado", contactos, consultasAproximadas, [&]()
+                    {
+                        for (const string &consulta : consultasConErrores)
+                        {
+                            sumidero += buscarAproximado(agenda, consulta, 2, 5).size();
+                        }
+                    }));
+    // La búsqueda exhaustiva recorre toda la agenda por consulta, así que se comprueban solo unas pocas
+    consultasConErrores.resize(min<size_t>(consultasAproximadas, 10));
+    comprobarBusquedaAproximada(agenda, consultasConErrores, 2, 5);
+
+    registrar(medir("registrarContacto", contactos, cambios, [&]()
+                    {
+                        for (const ContactoSintetico &contacto : nuevos)
+                        {
+                            sumidero += registrarContacto(agenda, contacto.nombre, contacto.apellido,
+                                                          contacto.numeroDeCelular, contacto.email);
+                        }
+                    }));
+
+    // Se eliminan los contactos recién agregados, así la agenda vuelve a su tamaño original
+    registrar(medir("borrarContacto", contactos, cambios, [&]()
+                    {
+                        for (const ContactoSintetico &contacto : nuevos)
+                        {
+                            size_t particion, posicion;
+                            if (localizarContacto(agenda, contacto.nombre, empaquetarNumeroCelular(contacto.numeroDeCelular),
+                                                  particion, posicion))
+                            {
+                                borrarContacto(agenda, particion, posicion);
+                            }
+                        }
+                    }));
+
+    // Los archivos de la medición van a la carpeta temporal del sistema
+    filesystem::path carpeta = filesystem::temp_directory_path();
+    string rutaInstantanea = (carpeta / "benchmark_agenda.agdb").string();
+    string rutaDiario = (carpeta / "benchmark_agenda.diario").string();
+
+    registrar(medir("guardarInstantanea", contactos, contactos, [&]()
+                    { guardarInstantanea(agenda, rutaInstantanea); }));
+
+    registrar(medir("cargarInstantanea", contactos, contactos, [&]()
+                    {
+                        AgendaContactos cargada;
+                        uint64_t secuencia;
+                        sumidero += cargarInstantanea(cargada, rutaInstantanea, secuencia, false);
+                    }));
+
+    // Formato comprimido: se compara el tamaño con el del archivo de texto (calculado) y el binario sin comprimir
+    string rutaComprimida = (carpeta / "benchmark_agenda_comprimida.agdb").string();
+    registrar(medir("guardarInstantanea (comprimida)", contactos, contactos, [&]()
+                    { guardarInstantanea(agenda, rutaComprimida, 0, true); }));
+
+    registrar(medir("cargarInstantanea (comprimida)", contactos, contactos, [&]()
+                    {
+                        AgendaContactos cargada;
+                        uint64_t secuencia;
+                        sumidero += cargarInstantanea(cargada, rutaComprimida, secuencia, false);
+                    }));
+
+    uintmax_t bytesTexto = 0;
+    for (size_t contacto = 0; contacto < agenda.almacen.getTotalRegistros(); ++contacto)
+    {
+        if (agenda.almacen.estaActivo(static_cast<uint32_t>(contacto)))
+        {
+            // "nombre apellido numero email\n"
+            bytesTexto += agenda.almacen.getNombre(static_cast<uint32_t>(contacto)).size() +
+                          agenda.almacen.getApellido(static_cast<uint32_t>(contacto)).size() +
+                          agenda.almacen.getEmail(static_cast<uint32_t>(contacto)).size() + 14;
+        }
+    }
+    uintmax_t bytesBinario = filesystem::file_size(rutaInstantanea), bytesComprimido = filesystem::file_size(rutaComprimida);
+    cout << "  archivos: texto " << bytesTexto << " bytes, binario " << bytesBinario << " bytes, comprimido "
+         << bytesComprimido << " bytes (" << setprecision(2) << static_cast<double>(bytesTexto) / bytesComprimido
+         << "x menos que el texto)" << endl;
+    filesystem::remove(rutaComprimida);
+
+    // Guardar con el diario: cada cambio se anota y se confirma por grupos (con fsync)
+    filesystem::remove(rutaDiario);
+    registrar(medir("registrarContacto + diario", contactos, cambios, [&]()
+                    {
+                        DiarioCambios diario(rutaDiario, rutaInstantanea, 1);
+                        agenda.diario = &diario;
+                        for (const ContactoSintetico &contacto : nuevos)
+                        {
+                            sumidero += registrarContacto(agenda, contacto.nombre, contacto.apellido,
+                                                          contacto.numeroDeCelular, contacto.email);
+                        }
+                        diario.confirmar();
+                        agenda.diario = nullptr;
+                    }));
+
+    // Árbol en disco (modo fuera de memoria): con un búfer de la octava parte del archivo casi ninguna hoja está
+    // en memoria, así que se informan las páginas leídas por búsqueda (las internas ya están en el búfer)
+    string rutaArbol = (carpeta / "benchmark_agenda.arbol").string();
+    registrar(medir("importarArbolContactos", contactos, contactos, [&]()
+                    { sumidero += importarArbolContactos(rutaInstantanea, rutaArbol, 64 << 20); }));
+    {
+        ArbolContactos arbol(rutaArbol, static_cast<size_t>(filesystem::file_size(rutaArbol) / 8));
+        uint64_t lecturasAntes = arbol.getBufer().getLecturas();
+        ContactoArbol encontrado;
+        registrar(medir("ArbolContactos::buscar", contactos, consultas, [&]()
+                        {
+                            for (size_t elegido : elegidos)
+                            {
+                                sumidero += arbol.buscar(datos[elegido].nombre, encontrado);
+                            }
+                        }));
+        cout << "  arbol en disco: altura " << arbol.getAltura() << ", " << arbol.getBufer().getCantidadPaginas()
+             << " paginas, " << setprecision(2)
+             << static_cast<double>(arbol.getBufer().getLecturas() - lecturasAntes) / consultas
+             << " paginas leidas por busqueda" << endl;
+        registrar(medir("ArbolContactos::agregar", contactos, cambios, [&]()
+                        {
+                            for (const ContactoSintetico &contacto : nuevos)
+                            {
+                                sumidero += arbol.agregar(contacto.nombre, contacto.apellido,
+                                                          contacto.numeroDeCelular, contacto.email);
+                            }
+                            arbol.guardar();
+                        }));
+    }
+    filesystem::remove(rutaArbol);
+
+
+    // Borrado masivo: se elimina el 30% de los contactos originales (quedan como lápidas y las particiones se
+    // compactan solas), así que debe costar lo mismo por contacto con cualquier tamaño de agenda
+    vector<size_t> purgados;
+    for (size_t i = 0; i < contactos; i += 10)
+    {
+        for (size_t j = i; j < min(contactos, i + 3); ++j)
+        {
+            purgados.push_back(j);
+        }
+    }
+    registrar(medir("borrar 30% de la agenda", contactos, purgados.size(), [&]()
+                    {
+                        for (size_t elegido : purgados)
+                        {
+                            size_t particion, posicion;
+                            if (localizarContacto(agenda, datos[elegido].nombre,
+                                                  empaquetarNumeroCelular(datos[elegido].numeroDeCelular), particion,
+                                                  posicion))
+                            {
+                                borrarContacto(agenda, particion, posicion);
+                            }
+                        }
+                    }));
+
+    // Actualizaciones masivas: cambiar el dominio de todos los emails (no cambia ningún orden) y renombrar
+    // 'cambios' contactos de una vez (se reubican todos juntos al final)
+    registrar(medir("cambiarDominioEmails", contactos, contactos, [&]()
+                    { sumidero += cambiarDominioEmails(agenda, "correo.com", "correo.net"); }));
+
+    vector<pair<uint32_t, CambiosContacto>> renombres;
+    for (size_t i = 0; i < cambios; ++i)
+    {
+        const string &nombre = datos[elegidos[i]].nombre;
+        size_t particion = agenda.particiones.ubicar(nombre);
+        int posicion;
+        if (busquedaBinaria(agenda.almacen, agenda.particiones.getContactos(particion), nombre, posicion))
+        {
+            CambiosContacto cambio;
+            cambio.nombre = nuevos[i].nombre;
+            renombres.push_back({agenda.particiones.getContactos(particion)[posicion], cambio});
+        }
+    }
+    registrar(medir("actualizarContactos (nombres)", contactos, renombres.size(), [&]()
+                    { sumidero += actualizarContactos(agenda, renombres); }));
+
+    // Búsquedas por apellido y por dominio: los índices se construyen con la primera (se mide aparte) y desde
+    // entonces cada búsqueda recorre solo su resultado. Todos los emails sintéticos son de "correo.net" (después
+    // de 'cambiarDominioEmails'), así que la intersección cruza cada apellido con una lista de toda la agenda.
+    registrar(medir("construir indices de grupos", contactos, contactos, [&]()
+                    { agenda.indicesGrupos.construir(agenda.almacen); }));
+    auto contarContacto = [](uint32_t contacto)
+    { sumidero += contacto; };
+    registrar(medir("buscarPorGrupo (apellido)", contactos, consultas, [&]()
+                    {
+                        for (size_t elegido : elegidos)
+                        {
+                            sumidero += buscarPorGrupo(agenda, datos[elegido].apellido, string_view(), 20, contarContacto);
+                        }
+                    }));
+    registrar(medir("buscarPorGrupo (apellido+dominio)", contactos, consultas, [&]()
+                    {
+                        for (size_t elegido : elegidos)
+                        {
+                            sumidero += buscarPorGrupo(agenda, datos[elegido].apellido, "correo.net", 20, contarContacto);
+                        }
+                    }));
+    cout << "  indices de grupos: " << agenda.indicesGrupos.getCantidadApellidos() << " apellidos, "
+         << agenda.indicesGrupos.getCantidadDominios() << " dominios, " << agenda.indicesGrupos.getBytesOcupados()
+         << " bytes" << endl;
+
+    // Duplicados: se vuelven a importar 'cambios' contactos con el email en mayúsculas (como una segunda
+    // importación del mismo archivo desde otro programa) y se buscan por número y por email normalizado. Se
+    // toman del final de 'elegidos', porque los del comienzo se renombraron arriba.
+    for (size_t i = 0; i < cambios; ++i)
+    {
+        const ContactoSintetico &contacto = datos[elegidos[consultas - 1 - i]];
+        string email = contacto.email;
+        transform(email.begin(), email.end(), email.begin(), [](char c)
+                  { return static_cast<char>(toupper(static_cast<unsigned char>(c))); });
+        registrarContacto(agenda, contacto.nombre, contacto.apellido, contacto.numeroDeCelular, email);
+    }
+    GruposDuplicados duplicados;
+    registrar(medir("detectarDuplicados", contactos, contactos, [&]()
+                    { duplicados = detectarDuplicados(agenda, ConfiguracionDuplicados()); }));
+    cout << "  duplicados: " << duplicados.getCantidadGrupos() << " grupos, " << duplicados.getCantidadDuplicados()
+         << " contactos de mas, " << duplicados.comparaciones << " comparaciones" << endl;
+    registrar(medir("fusionarDuplicados", contactos, duplicados.getCantidadDuplicados(), [&]()
+                    { sumidero += fusionarDuplicados(agenda, duplicados, FUSION_PRIMERO); }));
+
+    filesystem::remove(rutaInstantanea);
+    filesystem::remove(rutaDiario);
+}
+
+// RESULTADOS EN ARCHIVO
+
+// Función para escribir las mediciones en formato CSV (una línea por operación y tamaño)
+void guardarMediciones(const vector<Medicion> &mediciones, const string &ruta)
+{
+    ofstream archivo(ruta);
+    if (!archivo.is_open())
+    {
+        throw runtime_error("No se pudo crear el archivo de resultados " + ruta + ".");
+    }
+    archivo << "operacion,contactos,operaciones,ns_por_operacion,asignaciones_por_operacion,pico_memoria_kb\n";
+    for (const Medicion &medicion : mediciones)
+    {
+        archivo << medicion.operacion << ',' << medicion.contactos << ',' << medicion.operaciones << ','
+                << medicion.nanosegundosPorOperacion << ',' << medicion.asignacionesPorOperacion << ','
+                << medicion.picoMemoriaKb << '\n';
+    }
+}
+
+// Función para comparar las mediciones con las de un archivo CSV de una corrida anterior
+// Informa las operaciones cuyo tiempo creció más que 'tolerancia' (0.10 = 10%). Retorna cuántas son.
+size_t compararMediciones(const vector<Medicion> &mediciones, const string &rutaAnterior, double tolerancia)
+{
+    ifstream archivo(rutaAnterior);
+    if (!archivo.is_open())
+    {
+        throw runtime_error("No se pudo abrir el archivo de resultados " + rutaAnterior + ".");
+    }
+
+    // Tiempo por operación de la corrida anterior, por operación y tamaño
+    map<pair<string, size_t>, double> anteriores;
+    string linea;
+    getline(archivo, linea); // Encabezado
+    while (getline(archivo, linea))
+    {
+        stringstream campos(linea);
+        string operacion, contactos, operaciones, nanosegundos;
+        if (getline(campos, operacion, ',') && getline(campos, contactos, ',') && getline(campos, operaciones, ',') &&
+            getline(campos, nanosegundos, ','))
+        {
+            anteriores[{operacion, stoull(contactos)}] = stod(nanosegundos);
+        }
+    }
+
+    size_t regresiones = 0;
+    for (const Medicion &medicion : mediciones)
+    {
+        auto anterior = anteriores.find({medicion.operacion, medicion.contactos});
+        if (anterior == anteriores.end() || anterior->second <= 0.0)
+        {
+            continue;
+        }
+        double cambio = medicion.nanosegundosPorOperacion / anterior->second - 1.0;
+        if (cambio > tolerancia)
+        {
+            cout << "REGRESION: " << medicion.operacion << " con " << medicion.contactos << " contactos: "
+                 << setprecision(1) << anterior->second << " ns -> " << medicion.nanosegundosPorOperacion << " ns (+"
+                 << cambio * 100.0 << "%)" << endl;
+            regresiones++;
+        }
+    }
+    return regresiones;
+}
+
+// Función para leer una lista de tamaños separados por comas (por ejemplo "1000,10000,100000")
+vector<size_t> interpretarTamanos(const string &texto)
+{
+    vector<size_t> tamanos;
+    stringstream campos(texto);
+    string campo;
+    while (getline(campos, campo, ','))
+    {
+        size_t tamano = static_cast<size_t>(stod(campo)); // Acepta también "1e6"
+        if (tamano == 0)
+        {
+            throw runtime_error("Los tamaños deben ser mayores que cero.");
+        }
+        tamanos.push_back(tamano);
+    }
+    return tamanos;
+}
+
+// Función principal
+int main(int argc, char *argv[])
+{
+    vector<size_t> tamanos = {1000, 10000, 100000, 1000000};
+    string rutaSalida = "benchmark_agenda.csv";
+    string rutaAnterior;
+    double tolerancia = 0.10;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            string opcion = argv[i];
+            if (i + 1 >= argc)
+            {
+                throw runtime_error("Falta el valor de la opción " + opcion + ".");
+            }
+            string valor = argv[++i];
+            if (opcion == "--tamanos")
+            {
+                tamanos = interpretarTamanos(valor);
+            }
+            else if (opcion == "--salida")
+            {
+                rutaSalida = valor;
+            }
+            else if (opcion == "--comparar")
+            {
+                rutaAnterior = valor;
+            }
+            else if (opcion == "--tolerancia")
+            {
+                tolerancia = stod(valor);
+            }
+            else
+            {
+                throw runtime_error("Opción no válida: " + opcion + ".");
+            }
+        }
+
+        cout << left << setw(30) << "operacion" << right << setw(10) << "contactos" << setw(10) << "ops" << setw(14)
+             << "ns/op" << setw(12) << "asign/op" << setw(12) << "pico KB" << endl;
+
+        vector<Medicion> mediciones;
+        for (size_t tamano : tamanos)
+        {
+            medirTamano(tamano, mediciones);
+        }
+
+        guardarMediciones(mediciones, rutaSalida);
+        cout << "Resultados guardados en " << rutaSalida << "." << endl;
+
+        if (!rutaAnterior.empty() && compararMediciones(mediciones, rutaAnterior, tolerancia) > 0)
+        {
+            return 1;
+        }
+    }
+    catch (const exception &errorGeneral)
+    {
+        cout << "Error inesperado: " << errorGeneral.what() << endl;
+        return 2;
+    }
+
+    return 0;
+}
@@ -0,0 +1,308 @@
+// Generador de carga para el modo servicio de la agenda ("agenda --servicio [socket]")
+// Abre varios clientes en paralelo que envían comandos por el socket local en tandas (varios comandos por
+// envío) y mide las operaciones por segundo y la latencia de cada tanda.
+// Compilar (no necesita el núcleo de la agenda, solo habla con el servicio):
+//   g++ -std=c++17 -O2 -pthread Carga_Agenda.cpp -o carga_agenda
+// Uso:
+//   carga_agenda [--socket agenda.sock] [--clientes 8] [--segundos 10] [--escrituras 0.05]
+//                [--tanda 32] [--contactos 10000]
+// Primero agrega '--contactos' contactos de prueba (con 0 no agrega ninguno y consulta nombres que quizá
+// no existan). Las lecturas son "find" y "num" de esos contactos; las escrituras agregan y eliminan
+// contactos propios de cada cliente, en la proporción '--escrituras' (0.05 = 95% lecturas y 5% escrituras).
+#ifdef _WIN32
+#include <iostream>
+int main()
+{
+    std::cout << "El generador de carga necesita sockets locales (Unix); no está disponible en Windows." << std::endl;
+    return 1;
+}
+#else
+#include <iostream>  // Para mostrar los resultados
+#include <vector>    // Para los hilos y las latencias
+#include <string>    // Para armar los comandos
+#include <thread>    // Para los clientes en paralelo
+#include <atomic>    // Para avisar a los clientes que terminen
+#include <chrono>    // Para medir el tiempo y las latencias
+#include <random>    // Para elegir los comandos al azar
+#include <algorithm> // Para ordenar las latencias (percentiles)
+#include <stdexcept> // Para el manejo de excepciones
+#include <cstring>   // Para strcpy y memchr
+#include <cerrno>    // Para reintentar las lecturas interrumpidas (EINTR)
+#include <sys/socket.h> // Para conectarse al socket local
+#include <sys/un.h>     // Para la dirección del socket local (sockaddr_un)
+#include <unistd.h>     // Para read, write y close
+
+using namespace std;
+
+// Configuración de la prueba de carga
+struct ConfiguracionCarga
+{
+    string rutaSocket = "agenda.sock";
+    size_t clientes = 8;
+    double segundos = 10.0;
+    double proporcionEscrituras = 0.05;
+    size_t tanda = 32;      // Comandos por envío
+    size_t contactos = 10000; // Contactos de prueba que se agregan antes de medir
+};
+
+// Clase con una conexión al servicio: envía texto y lee respuestas línea por línea
+class ConexionServicio
+{
+private:
+    int descriptor;
+    vector<char> bufer;
+    size_t inicio, fin; // Parte del búfer con datos recibidos que todavía no se leyeron
+
+public:
+    explicit ConexionServicio(const string &rutaSocket) : bufer(1 << 16), inicio(0), fin(0)
+    {
+        descriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un direccion{};
+        direccion.sun_family = AF_UNIX;
+        if (descriptor < 0 || rutaSocket.size() >= sizeof(direccion.sun_path))
+        {
+            throw runtime_error("No se pudo crear el socket.");
+        }
+        strcpy(direccion.sun_path, rutaSocket.c_str());
+        if (connect(descriptor, reinterpret_cast<sockaddr *>(&direccion), sizeof(direccion)) != 0)
+        {
+            close(descriptor);
+            throw runtime_error("No se pudo conectar con el servicio en " + rutaSocket + ".");
+        }
+    }
+
+    ~ConexionServicio() { close(descriptor); }
+
+    // La conexión no se puede copiar (se cerraría dos veces)
+    ConexionServicio(const ConexionServicio &) = delete;
+    ConexionServicio &operator=(const ConexionServicio &) = delete;
+
+    // Método para enviar todo el texto
+    void enviar(const string &texto)
+    {
+        size_t enviados = 0;
+        while (enviados < texto.size())
+        {
+            ssize_t escritos = write(descriptor, texto.data() + enviados, texto.size() - enviados);
+            if (escritos < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (escritos <= 0)
+            {
+                throw runtime_error("Se cortó la conexión con el servicio.");
+            }
+            enviados += static_cast<size_t>(escritos);
+        }
+    }
+
+    // Método para esperar y descartar 'cantidad' líneas de respuesta
+    void recibirLineas(size_t cantidad)
+    {
+        while (cantidad > 0)
+        {
+            const char *salto = static_cast<const char *>(memchr(bufer.data() + inicio, '\n', fin - inicio));
+            if (salto != nullptr)
+            {
+                inicio = static_cast<size_t>(salto - bufer.data()) + 1;
+                cantidad--;
+                continue;
+            }
+            // No hay una línea completa: se corre lo pendiente al comienzo y se lee más
+            copy(bufer.begin() + inicio, bufer.begin() + fin, bufer.begin());
+            fin -= inicio;
+            inicio = 0;
+            ssize_t leidos = read(descriptor, bufer.data() + fin, bufer.size() - fin);
+            if (leidos < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (leidos <= 0)
+            {
+                throw runtime_error("Se cortó la conexión con el servicio.");
+            }
+            fin += static_cast<size_t>(leidos);
+        }
+    }
+};
+
+// Función para armar el nombre y el número del contacto de prueba 'i'
+// La letra inicial se reparte entre A-Z para que los contactos caigan en todos los grupos
+string nombrePrueba(size_t i) { return string(1, static_cast<char>('A' + i % 26)) + "carga" + to_string(i); }
+string numeroPrueba(size_t i) { return to_string(9000000000ULL + i % 1000000000ULL); }
+
+// Resultados de un cliente
+struct ResultadoCliente
+{
+    size_t lecturas = 0;
+    size_t escrituras = 0;
+    vector<double> latencias; // Microsegundos por tanda
+};
+
+// Función que ejecuta un cliente: envía tandas de comandos hasta que se le pide terminar
+void ejecutarCliente(const ConfiguracionCarga &configuracion, size_t numeroCliente, const atomic<bool> &terminar,
+                     ResultadoCliente &resultado)
+{
+    ConexionServicio conexion(configuracion.rutaSocket);
+    mt19937_64 aleatorio(numeroCliente * 7919 + 1);
+    uniform_real_distribution<double> proporcion(0.0, 1.0);
+    size_t agregados = 0, eliminados = 0; // Contactos propios del cliente
+    string comandos;
+
+    while (!terminar.load(memory_order_relaxed))
+    {
+        comandos.clear();
+        for (size_t i = 0; i < configuracion.tanda; ++i)
+        {
+            if (proporcion(aleatorio) < configuracion.proporcionEscrituras)
+            {
+                // Las escrituras alternan entre agregar un contacto propio y eliminar el más viejo
+                string nombre = string(1, static_cast<char>('A' + (numeroCliente + agregados) % 26)) + "cliente" +
+                                to_string(numeroCliente) + "x";
+                if (agregados > eliminados && aleatorio() % 2 == 0)
+                {
+                    nombre[0] = static_cast<char>('A' + (numeroCliente + eliminados) % 26);
+                    comandos += "del|" + nombre + to_string(eliminados++) + "\n";
+                }
+                else
+                {
+                    comandos += "add|" + nombre + to_string(agregados) + "|Carga|" + numeroPrueba(agregados) +
+                                "|cliente@carga.com\n";
+                    agregados++;
+                }
+                resultado.escrituras++;
+            }
+            else
+            {
+                size_t elegido = configuracion.contactos > 0 ? aleatorio() % configuracion.contactos : aleatorio() % 1000;
+                if (aleatorio() % 2 == 0)
+                {
+                    comandos += "find|" + nombrePrueba(elegido) + "\n";
+                }
+                else
+                {
+                    comandos += "num|" + numeroPrueba(elegido) + "\n";
+                }
+                resultado.lecturas++;
+            }
+        }
+
+        // Todos los comandos usados responden con una sola línea
+        auto inicio = chrono::steady_clock::now();
+        conexion.enviar(comandos);
+        conexion.recibirLineas(configuracion.tanda);
+        resultado.latencias.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - inicio).count());
+    }
+}
+
+// Función para calcular un percentil (0-100) de una lista ordenada
+double calcularPercentil(const vector<double> &ordenadas, double percentil)
+{
+    if (ordenadas.empty())
+    {
+        return 0.0;
+    }
+    size_t posicion = static_cast<size_t>(percentil / 100.0 * static_cast<double>(ordenadas.size() - 1));
+    return ordenadas[posicion];
+}
+
+// Función principal
+int main(int argc, char *argv[])
+{
+    ConfiguracionCarga configuracion;
+    try
+    {
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            string opcion = argv[i], valor = argv[i + 1];
+            if (opcion == "--socket")
+            {
+                configuracion.rutaSocket = valor;
+            }
+            else if (opcion == "--clientes")
+            {
+                configuracion.clientes = max<size_t>(1, stoul(valor));
+            }
+            else if (opcion == "--segundos")
+            {
+                configuracion.segundos = stod(valor);
+            }
+            else if (opcion == "--escrituras")
+            {
+                configuracion.proporcionEscrituras = stod(valor);
+            }
+            else if (opcion == "--tanda")
+            {
+                configuracion.tanda = max<size_t>(1, stoul(valor));
+            }
+            else if (opcion == "--contactos")
+            {
+                configuracion.contactos = stoul(valor);
+            }
+            else
+            {
+                throw runtime_error("Opción no válida: " + opcion + ".");
+            }
+        }
+
+        // Agrega los contactos de prueba en tandas de 1000
+        {
+            ConexionServicio conexion(configuracion.rutaSocket);
+            for (size_t inicio = 0; inicio < configuracion.contactos; inicio += 1000)
+            {
+                string comandos;
+                size_t fin = min(configuracion.contactos, inicio + 1000);
+                for (size_t i = inicio; i < fin; ++i)
+                {
+                    comandos += "add|" + nombrePrueba(i) + "|Prueba|" + numeroPrueba(i) + "|prueba@carga.com\n";
+                }
+                conexion.enviar(comandos);
+                conexion.recibirLineas(fin - inicio);
+            }
+            // Se espera a que el servicio publique los contactos agregados
+            this_thread::sleep_for(chrono::milliseconds(100));
+        }
+
+        atomic<bool> terminar{false};
+        vector<ResultadoCliente> resultados(configuracion.clientes);
+        vector<thread> clientes;
+        auto inicio = chrono::steady_clock::now();
+        for (size_t i = 0; i < configuracion.clientes; ++i)
+        {
+            clientes.emplace_back(ejecutarCliente, cref(configuracion), i, cref(terminar), ref(resultados[i]));
+        }
+        this_thread::sleep_for(chrono::duration<double>(configuracion.segundos));
+        terminar.store(true);
+        for (thread &cliente : clientes)
+        {
+            cliente.join();
+        }
+        double segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+
+        size_t lecturas = 0, escrituras = 0;
+        vector<double> latencias;
+        for (const ResultadoCliente &resultado : resultados)
+        {
+            lecturas += resultado.lecturas;
+            escrituras += resultado.escrituras;
+            latencias.insert(latencias.end(), resultado.latencias.begin(), resultado.latencias.end());
+        }
+        sort(latencias.begin(), latencias.end());
+
+        cout << "Clientes: " << configuracion.clientes << ", tanda: " << configuracion.tanda
+             << ", escrituras: " << configuracion.proporcionEscrituras * 100.0 << "%" << endl;
+        cout << "Operaciones: " << lecturas + escrituras << " en " << segundos << " s ("
+             << static_cast<size_t>((lecturas + escrituras) / segundos) << " ops/s; "
+             << static_cast<size_t>(lecturas / segundos) << " lecturas/s, "
+             << static_cast<size_t>(escrituras / segundos) << " escrituras/s)" << endl;
+        cout << "Latencia por tanda: p50 " << calcularPercentil(latencias, 50) << " us, p99 "
+             << calcularPercentil(latencias, 99) << " us" << endl;
+    }
+    catch (const exception &errorGeneral)
+    {
+        cout << "Error inesperado: " << errorGeneral.what() << endl;
+        return 1;
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,105 @@
+// Conteo de las reservas de memoria de un programa de la agenda (ver 'reservasMemoria')
+// Se reemplazan todas las formas globales de 'operator new' y 'operator delete' para contar cuántas veces se pide
+// memoria. Todas piden y liberan con las mismas dos funciones, así ninguna memoria reservada por una forma se
+// libera con la función de otra. Lo enlazan el programa de mediciones y el menú compilado con
+// -DAGENDA_ESTADISTICAS; el resto de la agenda no depende de este archivo.
+#include "AgendaContactos.h" // Para el contador 'reservasMemoria'
+#include <new>               // Para 'bad_alloc', 'nothrow_t' y 'align_val_t'
+#include <cstdlib>           // Para malloc, aligned_alloc y free
+#ifdef _WIN32
+#include <malloc.h> // Para la memoria alineada de 'operator new' (_aligned_malloc y _aligned_free)
+#endif
+
+// Función para pedir memoria contando la reserva; con 'alineacion' (formas con 'align_val_t') usa la versión alineada
+// Retorna 'nullptr' si no hay memoria
+void *reservarContando(size_t tamano, size_t alineacion = 0)
+{
+    reservasMemoria.fetch_add(1, memory_order_relaxed);
+    tamano = tamano > 0 ? tamano : 1;
+    if (alineacion == 0)
+    {
+        return malloc(tamano);
+    }
+#ifdef _WIN32
+    return _aligned_malloc(tamano, alineacion);
+#else
+    // 'aligned_alloc' pide que el tamaño sea múltiplo de la alineación
+    return aligned_alloc(alineacion, (tamano + alineacion - 1) / alineacion * alineacion);
+#endif
+}
+
+// Función para liberar la memoria de 'reservarContando' (con la misma 'alineacion' con que se pidió)
+void liberarContando(void *memoria, size_t alineacion = 0)
+{
+#ifdef _WIN32
+    if (alineacion != 0)
+    {
+        _aligned_free(memoria);
+        return;
+    }
+#endif
+    (void)alineacion;
+    free(memoria);
+}
+
+// Función para pedir memoria o lanzar 'bad_alloc' si no hay (las formas de 'operator new' sin 'nothrow')
+void *reservarOLanzar(size_t tamano, size_t alineacion = 0)
+{
+    if (void *memoria = reservarContando(tamano, alineacion))
+    {
+        return memoria;
+    }
+    throw bad_alloc();
+}
+
+void *operator new(size_t tamano) { return reservarOLanzar(tamano); }
+void *operator new[](size_t tamano) { return reservarOLanzar(tamano); }
+void *operator new(size_t tamano, const nothrow_t &) noexcept { return reservarContando(tamano); }
+void *operator new[](size_t tamano, const nothrow_t &) noexcept { return reservarContando(tamano); }
+void *operator new(size_t tamano, align_val_t alineacion)
+{
+    return reservarOLanzar(tamano, static_cast<size_t>(alineacion));
+}
+void *operator new[](size_t tamano, align_val_t alineacion)
+{
+    return reservarOLanzar(tamano, static_cast<size_t>(alineacion));
+}
+void *operator new(size_t tamano, align_val_t alineacion, const nothrow_t &) noexcept
+{
+    return reservarContando(tamano, static_cast<size_t>(alineacion));
+}
+void *operator new[](size_t tamano, align_val_t alineacion, const nothrow_t &) noexcept
+{
+    return reservarContando(tamano, static_cast<size_t>(alineacion));
+}
+
+void operator delete(void *memoria) noexcept { liberarContando(memoria); }
+void operator delete[](void *memoria) noexcept { liberarContando(memoria); }
+void operator delete(void *memoria, size_t) noexcept { liberarContando(memoria); }
+void operator delete[](void *memoria, size_t) noexcept { liberarContando(memoria); }
+void operator delete(void *memoria, const nothrow_t &) noexcept { liberarContando(memoria); }
+void operator delete[](void *memoria, const nothrow_t &) noexcept { liberarContando(memoria); }
+void operator delete(void *memoria, align_val_t alineacion) noexcept
+{
+    liberarContando(memoria, static_cast<size_t>(alineacion));
+}
+void operator delete[](void *memoria, align_val_t alineacion) noexcept
+{
+    liberarContando(memoria, static_cast<size_t>(alineacion));
+}
+void operator delete(void *memoria, size_t, align_val_t alineacion) noexcept
+{
+    liberarContando(memoria, static_cast<size_t>(alineacion));
+}
+void operator delete[](void *memoria, size_t, align_val_t alineacion) noexcept
+{
+    liberarContando(memoria, static_cast<size_t>(alineacion));
+}
+void operator delete(void *memoria, align_val_t alineacion, const nothrow_t &) noexcept
+{
+    liberarContando(memoria, static_cast<size_t>(alineacion));
+}
+void operator delete[](void *memoria, align_val_t alineacion, const nothrow_t &) noexcept
+{
+    liberarContando(memoria, static_cast<size_t>(alineacion));
+}
@@ -1,70 +1,20 @@
-#include <iostream>  // Para operaciones de entrada/salida (cout y cin)
-#include <vector>    // Para usar el contenedor vector (una lista dinámica)
-#include <string>    // Para trabajar con cadenas de texto (tipo string)
-#include <fstream>   // Para operaciones de archivo
-#include <limits>    // Para manejar los límites de los tipos de datos (como el valor máximo de un tipo int)
-#include <stdexcept> //Para el manejo de excepciones (errores que pueden ser capturados por try-catch)
-#include <algorithm> // Para usar funciones algoritmicas (ejemplo "sort")
-
-using namespace std;
-// Clase que representa un contacto en la agenda
-class Agenda
-{
-    // Atributo privado
-private:
-    string nombre;
-    string apellido;
-    string numeroDeCelular;
-    string email;
-
-    // Interfaz pública para interactuar con los atributos
-public:
-    // Constructor e inicializacion de las variables
-    Agenda(string nombre, string apellido, string numeroDeCelular, string email)
-        : nombre(nombre), apellido(apellido), numeroDeCelular(numeroDeCelular), email(email) {}
-
-    // Método para mostrar la información del contacto en la consola
-    void mostrarContacto()
-    {
-        cout << "Nombre: " << nombre << endl;                     // Muestra el contacto
-        cout << "Apellido: " << apellido << endl;                 // Muestra el apellido
-        cout << "Numero de Celular: " << numeroDeCelular << endl; // Muestra el número de celular
-        cout << "Email: " << email << endl;                       // Muestra el email
-    }
-
-    // Método para guardar un contacto en un archivo - toma una referencia a objetos de tipo ofstream como parámetro
-    void contactoArchivado(ofstream &archivo)
-    {
-        // Guarda el nombre, apellido, número de celular y email en el archivo
-        archivo << nombre << " " << apellido << " " << numeroDeCelular << " " << email << endl;
-    }
-
-    // Getters: Métodos para obtener el nombre y número de celular del contacto
-    string getNombre() const { return nombre; }
-    string getNumeroDeCelular() const { return numeroDeCelular; }
-};
-
-// Función para validar el número de celular (10 dígitos)
-bool validarNumeroCelular(const string &numero)
-{
-    // Se comprueba que el número tenga exactamente 10 caracteres
-    if (numero.size() != 10)
-    {
-        return false;
-    }
-
-    // Se recorre cada caracter en el número
-    for (char c : numero)
-    {
-        //  Se compueba si el carácter no es un dígito (debe estar entre '0' y '9')
-        if (c < '0' || c > '9')
-        {
-            return false;
-        }
-    }
-    // Retorna 'true' si todos los caracteres son dígitos  y la longitud es correcta
-    return true;
-}
+// Programa de la agenda de contactos: menú interactivo, modo por lotes, modo servicio y modo en disco
+// Compilar con CMake (objetivo 'agenda', ver CMakeLists.txt) o a mano junto con el núcleo de la agenda:
+//   g++ -std=c++17 -O2 -pthread Proyecto_AgendaContactos.cpp AgendaContactos.cpp -o agenda
+// Con -DAGENDA_ESTADISTICAS se miden las operaciones (opción 9 del menú y comando "stats" del modo por lotes);
+// para contar también las reservas de memoria se agrega Conteo_Memoria.cpp:
+//   g++ -std=c++17 -O2 -pthread -DAGENDA_ESTADISTICAS Proyecto_AgendaContactos.cpp AgendaContactos.cpp Conteo_Memoria.cpp -o agenda
+#include "AgendaContactos.h" // Núcleo de la agenda (almacén, índices, búsquedas y archivos)
+#include <memory>    // Para el archivo de comandos del modo por lotes (unique_ptr)
+#include <cstdio>    // Para escribir la salida del modo por lotes en bloques (fwrite) y con formato (snprintf)
+#include <iomanip>   // Para alinear la tabla de estadísticas (setw)
+#include <cstdlib>   // Para leer la memoria del modo en disco (strtoul)
+#ifndef _WIN32
+#include <csignal>      // Para terminar el modo servicio con Ctrl+C (SIGINT)
+#include <poll.h>       // Para esperar clientes sin bloquearse indefinidamente (poll)
+#include <sys/socket.h> // Para el socket local del modo servicio
+#include <sys/un.h>     // Para la dirección del socket local (sockaddr_un)
+#endif
 
 // Función para pedir el número de celular
 // Solicita un número de celular al usuario, lo valida asegurandose de tener exactamente 10 dígitos
@@ -91,108 +41,9 @@ string pedirNumeroCelular()
     }
 }
 
-// Función para validar un email
-// Verifica si el correo electrónico contiene los símbolos '@' y '.', y que el '@' aparece antes del '.'.
-bool validarEmail(const string &email)
-{
-    // Varibale para verificar si se encuentra el símbolo '@'.
-    bool tieneArroba = false;
-    // Variable para verificar si se encuentra el símbolo '.'.
-    bool tienePunto = false;
-    // Verifica si '@' aparece antes de '.'
-    bool arrobaAntesDePunto = false;
-
-    // Se recorre cada caracter del email
-    for (size_t i = 0; i < email.size(); i++)
-    {
-        // Si se encuentra el símbolo '@', retorna true.
-        if (email[i] == '@')
-        {
-            tieneArroba = true;
-            // Si ya se encontró un punto antes, se marca que '@' está antes de '.'
-            if (tienePunto)
-                arrobaAntesDePunto = true;
-        }
-
-        // Si se encuentra el punto, se marca que se encontró y la posible relación con el '@'
-        if (email[i] == '.')
-        {
-            tienePunto = true;
-            // Si ya se encontró un '@' antes, se marca que '@' está antes de '.'
-            if (tieneArroba)
-                arrobaAntesDePunto = true;
-        }
-    }
-
-    // Se verifica que estén ambos símbolos y que '@' aparezca antes de '.'
-    return tieneArroba && tienePunto && arrobaAntesDePunto;
-}
-
-// Función de búsqueda binaria
-// Realiza una búsqueda binaria en el vector de punteros a contactos (Agenda) para encontrar un contacto por su nombre.
-// Si encuentra el nombre, devuelve 'true' y guarda el índice del contacto en la variable 'index'.
-// Si no encuentra el nombre, devuelve 'false'
-// La búsqueda binaria asume que el vector de contactos está previamente ordenado por nombre.
-bool busquedaBinaria(const vector<Agenda *> &contactos, const string &nombre, int &index)
-{
-    // Inicializa los índices de búsqueda
-    int inicioRango = 0, finRango = contactos.size() - 1;
-
-    // Mientras el rango de búsqueda no esté vacío
-    while (inicioRango <= finRango)
-    {
-        // Calcula el índice del punto medio del rango de búsqueda
-        int indiceMedio = inicioRango + (finRango - inicioRango) / 2;
-
-        // Si el contacto en el punto medio tiene el nombre que buscamos
-        if (contactos[indiceMedio]->getNombre() == nombre)
-        {
-            // Guarda el índice donde se encuentra el contacto
-            index = indiceMedio;
-            // Retorna que se encontró el contacto
-            return true;
-        }
-        // Si el nombre que buscamos es mayor que el nombre del contacto en el medio, busca en la mitad derecha
-        else if (contactos[indiceMedio]->getNombre() < nombre)
-        {
-            // Actualiza el límite izquierdo para buscar en la mitad derecha
-            inicioRango = indiceMedio + 1;
-        }
-        // Si el nombre que buscamos es menor, busca en la mitad izquierda
-        else
-        {
-            // Actualiza el límite derecho para buscar en la mitad izquierda
-            finRango = indiceMedio - 1;
-        }
-    }
-    // Si no se encuentra el contacto, retorna false
-    return false;
-}
-
-// Función para ordenar los contactos por nombre dentro de cada grupo de letras (A-Z).
-// Recibe un arreglo de vectores de punteros a Agenda ('contactosPorLetra'), donde cada
-// índice representa una letra del alfabeto (0 = 'A',...,25 = 'Z')
-// La función ordena los contactos en cada grupo alfabético por su nombre en orden ascendente
-void ordenarContactosPorLetra(vector<Agenda *> contactosPorLetra[26])
-{
-    // Recorre cada grupo de letras (de A a la Z)
-    for (int i = 0; i < 26; ++i)
-    {
-        // Ordena el vector de contactos en el índice i (que corresponde a una letra del alfabeto)
-        sort(contactosPorLetra[i].begin(), contactosPorLetra[i].end(),
-             // Función lambda para comparar los nombres de los contactos de forma ascendente
-             [](Agenda *a, Agenda *b)
-             {
-                 // Compara los nombres de los contactos (a y b) en orden alfabético ascendente
-                 // Las flechitas permiten acceder a los miembros del objeto clase Agenda
-                 return a->getNombre() < b->getNombre();
-             });
-    }
-}
-
 // Función para agregar un contacto
-// Recibe un arreglo de vectores 'contactosPorLetra' que organiza los contactos por la primera letra del nombre
-void agregarContacto(vector<Agenda *> contactosPorLetra[26])
+// Recibe la agenda, cuyas particiones organizan los contactos por rangos de nombres en orden alfabético
+void agregarContacto(AgendaContactos &agenda)
 {
     string nombre, apellido, email, numeroDeCelular;
 
@@ -218,23 +69,19 @@ void agregarContacto(vector<Agenda *> contactosPorLetra[26])
         return; // Si el email no es válido, termina la función
     }
 
-    // Verifica si el nombre comienza con una letra (mayúscula o minuscula)
-    if ((nombre[0] >= 'A' && nombre[0] <= 'Z') || (nombre[0] >= 'a' && nombre[0] <= 'z'))
+    // Verifica si el nombre comienza con una letra (mayúscula o minuscula, con o sin acento, o la Ñ)
+    if (calcularLetraInicial(nombre) >= 0)
     {
-        // Si el nombre comienza con una letra válida, crea un nuevo contacto.
-        Agenda *nuevoContacto = new Agenda(nombre, apellido, numeroDeCelular, email);
-
-        // Calcula la letra inicial del nombre para determinar para determinar en qué grupo de contacto se almacenará
-        int letraInicial = toupper(nombre[0]) - 'A';
+        // Calcula la letra inicial del nombre (las acentuadas cuentan como su letra y la Ñ como la N)
+        int letraInicial = calcularLetraInicial(nombre);
 
         // Verifica si la letra inicial está dentro del rango A-Z
         if (letraInicial >= 0 && letraInicial < 26)
         {
-            // Agrega el nuevo contacto al grupo correspondiente según la letra inicial
-            contactosPorLetra[letraInicial].push_back(nuevoContacto);
-
-            // Ordena los contactos dentro de cada grupo de letras por nombre
-            ordenarContactosPorLetra(contactosPorLetra);
+            // Si el nombre comienza con una letra válida, registra el nuevo contacto: lo guarda en el almacén,
+            // lo inserta en su posición (por nombre) dentro de su partición y lo indexa por número
+            MedicionOperacion medicion(OPERACION_AGREGAR);
+            registrarContacto(agenda, nombre, apellido, numeroDeCelular, email);
         }
         else
         {
@@ -250,8 +97,8 @@ void agregarContacto(vector<Agenda *> contactosPorLetra[26])
 }
 
 // Función para buscar un contacto en la agenda
-// Recibe un arreglo de vectores 'ContactosPorLetra' que organiza los contactos por la primera letra del nombre.
-void buscarContacto(vector<Agenda *> contactosPorLetra[26])
+// Recibe la agenda, cuyas particiones organizan los contactos por rangos de nombres en orden alfabético.
+void buscarContacto(AgendaContactos &agenda)
 {
     string nombre;
 
@@ -260,34 +107,48 @@ void buscarContacto(vector<Agenda *> contactosPorLetra[26])
     getline(cin, nombre);
 
     // Verifica que el nombre ingrese por el usuario comience con una letra del alfabeto
-    if (!(nombre[0] >= 'A' && nombre[0] <= 'Z') && !(nombre[0] >= 'a' && nombre[0] <= 'z'))
+    if (calcularLetraInicial(nombre) < 0)
     {
         cout << "El nombre debe comenzar con una letra del alfabeto." << endl;
         return; // Si no comienza con una letra, termina la función
     }
 
-    // Calcula el índice basado en la letra inicial del nombre para determinar el grupo alfabético
-    int letraInicial = toupper(nombre[0]) - 'A';
+    // Calcula el índice de la letra inicial del nombre (las acentuadas cuentan como su letra y la Ñ como la N)
+    int letraInicial = calcularLetraInicial(nombre);
 
     // Verifica si la letra inicial es válida (en el rango de A-Z)
     if (letraInicial >= 0 && letraInicial < 26)
     {
-        // Accede al grupo de contactos correspondientes a la letra inicial del nombre
-        vector<Agenda *> &listaContactos = contactosPorLetra[letraInicial];
+        // Accede a la partición cuyo rango de nombres contiene el nombre buscado
+        size_t particion = agenda.particiones.ubicar(nombre);
+        const vector<uint32_t> &listaContactos = agenda.particiones.getContactos(particion);
 
         // Variable para almacenar el índice del contacto encontrado
         int index;
 
         // Realiza una búsqueda binaria en la lista de contactos para encontrar el nombre
-        if (busquedaBinaria(listaContactos, nombre, index))
+        // (se mide solo la búsqueda, sin lo que se muestra en la consola)
+        bool encontrado;
+        {
+            MedicionOperacion medicion(OPERACION_BUSCAR);
+            encontrado = busquedaBinaria(agenda.almacen, listaContactos, nombre, index);
+        }
+        if (encontrado)
         {
             // Si encuentra el contacto, muestra la información
-            listaContactos[index]->mostrarContacto();
+            agenda.almacen.getContacto(listaContactos[index]).mostrarContacto();
         }
         else
         {
             // Si no encuentra el contacto, muestra un mensaje
             cout << "El nombre no se encontró." << endl;
+
+            // Sugiere los nombres parecidos por si hubo un error de escritura (por ejemplo "Jaun" por "Juan")
+            vector<ResultadoAproximado> sugerencias = buscarAproximado(agenda, nombre, 2, 3);
+            for (const ResultadoAproximado &sugerencia : sugerencias)
+            {
+                cout << "Quiso decir: " << agenda.almacen.getNombre(sugerencia.contacto) << "?" << endl;
+            }
         }
     }
     else
@@ -298,8 +159,8 @@ void buscarContacto(vector<Agenda *> contactosPorLetra[26])
 }
 
 // Función para editar un contacto en la agenda
-// Recibe un arreglo de vectores 'contactosPorLetra' que organiza los contactos por la primera letra del nombre.
-void editarContacto(vector<Agenda *> contactosPorLetra[26])
+// Recibe la agenda, cuyas particiones organizan los contactos por rangos de nombres en orden alfabético.
+void editarContacto(AgendaContactos &agenda)
 {
     string nombre;
 
@@ -308,44 +169,93 @@ void editarContacto(vector<Agenda *> contactosPorLetra[26])
     getline(cin, nombre);
 
     // Verifica que el nombre comience con una letra del alfabeto (mayúscula o minúscula)
-    if (!(nombre[0] >= 'A' && nombre[0] <= 'Z') && !(nombre[0] >= 'a' && nombre[0] <= 'z'))
+    if (calcularLetraInicial(nombre) < 0)
     {
         cout << "El nombre debe comenzar con una letra del alfabeto." << endl;
         return; // Si no comienza con una letra, termina la función
     }
 
-    // Calcula el índice basado en la letra inicial del nombre para determinar el grupo alfabético
-    int letraInicial = toupper(nombre[0]) - 'A';
+    // Calcula el índice de la letra inicial del nombre (las acentuadas cuentan como su letra y la Ñ como la N)
+    int letraInicial = calcularLetraInicial(nombre);
 
     // Verifica si la letra inicial es válida (en el rango de A-Z)
     if (letraInicial >= 0 && letraInicial < 26)
     {
-        // Accede al grupo de contactos correspondientes a la letra inicial del nombre
-        vector<Agenda *> &listaContactos = contactosPorLetra[letraInicial];
+        // Accede a la partición cuyo rango de nombres contiene el nombre buscado
+        size_t particion = agenda.particiones.ubicar(nombre);
+        const vector<uint32_t> &listaContactos = agenda.particiones.getContactos(particion);
 
         // Variable para almacenar el índice del contacto encontrado
         int index;
 
         // Realiza una búsqueda binaria en la lista de contactos para encontrar el nombre
-        if (busquedaBinaria(listaContactos, nombre, index))
+        if (busquedaBinaria(agenda.almacen, listaContactos, nombre, index))
         {
             // Si se encuentra el contacto, permite modificar sus datos
+            // Los campos que se dejan vacíos no cambian
+            uint32_t contacto = listaContactos[index];
             string nuevoNombre, nuevoApellido, nuevoNumero, nuevoEmail;
-            cout << "Ingrese el nuevo nombre: ";
+            cout << "Ingrese el nuevo nombre (Enter para no cambiarlo): ";
             getline(cin, nuevoNombre);
-            cout << "Ingrese el nuevo apellido: ";
+            if (!nuevoNombre.empty() && calcularLetraInicial(nuevoNombre) < 0)
+            {
+                cout << "El nombre debe comenzar con una letra del alfabeto." << endl;
+                return;
+            }
+            cout << "Ingrese el nuevo apellido (Enter para no cambiarlo): ";
             getline(cin, nuevoApellido);
-            cout << "Ingrese el nuevo numero: ";
-            getline(cin, nuevoNumero);
-            cout << "Ingrese el nuevo email: ";
+            // El número se guarda empaquetado, así que también se valida al editar
+            while (true)
+            {
+                cout << "Ingrese el nuevo numero de celular (Enter para no cambiarlo): ";
+                getline(cin, nuevoNumero);
+                if (nuevoNumero.empty() || validarNumeroCelular(nuevoNumero))
+                {
+                    break;
+                }
+                cout << "Numero de celular no valido. " << endl;
+            }
+            cout << "Ingrese el nuevo email (Enter para no cambiarlo): ";
             getline(cin, nuevoEmail);
+            if (!nuevoEmail.empty() && !validarEmail(nuevoEmail))
+            {
+                cout << "Email no válido." << endl;
+                return;
+            }
 
-            // Elimina el contacto anterior (previa liberación de memoria) y crea uno nuevo con los datos actualizados
-            delete listaContactos[index];
-            listaContactos[index] = new Agenda(nuevoNombre, nuevoApellido, nuevoNumero, nuevoEmail);
-
-            // Muestra un mensaje indicando que el contacto fue actualizado con éxito
-            cout << "Contacto actualizado exitosamente." << endl;
+            // Actualiza solo los campos que cambian (si cambia el nombre, se reubica en la partición que le corresponde)
+            CambiosContacto cambios;
+            if (!nuevoNombre.empty())
+            {
+                cambios.nombre = nuevoNombre;
+            }
+            if (!nuevoApellido.empty())
+            {
+                cambios.apellido = nuevoApellido;
+            }
+            if (!nuevoNumero.empty())
+            {
+                cambios.numero = empaquetarNumeroCelular(nuevoNumero);
+            }
+            if (!nuevoEmail.empty())
+            {
+                cambios.email = nuevoEmail;
+            }
+            // Se mide solo la actualización: el resto de la función espera lo que escribe el usuario
+            bool actualizado;
+            {
+                MedicionOperacion medicion(OPERACION_EDITAR);
+                actualizado = actualizarContacto(agenda, contacto, cambios);
+            }
+            if (actualizado)
+            {
+                // Muestra un mensaje indicando que el contacto fue actualizado con éxito
+                cout << "Contacto actualizado exitosamente." << endl;
+            }
+            else
+            {
+                cout << "No hubo cambios en el contacto." << endl;
+            }
         }
         else
         {
@@ -361,8 +271,8 @@ void editarContacto(vector<Agenda *> contactosPorLetra[26])
 }
 
 // Función para eliminar un contacto de la agenda
-// Recibe un arreglo de vectores `contactosPorLetra` que organiza los contactos por la primera letra del nombre.
-void eliminarContacto(vector<Agenda *> contactosPorLetra[26])
+// Recibe la agenda, cuyas particiones organizan los contactos por rangos de nombres en orden alfabético.
+void eliminarContacto(AgendaContactos &agenda)
 {
     string nombre;
 
@@ -370,8 +280,8 @@ void eliminarContacto(vector<Agenda *> contactosPorLetra[26])
     cout << "Ingrese el nombre para eliminar contacto: ";
     getline(cin, nombre);
 
-    // Calcula el índice basado en la letra inicial del nombre para determinar el grupo alfabético
-    int letraInicial = toupper(nombre[0]) - 'A';
+    // Calcula el índice de la letra inicial del nombre (las acentuadas cuentan como su letra y la Ñ como la N)
+    int letraInicial = calcularLetraInicial(nombre);
 
     // Verifica que el nombre no esté vacío
     if (nombre.size() == 0)
@@ -383,10 +293,11 @@ void eliminarContacto(vector<Agenda *> contactosPorLetra[26])
     // Verifica si la letra inicial es válida (en el rango de A-Z)
     if (letraInicial >= 0 && letraInicial < 26)
     {
-        // Accede al grupo de contactos correspondientes a la letra inicial del nombre
-        vector<Agenda *> &listaContactos = contactosPorLetra[letraInicial];
+        // Accede a la partición cuyo rango de nombres contiene el nombre buscado
+        size_t particion = agenda.particiones.ubicar(nombre);
+        const vector<uint32_t> &listaContactos = agenda.particiones.getContactos(particion);
 
-        // Verifica si hay contactos en el grupo correspondiente
+        // Verifica si hay contactos en la partición correspondiente
         if (listaContactos.size() == 0)
         {
             cout << "No hay contactos disponibles para eliminar en esta categoría." << endl;
@@ -396,17 +307,19 @@ void eliminarContacto(vector<Agenda *> contactosPorLetra[26])
         // Variable para almacenar el índice del contacto encontrado
         int index;
 
-        // Realiza una búsqueda binaria para encontrar el contacto por su nombre
-        if (busquedaBinaria(listaContactos, nombre, index))
+        // Realiza una búsqueda binaria para encontrar el contacto por su nombre y, si lo encuentra, lo elimina
+        // (se mide la búsqueda y el borrado, sin lo que se muestra en la consola)
+        bool eliminado;
+        {
+            MedicionOperacion medicion(OPERACION_ELIMINAR);
+            eliminado = busquedaBinaria(agenda.almacen, listaContactos, nombre, index);
+            if (eliminado)
+            {
+                borrarContacto(agenda, particion, index);
+            }
+        }
+        if (eliminado)
         {
-            // Si el contacto es encontrado, lo elimina
-            // Elimina el contacto de la memoria
-            delete listaContactos[index];
-            // Reemplaza el contacto eliminado con el último de la lista
-            listaContactos[index] = listaContactos.back();
-            // Elimina el último contacto de la lista
-            listaContactos.pop_back();
-
             cout << "Contacto eliminado exitosamente." << endl;
         }
         else
@@ -422,39 +335,288 @@ void eliminarContacto(vector<Agenda *> contactosPorLetra[26])
     }
 }
 
-// Función para guardar los contactos en un archivo
-void guardarContacto(vector<Agenda *> contactosPorLetra[26])
+// Función para buscar contactos por su número de celular
+// Recibe la agenda y usa su índice por número, así no recorre las particiones
+void buscarContactoPorNumero(AgendaContactos &agenda)
 {
-    try
+    // Solicita el número usando la función 'pedirNumeroCelular' (valida los 10 dígitos)
+    string numeroDeCelular = pedirNumeroCelular();
+
+    // Muestra todos los contactos que tienen ese número
+    size_t encontrados = 0;
+    agenda.indiceTelefonos.buscarTodos(agenda.almacen, empaquetarNumeroCelular(numeroDeCelular), [&](uint32_t contacto)
+                                       {
+                                           agenda.almacen.getContacto(contacto).mostrarContacto();
+                                           encontrados++;
+                                           return true;
+                                       });
+
+    if (encontrados == 0)
+    {
+        // Si no hay contactos con ese número, muestra un mensaje
+        cout << "El numero no se encontró." << endl;
+    }
+}
+
+// Función para buscar contactos por el comienzo de su nombre
+// Muestra en orden alfabético los primeros contactos cuyo nombre comienza con lo que escribe el usuario
+void buscarContactoPorPrefijo(AgendaContactos &agenda)
+{
+    // Cantidad máxima de resultados que se muestran
+    const size_t limiteResultados = 20;
+    string prefijo;
+
+    // Solicita al usuario el comienzo del nombre
+    cout << "Ingrese el comienzo del nombre: ";
+    getline(cin, prefijo);
+
+    // Verifica que el prefijo comience con una letra del alfabeto
+    if (calcularLetraInicial(prefijo) < 0)
+    {
+        cout << "El nombre debe comenzar con una letra del alfabeto." << endl;
+        return;
+    }
+
+    // Muestra un contacto por línea: nombre, apellido y número
+    size_t encontrados = buscarPorPrefijo(agenda, prefijo, limiteResultados, [&](uint32_t contacto)
+                                          {
+                                              Agenda datos = agenda.almacen.getContacto(contacto);
+                                              cout << datos.getNombre() << " " << datos.getApellido() << " - "
+                                                   << datos.getNumeroDeCelular() << endl;
+                                          });
+
+    if (encontrados == 0)
+    {
+        cout << "Ningun nombre comienza con \"" << prefijo << "\"." << endl;
+    }
+    else if (encontrados == limiteResultados)
+    {
+        cout << "Se muestran los primeros " << limiteResultados << " resultados." << endl;
+    }
+}
+
+// Función para buscar contactos por apellido, por dominio del email o por los dos a la vez
+// Usa los índices por apellido y por dominio, así no recorre toda la agenda
+void buscarContactoPorGrupo(AgendaContactos &agenda)
+{
+    // Cantidad máxima de resultados que se muestran
+    const size_t limiteResultados = 20;
+    string apellido, dominio;
+
+    cout << "Ingrese el apellido (Enter para no buscar por apellido): ";
+    getline(cin, apellido);
+    cout << "Ingrese el dominio del email, por ejemplo empresa.com (Enter para no buscar por dominio): ";
+    getline(cin, dominio);
+    if (!dominio.empty() && dominio[0] == '@')
+    {
+        dominio.erase(0, 1);
+    }
+    if (apellido.empty() && dominio.empty())
+    {
+        cout << "Debe ingresar el apellido, el dominio o los dos." << endl;
+        return;
+    }
+
+    // Muestra un contacto por línea: nombre, apellido, número y email
+    size_t total = buscarPorGrupo(agenda, apellido, dominio, limiteResultados, [&](uint32_t contacto)
+                                  {
+                                      Agenda datos = agenda.almacen.getContacto(contacto);
+                                      cout << datos.getNombre() << " " << datos.getApellido() << " - "
+                                           << datos.getNumeroDeCelular() << " - " << datos.getEmail() << endl;
+                                  });
+
+    if (total == 0)
+    {
+        cout << "Ningun contacto cumple la busqueda." << endl;
+    }
+    else
+    {
+        cout << "Se encontraron " << total << " contactos";
+        if (total > limiteResultados)
+        {
+            cout << " (se muestran los primeros " << limiteResultados << ")";
+        }
+        cout << "." << endl;
+    }
+}
+
+// Función para mostrar los contactos cuyo nombre se parece al que escribe el usuario
+// Tolera errores de escritura hasta la distancia de edición que indique el usuario
+void buscarContactoAproximado(AgendaContactos &agenda)
+{
+    // Cantidad máxima de resultados que se muestran
+    const size_t limiteResultados = 10;
+    string nombre, textoDistancia;
+
+    // Solicita al usuario el nombre y la cantidad de errores que se toleran
+    cout << "Ingrese el nombre: ";
+    getline(cin, nombre);
+    cout << "Ingrese la distancia maxima de edicion (Enter para 2): ";
+    getline(cin, textoDistancia);
+
+    // Si la distancia no es un número entre 0 y 9 se usa el valor por defecto
+    int distanciaMaxima = 2;
+    if (textoDistancia.size() == 1 && textoDistancia[0] >= '0' && textoDistancia[0] <= '9')
+    {
+        distanciaMaxima = textoDistancia[0] - '0';
+    }
+
+    vector<ResultadoAproximado> resultados = buscarAproximado(agenda, nombre, distanciaMaxima, limiteResultados);
+    if (resultados.empty())
+    {
+        cout << "No hay nombres parecidos a \"" << nombre << "\"." << endl;
+        return;
+    }
+
+    // Muestra un contacto por línea con su distancia de edición
+    for (const ResultadoAproximado &resultado : resultados)
     {
-        // Intenta abrir el archivo "contactos.txt" en modo de escritura
-        ofstream archivoDeContactos("contactos.txt", ios::out);
+        Agenda datos = agenda.almacen.getContacto(resultado.contacto);
+        cout << datos.getNombre() << " " << datos.getApellido() << " - " << datos.getNumeroDeCelular()
+             << " (distancia " << resultado.distancia << ")" << endl;
+    }
+}
 
-        // Si no se pudo abrir el archivo, lanza una excepción
-        if (!archivoDeContactos.is_open())
+// Función para escribir el informe de los grupos de duplicados: por cada grupo, el contacto que se conserva, los
+// que se eliminan y, si la fusión cambia al que se conserva, cómo queda
+// Se escribe antes de fusionar, mientras los contactos eliminados todavía están en la agenda.
+void escribirInformeDuplicados(const AgendaContactos &agenda, const GruposDuplicados &grupos, PoliticaFusion politica,
+                               ostream &informe)
+{
+    const AlmacenContactos &almacen = agenda.almacen;
+    auto escribirContacto = [&](const char *etiqueta, string_view nombre, string_view apellido, uint64_t numero,
+                                string_view email)
+    {
+        informe << "  " << etiqueta << nombre << " " << apellido << " - " << desempaquetarNumeroCelular(numero) << " - "
+                << email << '\n';
+    };
+    CambiosContacto cambios;
+    for (size_t grupo = 0; grupo < grupos.getCantidadGrupos(); ++grupo)
+    {
+        informe << "Grupo " << grupo + 1 << " (" << grupos.inicioGrupos[grupo + 1] - grupos.inicioGrupos[grupo]
+                << " contactos; por";
+        const char *separador = " ";
+        const char *nombresCriterios[] = {"numero", "email", "nombre"};
+        for (int criterio = 0; criterio < 3; ++criterio)
         {
-            throw runtime_error("Error al abrir el archivo para guardar los contactos.");
+            if (grupos.criterios[grupo] & (1 << criterio))
+            {
+                informe << separador << nombresCriterios[criterio];
+                separador = ", ";
+            }
         }
+        informe << ")" << '\n';
 
-        // Itera sobre cada letra (A-Z) para guardar los contactos correspondientes
-        for (int i = 0; i < 26; i++)
+        uint32_t conservado = prepararFusion(almacen, grupos, grupo, politica, cambios);
+        escribirContacto("conserva: ", almacen.getNombre(conservado), almacen.getApellido(conservado),
+                         almacen.getNumeroEmpaquetado(conservado), almacen.getEmail(conservado));
+        for (size_t i = grupos.inicioGrupos[grupo]; i < grupos.inicioGrupos[grupo + 1]; ++i)
         {
-            for (size_t j = 0; j < contactosPorLetra[i].size(); ++j)
+            uint32_t contacto = grupos.contactos[i];
+            if (contacto != conservado)
             {
-                // Guarda cada contacto en el archivo
-                contactosPorLetra[i][j]->contactoArchivado(archivoDeContactos);
+                escribirContacto("elimina:  ", almacen.getNombre(contacto), almacen.getApellido(contacto),
+                                 almacen.getNumeroEmpaquetado(contacto), almacen.getEmail(contacto));
             }
         }
+        if (politica == FUSION_MAYORIA &&
+            (*cambios.nombre != almacen.getNombre(conservado) || *cambios.apellido != almacen.getApellido(conservado) ||
+             *cambios.numero != almacen.getNumeroEmpaquetado(conservado) || *cambios.email != almacen.getEmail(conservado)))
+        {
+            escribirContacto("queda:    ", *cambios.nombre, *cambios.apellido, *cambios.numero, *cambios.email);
+        }
+    }
+}
+
+// Función para buscar los contactos duplicados y fusionarlos
+// Muestra cuántos hay y algunos grupos de ejemplo, y solo fusiona si el usuario elige una política. El detalle
+// de cada grupo fusionado queda en "duplicados.txt".
+void fusionarContactosDuplicados(AgendaContactos &agenda)
+{
+    // Cantidad de grupos de ejemplo que se muestran
+    const size_t gruposMostrados = 5;
+    string respuesta;
+
+    ConfiguracionDuplicados configuracion;
+    cout << "Unir tambien los contactos con el mismo nombre y apellido aunque no compartan numero ni email? (s/n): ";
+    getline(cin, respuesta);
+    if (respuesta == "s" || respuesta == "S")
+    {
+        configuracion.criterios |= DUPLICADO_NOMBRE;
+    }
+
+    auto inicio = chrono::steady_clock::now();
+    GruposDuplicados grupos = detectarDuplicados(agenda, configuracion);
+    auto milisegundos = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - inicio).count();
+    if (grupos.getCantidadGrupos() == 0)
+    {
+        cout << "No se encontraron contactos duplicados (" << milisegundos << " ms)." << endl;
+        return;
+    }
+    cout << "Se encontraron " << grupos.getCantidadGrupos() << " grupos de duplicados con "
+         << grupos.getCantidadDuplicados() << " contactos de mas (" << milisegundos << " ms)." << endl;
+
+    // Muestra los primeros grupos, un contacto por línea
+    for (size_t grupo = 0; grupo < min(gruposMostrados, grupos.getCantidadGrupos()); ++grupo)
+    {
+        cout << "Grupo " << grupo + 1 << ":" << endl;
+        for (size_t i = grupos.inicioGrupos[grupo]; i < grupos.inicioGrupos[grupo + 1]; ++i)
+        {
+            Agenda datos = agenda.almacen.getContacto(grupos.contactos[i]);
+            cout << "  " << datos.getNombre() << " " << datos.getApellido() << " - " << datos.getNumeroDeCelular()
+                 << " - " << datos.getEmail() << endl;
+        }
+    }
+
+    cout << "Como fusionar cada grupo? 1. Conservar el primero. 2. Conservar el ultimo. "
+         << "3. Combinar (el valor mas repetido de cada campo). Enter para no fusionar: ";
+    getline(cin, respuesta);
+    if (respuesta != "1" && respuesta != "2" && respuesta != "3")
+    {
+        cout << "No se fusiono ningun contacto." << endl;
+        return;
+    }
+    PoliticaFusion politica = respuesta == "1" ? FUSION_PRIMERO : (respuesta == "2" ? FUSION_ULTIMO : FUSION_MAYORIA);
+
+    // El informe se escribe antes de fusionar, mientras los contactos eliminados siguen en la agenda
+    ofstream informe("duplicados.txt");
+    if (!informe.is_open())
+    {
+        cout << "No se pudo crear el archivo duplicados.txt; no se fusiono ningun contacto." << endl;
+        return;
+    }
+    escribirInformeDuplicados(agenda, grupos, politica, informe);
+    informe.close();
+
+    size_t eliminados = fusionarDuplicados(agenda, grupos, politica);
+    cout << "Se eliminaron " << eliminados << " contactos duplicados. El detalle quedo en duplicados.txt." << endl;
+}
+
+// Función para guardar los contactos
+// Cada cambio ya queda anotado en el diario de cambios, así que guardar solo confirma en el disco los que
+// estén pendientes: cuesta lo que miden los cambios y no lo que mide la agenda. El archivo binario completo
+// ("contactos.agdb") lo reescribe la compactación del diario en segundo plano.
+void guardarContacto(AgendaContactos &agenda)
+{
+    try
+    {
+        if (agenda.diario != nullptr)
+        {
+            size_t confirmados = agenda.diario->confirmar();
+            cout << "Se confirmaron " << confirmados << " cambios pendientes." << endl;
+        }
+        else
+        {
+            // Sin diario se guarda la agenda completa en el archivo binario
+            guardarInstantanea(agenda, "contactos.agdb");
+        }
 
         // Informa que los contactos se guardaron correctamente
         cout << "Contactos guardados en el archivo exitosamente." << endl;
-
-        // Cierra el archivo
-        archivoDeContactos.close();
     }
     catch (const runtime_error &errorArchivo)
     {
-        // Si ocurre un error al abrir el archivo, muestra un mensaje de excepción
+        // Si ocurre un error al escribir el archivo, muestra un mensaje de excepción
         cout << "Excepción al guardar el archivo: " << errorArchivo.what() << endl;
     }
     catch (const exception &errorGeneral)
@@ -464,81 +626,1496 @@ void guardarContacto(vector<Agenda *> contactosPorLetra[26])
     }
 }
 
-// Función principal
-int main()
+// Función para mostrar las latencias de las operaciones, los bytes escritos y las reservas de memoria
+// Solo si el programa se compiló con -DAGENDA_ESTADISTICAS; si no, avisa que están desactivadas.
+void mostrarLatencias()
 {
-    // Array de vectores para almacenar los contactos, agrupados por la primera letra del nombre
-    vector<Agenda *> contactosPorLetra[26];
-    int opcion; // Variable que almacena la opción seleccionada por el usuario
+#ifdef AGENDA_ESTADISTICAS
+    // Las latencias se muestran en microsegundos
+    cout << fixed << left << setw(12) << "Operacion" << right << setw(10) << "Cantidad" << setw(12) << "Promedio"
+         << setw(12) << "p50" << setw(12) << "p99" << setw(12) << "p99.9" << setw(12) << "Maximo" << endl;
+    for (int operacion = 0; operacion < CANTIDAD_OPERACIONES; ++operacion)
+    {
+        const HistogramaLatencias &latencias = estadisticasAgenda.latencias[operacion];
+        cout << left << setw(12) << NOMBRES_OPERACIONES[operacion] << right << setw(10) << latencias.getCantidad()
+             << setprecision(2) << setw(12) << latencias.getPromedio() / 1000.0
+             << setw(12) << latencias.calcularPercentil(50) / 1000.0
+             << setw(12) << latencias.calcularPercentil(99) / 1000.0
+             << setw(12) << latencias.calcularPercentil(99.9) / 1000.0
+             << setw(12) << latencias.getMaximo() / 1000.0 << endl;
+    }
+    cout << "Bytes escritos: " << estadisticasAgenda.bytesEscritos.load() << endl;
+    cout << "Reservas de memoria: " << reservasMemoria.load() << endl;
+#else
+    cout << "Las mediciones de las operaciones estan desactivadas (compilar con -DAGENDA_ESTADISTICAS)." << endl;
+#endif
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
+}
 
-    // try-catch para manejar errores, como problemas al guardar el archivo o errores inesperados
-    try
+// Función para mostrar las estadísticas de la agenda
+// El tamaño de las particiones se muestra siempre; las latencias de las operaciones, los bytes escritos y las
+// reservas de memoria solo si el programa se compiló con -DAGENDA_ESTADISTICAS.
+void mostrarEstadisticas(const AgendaContactos &agenda)
+{
+    EstadisticasParticiones particiones = agenda.particiones.calcularEstadisticas();
+    cout << "Particiones: " << particiones.cantidad << " con " << particiones.contactos << " contactos (minimo "
+         << particiones.minimo << ", maximo " << particiones.maximo << ", promedio " << fixed << setprecision(1)
+         << particiones.promedio << ", lapidas " << particiones.borrados << ")" << endl;
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
+    mostrarLatencias();
+}
+
+// Clase que junta la salida del modo por lotes en un búfer grande y la escribe de a bloques
+// Reemplaza a 'cout << ... << endl', que vacía la salida en cada línea. Sin destino ('nullptr') solo junta la
+// salida en memoria: el búfer crece lo que haga falta y el texto se lee con 'getTexto'.
+class SalidaLote
+{
+private:
+    FILE *destino;
+    vector<char> bufer;
+    size_t usados;
+
+public:
+    explicit SalidaLote(FILE *destino, size_t capacidad = 1 << 20)
+        : destino(destino), bufer(capacidad), usados(0) {}
+
+    ~SalidaLote() { vaciar(); }
+
+    // La salida no se puede copiar (se escribiría dos veces)
+    SalidaLote(const SalidaLote &) = delete;
+    SalidaLote &operator=(const SalidaLote &) = delete;
+
+    // Método para escribir en el destino lo que está en el búfer
+    void vaciar()
     {
-        // El ciclo se repite hasta que el usuario seleccione la opción 6 (Salir)
-        do
+        if (usados > 0 && destino != nullptr)
         {
-            // Muestra el menú de opciones para el usuario
-            cout << endl;
-            cout << "MENU AGENDA DE CONTACTOS " << endl;
-            cout << "1. Agregar contacto. " << endl;
-            cout << "2. Buscar contacto. " << endl;
-            cout << "3. Editar contacto. " << endl;
-            cout << "4. Eliminar contacto. " << endl;
-            cout << "5. Guardar contacto. " << endl;
-            cout << "6. Salir. " << endl;
-
-            // Solicita al usuario que elija una opción
-            cout << "Elegir una opcion: ";
-            cin >> opcion;
+            fwrite(bufer.data(), 1, usados, destino);
+            usados = 0;
+        }
+    }
 
-            // VALIDACIÓN DE ENTRADA AL USUARIO
-            // Verifica si la entrada es válida. Si no, muestra un mensaje de error y repite el ciclo
-            if (cin.fail())
+    // Método para agregar un texto a la salida
+    void escribir(string_view texto)
+    {
+        if (bufer.size() - usados < texto.size())
+        {
+            if (destino == nullptr)
             {
-                cin.clear();                                         // Limpia el estado de error y vuelve a funcionar
-                cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Descarta la entrada incorrecta
-                cout << endl;
-                cout << "Opcion no valida. Por favor, ingrese un número entero entre 1 y 6." << endl;
-                continue; // Vuelve a mostrar el menú si la entrada es incorrecta
+                bufer.resize(max(bufer.size() * 2, usados + texto.size()));
             }
-
-            // Limpia el buffer de entrada para evitar problemas con el getline posterior
-            cin.ignore();
-
-            // Ejecuta la opción correspondiente según la elección del usuario
-            switch (opcion)
+            else
             {
-            case 1: // Agregar un nuevo contacto
-                agregarContacto(contactosPorLetra);
-                break;
-            case 2: // Buscar un contacto por nombre
-                buscarContacto(contactosPorLetra);
-                break;
-            case 3: // Editar un contacto existente
-                editarContacto(contactosPorLetra);
-                break;
-            case 4: // Eliminar un contacto
-                eliminarContacto(contactosPorLetra);
-                break;
-            case 5: // Guardar los contactos en un archivo
-                guardarContacto(contactosPorLetra);
-                break;
-            case 6: // Salir del programa
-                cout << "Gracias por usar la agenda de contactos. ¡Hasta pronto!" << endl;
-                break;
-            default: // Si la opción no es válida
-                cout << "Opción no válida. " << endl;
+                vaciar();
+                if (texto.size() > bufer.size())
+                {
+                    fwrite(texto.data(), 1, texto.size(), destino);
+                    return;
+                }
             }
-        } while (opcion != 6); // Repite el ciclo hasta que el usuario elija salir (opción 6)
+        }
+        memcpy(bufer.data() + usados, texto.data(), texto.size());
+        usados += texto.size();
+    }
 
-        // Liberación de memoria para los objetos Agenda creados dinámicamente
-        for (int i = 0; i < 26; ++i)
+    // Método para agregar un caracter a la salida
+    void escribir(char caracter)
+    {
+        if (usados == bufer.size())
         {
-            for (size_t j = 0; j < contactosPorLetra[i].size(); ++j)
+            if (destino == nullptr)
+            {
+                bufer.resize(max<size_t>(bufer.size() * 2, 1));
+            }
+            else
             {
-                delete contactosPorLetra[i][j]; // Elimina cada contacto para liberar la memoria
+                vaciar();
             }
         }
+        bufer[usados++] = caracter;
+    }
+
+    // Métodos para la salida en memoria: cuánto se escribió, el texto entre dos posiciones y descartar todo
+    size_t getUsados() const { return usados; }
+    string_view getTexto(size_t inicio, size_t fin) const { return string_view(bufer.data() + inicio, fin - inicio); }
+    void descartar() { usados = 0; }
+
+    // Método para agregar un número de celular empaquetado (10 dígitos) sin crear un string
+    void escribirNumeroCelular(uint64_t numero)
+    {
+        char digitos[10];
+        for (int i = 9; i >= 0; --i)
+        {
+            digitos[i] = static_cast<char>('0' + numero % 10);
+            numero /= 10;
+        }
+        escribir(string_view(digitos, sizeof(digitos)));
+    }
+
+    // Método para agregar un contacto en el formato del modo por lotes: "nombre|apellido|numero|email"
+    void escribirContacto(const AlmacenContactos &almacen, uint32_t contacto)
+    {
+        escribir(almacen.getNombre(contacto));
+        escribir('|');
+        escribir(almacen.getApellido(contacto));
+        escribir('|');
+        escribirNumeroCelular(almacen.getNumeroEmpaquetado(contacto));
+        escribir('|');
+        escribir(almacen.getEmail(contacto));
+        escribir('\n');
+    }
+
+    // Método para agregar un contacto leído del árbol en disco, en el mismo formato
+    void escribirContacto(const ContactoArbol &contacto)
+    {
+        escribir(contacto.nombre);
+        escribir('|');
+        escribir(contacto.apellido);
+        escribir('|');
+        escribirNumeroCelular(contacto.numero);
+        escribir('|');
+        escribir(contacto.email);
+        escribir('\n');
+    }
+};
+
+// Función para separar una línea del modo por lotes en sus campos (separados por '|')
+// Guarda a lo sumo 'maximo' campos; el último se queda con el resto de la línea. Retorna cuántos guardó.
+size_t separarCampos(string_view linea, string_view campos[], size_t maximo)
+{
+    size_t cantidad = 0;
+    while (cantidad + 1 < maximo)
+    {
+        size_t separador = linea.find('|');
+        if (separador == string_view::npos)
+        {
+            break;
+        }
+        campos[cantidad++] = linea.substr(0, separador);
+        linea.remove_prefix(separador + 1);
+    }
+    campos[cantidad++] = linea;
+    return cantidad;
+}
+
+// Función para leer el límite opcional de una búsqueda, que es el campo 'posicion' (por ejemplo el tercero en
+// "prefix|inicio[|limite]"); 20 si no se indica
+size_t leerLimiteBusqueda(const string_view campos[], size_t cantidad, size_t posicion)
+{
+    size_t limite = 20;
+    if (cantidad == posicion + 1)
+    {
+        limite = 0;
+        for (char c : campos[posicion])
+        {
+            limite = (c >= '0' && c <= '9') ? limite * 10 + static_cast<size_t>(c - '0') : 0;
+        }
+    }
+    return limite;
+}
+
+// Función para ubicar un contacto por su nombre exacto, como lo hacen las opciones del menú
+// Retorna 'true' y guarda su partición y su posición dentro de la partición si lo encuentra
+bool ubicarPorNombre(const AgendaContactos &agenda, string_view nombre, size_t &particion, int &posicion)
+{
+    if (calcularLetraInicial(nombre) < 0)
+    {
+        return false;
+    }
+    particion = agenda.particiones.ubicar(nombre);
+    return busquedaBinaria(agenda.almacen, agenda.particiones.getContactos(particion), nombre, posicion);
+}
+
+#ifdef AGENDA_ESTADISTICAS
+// Función para escribir las líneas del comando "stats" que no dependen de dónde están los contactos:
+// una por operación ("operacion|cantidad|promedio|p50|p99|p999|maximo", en nanosegundos), "bytes|escritos"
+// y "reservas|cantidad"
+void escribirLatenciasLote(SalidaLote &salida)
+{
+    char linea[200];
+    for (int operacion = 0; operacion < CANTIDAD_OPERACIONES; ++operacion)
+    {
+        const HistogramaLatencias &latencias = estadisticasAgenda.latencias[operacion];
+        snprintf(linea, sizeof(linea), "%s|%llu|%llu|%llu|%llu|%llu|%llu\n", NOMBRES_OPERACIONES[operacion],
+                 static_cast<unsigned long long>(latencias.getCantidad()),
+                 static_cast<unsigned long long>(latencias.getPromedio()),
+                 static_cast<unsigned long long>(latencias.calcularPercentil(50)),
+                 static_cast<unsigned long long>(latencias.calcularPercentil(99)),
+                 static_cast<unsigned long long>(latencias.calcularPercentil(99.9)),
+                 static_cast<unsigned long long>(latencias.getMaximo()));
+        salida.escribir(linea);
+    }
+    salida.escribir("bytes|" + to_string(estadisticasAgenda.bytesEscritos.load()) + "\n");
+    salida.escribir("reservas|" + to_string(reservasMemoria.load()) + "\n");
+}
+#endif
+
+// Función para escribir en el modo por lotes el resultado de 'buscarPorGrupo': la cantidad total de contactos
+// que cumplen la búsqueda y luego los primeros 'limite'
+void escribirGrupoLote(AgendaContactos &agenda, string_view apellido, string_view dominio, size_t limite, SalidaLote &salida)
+{
+    // Se reutiliza entre comandos para no pedir memoria en cada búsqueda
+    static vector<uint32_t> encontrados;
+    encontrados.clear();
+    size_t total = buscarPorGrupo(agenda, apellido, dominio, limite, [&](uint32_t id)
+                                  { encontrados.push_back(id); });
+    salida.escribir(to_string(total));
+    salida.escribir('\n');
+    for (uint32_t id : encontrados)
+    {
+        salida.escribirContacto(agenda.almacen, id);
+    }
+}
+
+// Función para ejecutar en el modo por lotes el comando "dedup" (ver 'ejecutarComandoLote')
+void escribirFusionLote(AgendaContactos &agenda, string_view textoPolitica, string_view textoCriterios,
+                        string_view rutaInforme, SalidaLote &salida)
+{
+    PoliticaFusion politica;
+    if (textoPolitica == "primero")
+    {
+        politica = FUSION_PRIMERO;
+    }
+    else if (textoPolitica == "ultimo")
+    {
+        politica = FUSION_ULTIMO;
+    }
+    else if (textoPolitica == "mayoria")
+    {
+        politica = FUSION_MAYORIA;
+    }
+    else
+    {
+        salida.escribir("error|politica no valida\n");
+        return;
+    }
+
+    ConfiguracionDuplicados configuracion;
+    configuracion.criterios = 0;
+    while (!textoCriterios.empty())
+    {
+        size_t separador = textoCriterios.find('+');
+        string_view criterio = textoCriterios.substr(0, separador);
+        textoCriterios.remove_prefix(separador == string_view::npos ? textoCriterios.size() : separador + 1);
+        if (criterio == "numero")
+        {
+            configuracion.criterios |= DUPLICADO_NUMERO;
+        }
+        else if (criterio == "email")
+        {
+            configuracion.criterios |= DUPLICADO_EMAIL;
+        }
+        else if (criterio == "nombre")
+        {
+            configuracion.criterios |= DUPLICADO_NOMBRE;
+        }
+        else
+        {
+            configuracion.criterios = 0;
+            break;
+        }
+    }
+    if (configuracion.criterios == 0)
+    {
+        salida.escribir("error|criterios no validos\n");
+        return;
+    }
+
+    GruposDuplicados grupos = detectarDuplicados(agenda, configuracion);
+    if (!rutaInforme.empty())
+    {
+        ofstream informe{string(rutaInforme)};
+        if (!informe.is_open())
+        {
+            salida.escribir("error|no se pudo crear el informe\n");
+            return;
+        }
+        escribirInformeDuplicados(agenda, grupos, politica, informe);
+    }
+    size_t eliminados = fusionarDuplicados(agenda, grupos, politica);
+    salida.escribir(to_string(grupos.getCantidadGrupos()) + "|" + to_string(eliminados) + "\n");
+}
+
+// Función para ejecutar un comando del modo por lotes y escribir su resultado en 'salida'
+// Comandos (los campos se separan con '|'):
+//   add|nombre|apellido|numero|email      Agrega un contacto                 -> "ok" o "error|motivo"
+//   find|nombre                           Busca un contacto por nombre       -> el contacto o "no encontrado"
+//   num|numero                            Busca un contacto por número       -> el contacto o "no encontrado"
+//   prefix|inicio[|limite]                Busca por el inicio del nombre     -> la cantidad y luego los contactos
+//   surname|apellido[|limite]             Busca por apellido                 -> la cantidad total y luego los primeros contactos
+//   atdomain|dominio[|limite]             Busca por dominio del email        -> la cantidad total y luego los primeros contactos
+//   group|apellido|dominio[|limite]       Busca por apellido y dominio a la vez -> la cantidad total y luego los primeros contactos
+//   edit|nombre|nombre|apellido|numero|email  Reemplaza los datos de un contacto -> "ok" o "error|motivo"
+//   del|nombre                            Elimina un contacto                -> "ok" o "no encontrado"
+//   save                                  Confirma los cambios del diario    -> "ok"
+//   domain|viejo|nuevo                    Cambia el dominio de los emails    -> cantidad de emails cambiados
+//   dedup|politica|criterios[|informe]    Fusiona los contactos duplicados   -> "grupos|eliminados"
+//                                         (politica: primero, ultimo o mayoria; criterios: numero, email y/o nombre
+//                                         unidos con '+', por ejemplo "numero+email"; el informe es un archivo)
+//   shards                                Tamaño de las particiones          -> "particiones|contactos|minimo|maximo|promedio|desviacion|lapidas"
+//   stats                                 Estadísticas (-DAGENDA_ESTADISTICAS) -> la cantidad de líneas y luego una por operación
+//                                         ("operacion|cantidad|promedio|p50|p99|p999|maximo", en nanosegundos),
+//                                         "bytes|escritos", "reservas|cantidad" y "particiones|..." (como 'shards');
+//                                         sin las estadísticas, "error|estadisticas desactivadas"
+// Los contactos se escriben como "nombre|apellido|numero|email".
+void ejecutarComandoLote(AgendaContactos &agenda, string_view linea, SalidaLote &salida)
+{
+    string_view campos[6];
+    size_t cantidad = separarCampos(linea, campos, 6);
+    string_view comando = campos[0];
+    size_t particion;
+    int posicion;
+    uint32_t contacto;
+
+    if (comando == "add" && cantidad == 5)
+    {
+        MedicionOperacion medicion(OPERACION_AGREGAR);
+        if (!validarNumeroCelular(campos[3]))
+        {
+            salida.escribir("error|numero no valido\n");
+        }
+        else if (!validarEmail(campos[4]))
+        {
+            salida.escribir("error|email no valido\n");
+        }
+        else if (registrarContacto(agenda, campos[1], campos[2], campos[3], campos[4]) == numeric_limits<uint32_t>::max())
+        {
+            salida.escribir("error|nombre no valido\n");
+        }
+        else
+        {
+            salida.escribir("ok\n");
+        }
+    }
+    else if (comando == "find" && cantidad == 2)
+    {
+        MedicionOperacion medicion(OPERACION_BUSCAR);
+        if (ubicarPorNombre(agenda, campos[1], particion, posicion))
+        {
+            salida.escribirContacto(agenda.almacen, agenda.particiones.getContactos(particion)[posicion]);
+        }
+        else
+        {
+            salida.escribir("no encontrado\n");
+        }
+    }
+    else if (comando == "num" && cantidad == 2)
+    {
+        if (validarNumeroCelular(campos[1]) &&
+            localizarPorNumero(agenda, empaquetarNumeroCelular(campos[1]), contacto))
+        {
+            salida.escribirContacto(agenda.almacen, contacto);
+        }
+        else
+        {
+            salida.escribir("no encontrado\n");
+        }
+    }
+    else if (comando == "prefix" && (cantidad == 2 || cantidad == 3))
+    {
+        size_t limite = leerLimiteBusqueda(campos, cantidad, 2);
+        // Se reutiliza entre comandos para no pedir memoria en cada búsqueda
+        static vector<uint32_t> encontrados;
+        encontrados.clear();
+        buscarPorPrefijo(agenda, campos[1], limite, [&](uint32_t id)
+                         { encontrados.push_back(id); });
+        salida.escribir(to_string(encontrados.size()));
+        salida.escribir('\n');
+        for (uint32_t id : encontrados)
+        {
+            salida.escribirContacto(agenda.almacen, id);
+        }
+    }
+    else if (comando == "surname" && (cantidad == 2 || cantidad == 3) && !campos[1].empty())
+    {
+        escribirGrupoLote(agenda, campos[1], string_view(), leerLimiteBusqueda(campos, cantidad, 2), salida);
+    }
+    else if (comando == "atdomain" && (cantidad == 2 || cantidad == 3) && !campos[1].empty())
+    {
+        escribirGrupoLote(agenda, string_view(), campos[1], leerLimiteBusqueda(campos, cantidad, 2), salida);
+    }
+    else if (comando == "group" && (cantidad == 3 || cantidad == 4) && !campos[1].empty() && !campos[2].empty())
+    {
+        escribirGrupoLote(agenda, campos[1], campos[2], leerLimiteBusqueda(campos, cantidad, 3), salida);
+    }
+    else if (comando == "edit" && cantidad == 6)
+    {
+        MedicionOperacion medicion(OPERACION_EDITAR);
+        if (!ubicarPorNombre(agenda, campos[1], particion, posicion))
+        {
+            salida.escribir("no encontrado\n");
+        }
+        else if (!validarNumeroCelular(campos[4]))
+        {
+            salida.escribir("error|numero no valido\n");
+        }
+        else if (!validarEmail(campos[5]))
+        {
+            salida.escribir("error|email no valido\n");
+        }
+        else if (calcularLetraInicial(campos[2]) < 0)
+        {
+            salida.escribir("error|nombre no valido\n");
+        }
+        else
+        {
+            // Si el nombre cambia, 'modificarContacto' reubica al contacto en la partición que le corresponde
+            modificarContacto(agenda, agenda.particiones.getContactos(particion)[posicion], campos[2], campos[3],
+                              campos[4], campos[5]);
+            salida.escribir("ok\n");
+        }
+    }
+    else if (comando == "del" && cantidad == 2)
+    {
+        MedicionOperacion medicion(OPERACION_ELIMINAR);
+        if (ubicarPorNombre(agenda, campos[1], particion, posicion))
+        {
+            borrarContacto(agenda, particion, static_cast<size_t>(posicion));
+            salida.escribir("ok\n");
+        }
+        else
+        {
+            salida.escribir("no encontrado\n");
+        }
+    }
+    else if (comando == "save" && cantidad == 1)
+    {
+        if (agenda.diario != nullptr)
+        {
+            agenda.diario->confirmar();
+        }
+        salida.escribir("ok\n");
+    }
+    else if (comando == "domain" && cantidad == 3)
+    {
+        // El dominio nuevo se valida como parte de un email cualquiera
+        if (!validarEmail("usuario@" + string(campos[2])))
+        {
+            salida.escribir("error|email no valido\n");
+        }
+        else
+        {
+            salida.escribir(to_string(cambiarDominioEmails(agenda, campos[1], campos[2])));
+            salida.escribir('\n');
+        }
+    }
+    else if (comando == "dedup" && (cantidad == 3 || cantidad == 4))
+    {
+        escribirFusionLote(agenda, campos[1], campos[2], cantidad == 4 ? campos[3] : string_view(), salida);
+    }
+    else if (comando == "shards" && cantidad == 1)
+    {
+        EstadisticasParticiones estadisticas = agenda.particiones.calcularEstadisticas();
+        char linea[160];
+        snprintf(linea, sizeof(linea), "%zu|%zu|%zu|%zu|%.1f|%.1f|%zu\n", estadisticas.cantidad, estadisticas.contactos,
+                 estadisticas.minimo, estadisticas.maximo, estadisticas.promedio, estadisticas.desviacion,
+                 estadisticas.borrados);
+        salida.escribir(linea);
+    }
+    else if (comando == "stats" && cantidad == 1)
+    {
+#ifdef AGENDA_ESTADISTICAS
+        char linea[160];
+        salida.escribir(to_string(CANTIDAD_OPERACIONES + 3));
+        salida.escribir('\n');
+        escribirLatenciasLote(salida);
+        EstadisticasParticiones estadisticas = agenda.particiones.calcularEstadisticas();
+        snprintf(linea, sizeof(linea), "particiones|%zu|%zu|%zu|%zu|%.1f|%.1f|%zu\n", estadisticas.cantidad,
+                 estadisticas.contactos, estadisticas.minimo, estadisticas.maximo, estadisticas.promedio,
+                 estadisticas.desviacion, estadisticas.borrados);
+        salida.escribir(linea);
+#else
+        salida.escribir("error|estadisticas desactivadas\n");
+#endif
+    }
+    else
+    {
+        salida.escribir("error|comando no valido\n");
+    }
+}
+
+// Función para ejecutar la agenda en modo por lotes (sin menú ni preguntas)
+// Lee los comandos del archivo 'rutaComandos' o, si es "-", de la entrada estándar, una línea por comando
+// (las líneas vacías y las que comienzan con '#' se ignoran), y ejecuta cada uno con 'ejecutarComando(linea, salida)'
+// ('ejecutarComandoLote' para la agenda en memoria o 'ejecutarComandoDisco' para el árbol en disco). Los
+// resultados van a la salida estándar y el resumen con los comandos por segundo a la salida de errores, para
+// no mezclarlo con los resultados. Retorna la cantidad de comandos ejecutados.
+template <typename Ejecutor>
+size_t ejecutarLote(const string &rutaComandos, Ejecutor ejecutarComando)
+{
+    // Los comandos se leen completos antes de empezar, así el tiempo medido es solo el de ejecutarlos
+    unique_ptr<ArchivoMapeado> archivo;
+    vector<char> entrada;
+    const char *datos;
+    size_t tamano;
+    if (rutaComandos == "-")
+    {
+        char bloque[1 << 16];
+        size_t leidos;
+        while ((leidos = fread(bloque, 1, sizeof(bloque), stdin)) > 0)
+        {
+            entrada.insert(entrada.end(), bloque, bloque + leidos);
+        }
+        datos = entrada.data();
+        tamano = entrada.size();
+    }
+    else
+    {
+        archivo = make_unique<ArchivoMapeado>(rutaComandos);
+        datos = archivo->getDatos();
+        tamano = archivo->getTamano();
+    }
+
+    SalidaLote salida(stdout);
+    size_t comandos = 0;
+    auto inicio = chrono::steady_clock::now();
+
+    const char *cursor = datos;
+    const char *fin = datos + tamano;
+    while (cursor < fin)
+    {
+        const char *finLinea = static_cast<const char *>(memchr(cursor, '\n', static_cast<size_t>(fin - cursor)));
+        if (finLinea == nullptr)
+        {
+            finLinea = fin;
+        }
+        string_view linea(cursor, static_cast<size_t>(finLinea - cursor));
+        if (!linea.empty() && linea.back() == '\r')
+        {
+            linea.remove_suffix(1);
+        }
+        cursor = finLinea + 1;
+
+        if (linea.empty() || linea[0] == '#')
+        {
+            continue;
+        }
+        ejecutarComando(linea, salida);
+        comandos++;
+    }
+    salida.vaciar();
+
+    double segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+    cerr << "Se ejecutaron " << comandos << " comandos en " << segundos * 1000.0 << " ms ("
+         << static_cast<size_t>(segundos > 0.0 ? comandos / segundos : 0.0) << " comandos/s)." << endl;
+    return comandos;
+}
+
+// MODO EN DISCO
+
+// Función para agregar un contacto al árbol en disco
+void agregarContactoDisco(ArbolContactos &arbol)
+{
+    string nombre, apellido, email, numeroDeCelular;
+    cout << "Ingrese el nombre: ";
+    getline(cin, nombre);
+    cout << "Ingrese el apellido: ";
+    getline(cin, apellido);
+    numeroDeCelular = pedirNumeroCelular();
+    cout << "Ingrese el EMAIL: ";
+    getline(cin, email);
+
+    if (!validarEmail(email))
+    {
+        cout << "Email no válido." << endl;
+    }
+    else if (calcularLetraInicial(nombre) < 0)
+    {
+        cout << " El nombre debe comenzar con una letra." << endl;
+    }
+    else
+    {
+        bool agregado;
+        {
+            MedicionOperacion medicion(OPERACION_AGREGAR);
+            agregado = arbol.agregar(nombre, apellido, numeroDeCelular, email);
+        }
+        if (!agregado)
+        {
+            cout << "Los datos del contacto son demasiado largos (o ya hay demasiados con ese nombre y ese numero)." << endl;
+        }
+    }
+}
+
+// Función para buscar un contacto en el árbol en disco
+void buscarContactoDisco(ArbolContactos &arbol)
+{
+    string nombre;
+    cout << "Ingrese el nombre: ";
+    getline(cin, nombre);
+
+    ContactoArbol contacto;
+    if (calcularLetraInicial(nombre) < 0)
+    {
+        cout << "El nombre debe comenzar con una letra del alfabeto." << endl;
+        return;
+    }
+    bool encontrado;
+    {
+        MedicionOperacion medicion(OPERACION_BUSCAR);
+        encontrado = arbol.buscar(nombre, contacto);
+    }
+    if (encontrado)
+    {
+        contacto.getContacto().mostrarContacto();
+    }
+    else
+    {
+        cout << "El nombre no se encontró." << endl;
+    }
+}
+
+// Función para editar un contacto del árbol en disco (el primero, por número, con el nombre pedido)
+// Los campos que se dejan vacíos no cambian
+void editarContactoDisco(ArbolContactos &arbol)
+{
+    string nombre;
+    cout << "Ingrese el nombre del contacto que quiere modificar: ";
+    getline(cin, nombre);
+
+    ContactoArbol contacto;
+    if (!arbol.buscar(nombre, contacto))
+    {
+        cout << "El nombre no se encontró para ser editado." << endl;
+        return;
+    }
+    string nuevoNombre, nuevoApellido, nuevoNumero, nuevoEmail;
+    cout << "Ingrese el nuevo nombre (Enter para no cambiarlo): ";
+    getline(cin, nuevoNombre);
+    if (!nuevoNombre.empty() && calcularLetraInicial(nuevoNombre) < 0)
+    {
+        cout << "El nombre debe comenzar con una letra del alfabeto." << endl;
+        return;
+    }
+    cout << "Ingrese el nuevo apellido (Enter para no cambiarlo): ";
+    getline(cin, nuevoApellido);
+    while (true)
+    {
+        cout << "Ingrese el nuevo numero de celular (Enter para no cambiarlo): ";
+        getline(cin, nuevoNumero);
+        if (nuevoNumero.empty() || validarNumeroCelular(nuevoNumero))
+        {
+            break;
+        }
+        cout << "Numero de celular no valido. " << endl;
+    }
+    cout << "Ingrese el nuevo email (Enter para no cambiarlo): ";
+    getline(cin, nuevoEmail);
+    if (!nuevoEmail.empty() && !validarEmail(nuevoEmail))
+    {
+        cout << "Email no válido." << endl;
+        return;
+    }
+
+    bool actualizado;
+    {
+        MedicionOperacion medicion(OPERACION_EDITAR);
+        actualizado = arbol.editar(contacto.nombre, contacto.numero, nuevoNombre.empty() ? contacto.nombre : nuevoNombre,
+                                   nuevoApellido.empty() ? contacto.apellido : nuevoApellido,
+                                   nuevoNumero.empty() ? contacto.numero : empaquetarNumeroCelular(nuevoNumero),
+                                   nuevoEmail.empty() ? contacto.email : nuevoEmail);
+    }
+    if (actualizado)
+    {
+        cout << "Contacto actualizado exitosamente." << endl;
+    }
+    else
+    {
+        cout << "Los datos nuevos son demasiado largos (o ya hay demasiados contactos con ese nombre y ese numero)." << endl;
+    }
+}
+
+// Función para eliminar un contacto del árbol en disco (el primero, por número, con el nombre pedido)
+void eliminarContactoDisco(ArbolContactos &arbol)
+{
+    string nombre;
+    cout << "Ingrese el nombre para eliminar contacto: ";
+    getline(cin, nombre);
+
+    ContactoArbol contacto;
+    bool eliminado;
+    {
+        MedicionOperacion medicion(OPERACION_ELIMINAR);
+        eliminado = arbol.buscar(nombre, contacto) && arbol.eliminar(contacto.nombre, contacto.numero);
+    }
+    if (eliminado)
+    {
+        cout << "Contacto eliminado exitosamente." << endl;
+    }
+    else
+    {
+        cout << "No se encontró el contacto para eliminar." << endl;
+    }
+}
+
+// Función para mostrar el estado del árbol en disco, de su búfer de páginas y las latencias de las operaciones
+void mostrarEstadisticasDisco(const ArbolContactos &arbol)
+{
+    const BuferPaginas &bufer = arbol.getBufer();
+    cout << "Arbol: " << arbol.getCantidad() << " contactos, altura " << arbol.getAltura() << ", "
+         << bufer.getCantidadPaginas() << " paginas de " << TAMANO_PAGINA / 1024 << " KB" << endl;
+    cout << "Bufer: " << bufer.getCantidadMarcos() << " marcos, " << bufer.getLecturas() << " paginas leidas y "
+         << bufer.getEscrituras() << " escritas" << endl;
+    mostrarLatencias();
+}
+
+// Función para escribir la línea del modo por lotes con el estado del árbol en disco y su búfer:
+// "paginas|cantidad|marcos|lecturas|escrituras|altura|contactos"
+void escribirPaginasLote(const ArbolContactos &arbol, SalidaLote &salida)
+{
+    const BuferPaginas &bufer = arbol.getBufer();
+    char linea[160];
+    snprintf(linea, sizeof(linea), "paginas|%u|%zu|%llu|%llu|%u|%llu\n", bufer.getCantidadPaginas(),
+             bufer.getCantidadMarcos(), static_cast<unsigned long long>(bufer.getLecturas()),
+             static_cast<unsigned long long>(bufer.getEscrituras()), arbol.getAltura(),
+             static_cast<unsigned long long>(arbol.getCantidad()));
+    salida.escribir(linea);
+}
+
+// Función para ejecutar un comando del modo por lotes sobre el árbol en disco
+// Los comandos y sus respuestas son los del modo en memoria (ver 'ejecutarComandoLote'); "edit" y "del"
+// actúan sobre el primer contacto (por número) con ese nombre. Además:
+//   pages                                 Estado del árbol y del búfer       -> "paginas|cantidad|marcos|lecturas|escrituras|altura|contactos"
+//   stats                                 Como en memoria, pero la última línea es la de 'pages'
+// No hay búsquedas por número ni por prefijo, ni cambios de dominio: el árbol solo está ordenado por nombre.
+void ejecutarComandoDisco(ArbolContactos &arbol, string_view linea, SalidaLote &salida)
+{
+    string_view campos[6];
+    size_t cantidad = separarCampos(linea, campos, 6);
+    string_view comando = campos[0];
+    // Se reutiliza entre comandos para no pedir memoria en cada búsqueda
+    static ContactoArbol contacto;
+
+    if (comando == "add" && cantidad == 5)
+    {
+        MedicionOperacion medicion(OPERACION_AGREGAR);
+        if (!validarNumeroCelular(campos[3]))
+        {
+            salida.escribir("error|numero no valido\n");
+        }
+        else if (!validarEmail(campos[4]))
+        {
+            salida.escribir("error|email no valido\n");
+        }
+        else if (calcularLetraInicial(campos[1]) < 0)
+        {
+            salida.escribir("error|nombre no valido\n");
+        }
+        else if (!arbol.agregar(campos[1], campos[2], campos[3], campos[4]))
+        {
+            salida.escribir("error|no se pudo guardar\n");
+        }
+        else
+        {
+            salida.escribir("ok\n");
+        }
+    }
+    else if (comando == "find" && cantidad == 2)
+    {
+        MedicionOperacion medicion(OPERACION_BUSCAR);
+        if (arbol.buscar(campos[1], contacto))
+        {
+            salida.escribirContacto(contacto);
+        }
+        else
+        {
+            salida.escribir("no encontrado\n");
+        }
+    }
+    else if (comando == "edit" && cantidad == 6)
+    {
+        MedicionOperacion medicion(OPERACION_EDITAR);
+        if (!arbol.buscar(campos[1], contacto))
+        {
+            salida.escribir("no encontrado\n");
+        }
+        else if (!validarNumeroCelular(campos[4]))
+        {
+            salida.escribir("error|numero no valido\n");
+        }
+        else if (!validarEmail(campos[5]))
+        {
+            salida.escribir("error|email no valido\n");
+        }
+        else if (calcularLetraInicial(campos[2]) < 0)
+        {
+            salida.escribir("error|nombre no valido\n");
+        }
+        else if (!arbol.editar(contacto.nombre, contacto.numero, campos[2], campos[3],
+                               empaquetarNumeroCelular(campos[4]), campos[5]))
+        {
+            salida.escribir("error|no se pudo guardar\n");
+        }
+        else
+        {
+            salida.escribir("ok\n");
+        }
+    }
+    else if (comando == "del" && cantidad == 2)
+    {
+        MedicionOperacion medicion(OPERACION_ELIMINAR);
+        if (arbol.buscar(campos[1], contacto) && arbol.eliminar(contacto.nombre, contacto.numero))
+        {
+            salida.escribir("ok\n");
+        }
+        else
+        {
+            salida.escribir("no encontrado\n");
+        }
+    }
+    else if (comando == "save" && cantidad == 1)
+    {
+        arbol.guardar();
+        salida.escribir("ok\n");
+    }
+    else if (comando == "pages" && cantidad == 1)
+    {
+        escribirPaginasLote(arbol, salida);
+    }
+    else if (comando == "stats" && cantidad == 1)
+    {
+#ifdef AGENDA_ESTADISTICAS
+        salida.escribir(to_string(CANTIDAD_OPERACIONES + 3));
+        salida.escribir('\n');
+        escribirLatenciasLote(salida);
+        escribirPaginasLote(arbol, salida);
+#else
+        salida.escribir("error|estadisticas desactivadas\n");
+#endif
+    }
+    else
+    {
+        salida.escribir("error|comando no valido\n");
+    }
+}
+
+// Función para crear el árbol en disco ("contactos.arbol") la primera vez que se usa el modo en disco
+// Se importa del archivo binario sin cargarlo en memoria. Si el diario tiene cambios (que quizá todavía no
+// están en el archivo binario) o no hay archivo binario, antes se recupera la agenda como en el modo en
+// memoria y se vuelve a escribir el archivo binario. Desde entonces los cambios del modo en disco quedan
+// solo en el árbol (para volver a importar los del modo en memoria, se borra "contactos.arbol").
+void prepararArbolDisco(bool comprimir, size_t bytesMemoria)
+{
+    if (filesystem::exists("contactos.arbol"))
+    {
+        return;
+    }
+    bool hayCambios = !listarSegmentosDiario("contactos.diario").empty();
+    hayCambios = hayCambios || (filesystem::exists("contactos.diario") && filesystem::file_size("contactos.diario") > 0);
+    if (hayCambios || !filesystem::exists("contactos.agdb"))
+    {
+        AgendaContactos agenda;
+        uint64_t ultimaSecuencia = recuperarAgenda(agenda, comprimir);
+        guardarInstantanea(agenda, "contactos.agdb", ultimaSecuencia, comprimir);
+    }
+
+    auto inicio = chrono::steady_clock::now();
+    uint64_t cantidad = importarArbolContactos("contactos.agdb", "contactos.arbol", bytesMemoria);
+    double segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+    cout << "Se importaron " << cantidad << " contactos al árbol en disco en " << segundos << " s." << endl;
+}
+
+// Función para ejecutar la agenda con los contactos en el árbol en disco, usando a lo sumo 'bytesMemoria'
+// para sus páginas: con "--lote [archivo]" ejecuta los comandos del archivo y, sin modo, muestra un menú con
+// las operaciones que el árbol permite. Retorna el código de salida del programa.
+int ejecutarModoDisco(bool comprimir, size_t bytesMemoria, int argc, char *argv[])
+{
+    bool lote = argc >= 2 && string(argv[1]) == "--lote";
+    if (argc >= 2 && !lote)
+    {
+        cerr << "Con --disco solo están el menú y el modo por lotes." << endl;
+        return 1;
+    }
+    try
+    {
+        // En el modo por lotes los mensajes de la importación van a la salida de errores
+        streambuf *salidaOriginal = cout.rdbuf();
+        if (lote)
+        {
+            cout.rdbuf(cerr.rdbuf());
+        }
+        prepararArbolDisco(comprimir, bytesMemoria);
+        cout.rdbuf(salidaOriginal);
+
+        // El árbol guarda las páginas modificadas al destruirse, incluso si ocurre una excepción
+        ArbolContactos arbol("contactos.arbol", bytesMemoria);
+        if (lote)
+        {
+            ejecutarLote(argc >= 3 ? argv[2] : "-", [&](string_view linea, SalidaLote &salida)
+                         { ejecutarComandoDisco(arbol, linea, salida); });
+            return 0;
+        }
+
+        int opcion;
+        do
+        {
+            cout << endl;
+            cout << "MENU AGENDA DE CONTACTOS (EN DISCO) " << endl;
+            cout << "1. Agregar contacto. " << endl;
+            cout << "2. Buscar contacto. " << endl;
+            cout << "3. Editar contacto. " << endl;
+            cout << "4. Eliminar contacto. " << endl;
+            cout << "5. Guardar contacto. " << endl;
+            cout << "6. Ver estadisticas. " << endl;
+            cout << "7. Salir. " << endl;
+            cout << "Elegir una opcion: ";
+            cin >> opcion;
+            if (cin.fail())
+            {
+                cin.clear();
+                cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                cout << endl;
+                cout << "Opcion no valida. Por favor, ingrese un número entero entre 1 y 7." << endl;
+                continue;
+            }
+            cin.ignore();
+
+            switch (opcion)
+            {
+            case 1:
+                agregarContactoDisco(arbol);
+                break;
+            case 2:
+                buscarContactoDisco(arbol);
+                break;
+            case 3:
+                editarContactoDisco(arbol);
+                break;
+            case 4:
+                eliminarContactoDisco(arbol);
+                break;
+            case 5: // Escribe las páginas modificadas y marca el archivo como cerrado bien
+                arbol.guardar();
+                cout << "Contactos guardados en el archivo exitosamente." << endl;
+                break;
+            case 6:
+                mostrarEstadisticasDisco(arbol);
+                break;
+            case 7:
+                cout << "Gracias por usar la agenda de contactos. ¡Hasta pronto!" << endl;
+                break;
+            default:
+                cout << "Opción no válida. " << endl;
+            }
+        } while (opcion != 7);
+    }
+    catch (const exception &errorGeneral)
+    {
+        (lote ? cerr : cout) << "Error inesperado: " << errorGeneral.what() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+#ifndef _WIN32
+// MODO SERVICIO
+
+// Estado compartido del modo servicio
+// Los cambios se aplican a la agenda con 'candadoEscritura' (los de cada lectura de un cliente, todos juntos) y un
+// hilo los publica por tandas como versiones inmutables; las consultas se responden con la última versión
+// publicada, sin tomar candados.
+struct ServicioAgenda
+{
+    AgendaContactos &agenda;
+    PublicadorVersiones publicador;
+    chrono::milliseconds intervaloPublicacion{5}; // Espera para juntar varios cambios en la misma versión
+
+    mutex candadoEscritura; // Protege la agenda, 'nombresCambiados', 'todoCambio' y 'hayCambios'
+    condition_variable avisoCambios;
+    vector<string> nombresCambiados; // Nombres que cambiaron desde la última publicación (para ubicar sus particiones)
+    bool todoCambio = false;
+    bool hayCambios = false;
+    bool terminando = false;
+
+    mutex candadoClientes; // Protege 'clientes'
+    condition_variable avisoClientes;
+    vector<int> clientes; // Descriptores de las conexiones abiertas
+
+    explicit ServicioAgenda(AgendaContactos &agenda) : agenda(agenda), publicador(agenda) {}
+};
+
+// Función para anotar los nombres que cambia un comando de escritura (add, edit, del, domain o dedup)
+// La publicación copia solo las particiones de esos nombres. Retorna 'false' si el comando no es de escritura.
+bool marcarCambios(ServicioAgenda &servicio, string_view linea)
+{
+    // Con 4 campos el nombre nuevo de 'edit' queda solo en el tercero (el resto de la línea va en el cuarto)
+    string_view campos[4];
+    size_t cantidad = separarCampos(linea, campos, 4);
+    // 'domain' y 'dedup' pueden cambiar contactos de cualquier partición
+    if (campos[0] == "domain" || campos[0] == "dedup")
+    {
+        servicio.todoCambio = true;
+        return true;
+    }
+    if (cantidad < 2 || (campos[0] != "add" && campos[0] != "edit" && campos[0] != "del"))
+    {
+        return false;
+    }
+    // El primer campo es el nombre del contacto; en 'edit' el segundo es el nombre nuevo (en 'add' es el apellido)
+    servicio.nombresCambiados.emplace_back(campos[1]);
+    if (campos[0] == "edit" && cantidad >= 3)
+    {
+        servicio.nombresCambiados.emplace_back(campos[2]);
+    }
+    return true;
+}
+
+// Función para responder una consulta (find, num o prefix) con una versión publicada de la agenda
+// Retorna 'false' si la línea no es una consulta
+bool responderConsulta(const VersionAgenda &version, string_view linea, SalidaLote &salida)
+{
+    string_view campos[3];
+    size_t cantidad = separarCampos(linea, campos, 3);
+    string_view comando = campos[0];
+    const GrupoInmutable *grupo;
+    uint32_t contacto;
+
+    if (comando == "find" && cantidad == 2)
+    {
+        MedicionOperacion medicion(OPERACION_BUSCAR);
+        if (buscarEnVersion(version, campos[1], grupo, contacto))
+        {
+            salida.escribirContacto(grupo->almacen, contacto);
+        }
+        else
+        {
+            salida.escribir("no encontrado\n");
+        }
+        return true;
+    }
+    if (comando == "num" && cantidad == 2)
+    {
+        if (validarNumeroCelular(campos[1]) &&
+            buscarNumeroEnVersion(version, empaquetarNumeroCelular(campos[1]), grupo, contacto))
+        {
+            salida.escribirContacto(grupo->almacen, contacto);
+        }
+        else
+        {
+            salida.escribir("no encontrado\n");
+        }
+        return true;
+    }
+    if (comando == "prefix" && (cantidad == 2 || cantidad == 3))
+    {
+        size_t limite = leerLimiteBusqueda(campos, cantidad, 2);
+        thread_local vector<pair<const GrupoInmutable *, uint32_t>> encontrados;
+        encontrados.clear();
+        buscarPrefijoEnVersion(version, campos[1], limite, [&](const GrupoInmutable &encontrado, uint32_t id)
+                               { encontrados.emplace_back(&encontrado, id); });
+        salida.escribir(to_string(encontrados.size()));
+        salida.escribir('\n');
+        for (const auto &[encontrado, id] : encontrados)
+        {
+            salida.escribirContacto(encontrado->almacen, id);
+        }
+        return true;
+    }
+    return false;
+}
+
+// Función que atiende a un cliente del modo servicio hasta que cierre la conexión
+// Lee todo lo que el cliente haya enviado y responde las líneas completas en dos pasadas: primero las consultas,
+// con la versión publicada y sin candados, y después los cambios, todos con una sola toma de 'candadoEscritura'
+// y ya fuera de la época (así una consulta nunca espera a los escritores, y un lector que espera el candado no
+// retiene versiones retiradas). Las respuestas se envían juntas y en el orden de las líneas. Responder una
+// consulta antes que un cambio anterior de la misma lectura no altera lo que ve: las consultas solo ven los
+// cambios desde la siguiente publicación.
+void atenderCliente(ServicioAgenda &servicio, int descriptor)
+{
+    int ranura = servicio.publicador.registrarLector();
+    FILE *destino = (ranura >= 0) ? fdopen(dup(descriptor), "w") : nullptr;
+    if (destino != nullptr)
+    {
+        setvbuf(destino, nullptr, _IONBF, 0); // 'SalidaLote' ya junta las respuestas
+        SalidaLote salida(destino, 1 << 16);
+        SalidaLote respuestas(nullptr, 1 << 16); // Respuestas de una lectura, en el orden en que se calculan
+        vector<pair<size_t, size_t>> tramos;    // Dónde quedó en 'respuestas' la respuesta de cada línea
+        vector<pair<size_t, string_view>> cambios; // Líneas que se aplican a la agenda (con su lugar en 'tramos')
+        vector<char> entrada(1 << 16);
+        size_t usados = 0;
+
+        while (true)
+        {
+            if (usados == entrada.size())
+            {
+                entrada.resize(entrada.size() * 2); // Una línea más larga que el búfer
+            }
+            ssize_t leidos = read(descriptor, entrada.data() + usados, entrada.size() - usados);
+            if (leidos < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (leidos <= 0)
+            {
+                break;
+            }
+            usados += static_cast<size_t>(leidos);
+
+            const char *cursor = entrada.data();
+            const char *fin = cursor + usados;
+            respuestas.descartar();
+            tramos.clear();
+            cambios.clear();
+            const VersionAgenda *version = servicio.publicador.entrar(ranura);
+            while (const char *salto = static_cast<const char *>(memchr(cursor, '\n', static_cast<size_t>(fin - cursor))))
+            {
+                string_view linea(cursor, static_cast<size_t>(salto - cursor));
+                cursor = salto + 1;
+                if (!linea.empty() && linea.back() == '\r')
+                {
+                    linea.remove_suffix(1);
+                }
+                if (linea.empty())
+                {
+                    continue;
+                }
+                size_t inicio = respuestas.getUsados();
+                if (!responderConsulta(*version, linea, respuestas))
+                {
+                    cambios.emplace_back(tramos.size(), linea);
+                }
+                tramos.emplace_back(inicio, respuestas.getUsados());
+            }
+            servicio.publicador.salir(ranura);
+
+            // Los cambios (y los comandos no válidos) se aplican a la agenda como en el modo por lotes
+            if (!cambios.empty())
+            {
+                {
+                    lock_guard<mutex> bloqueo(servicio.candadoEscritura);
+                    for (const auto &[linea, texto] : cambios)
+                    {
+                        size_t inicio = respuestas.getUsados();
+                        ejecutarComandoLote(servicio.agenda, texto, respuestas);
+                        tramos[linea] = make_pair(inicio, respuestas.getUsados());
+                        if (marcarCambios(servicio, texto))
+                        {
+                            servicio.hayCambios = true;
+                        }
+                    }
+                }
+                servicio.avisoCambios.notify_one();
+            }
+            for (const auto &[inicio, finTramo] : tramos)
+            {
+                salida.escribir(respuestas.getTexto(inicio, finTramo));
+            }
+            salida.vaciar();
+
+            // Lo que quedó sin salto de línea se completa con la siguiente lectura
+            usados = static_cast<size_t>(fin - cursor);
+            memmove(entrada.data(), cursor, usados);
+        }
+    }
+    else
+    {
+        const char mensaje[] = "error|demasiados clientes\n";
+        ssize_t escritos = write(descriptor, mensaje, sizeof(mensaje) - 1);
+        (void)escritos;
+    }
+
+    if (destino != nullptr)
+    {
+        fclose(destino);
+    }
+    if (ranura >= 0)
+    {
+        servicio.publicador.liberarLector(ranura);
+    }
+
+    // El descriptor se cierra con el candado tomado, para que al terminar no se cierre dos veces
+    lock_guard<mutex> bloqueo(servicio.candadoClientes);
+    servicio.clientes.erase(find(servicio.clientes.begin(), servicio.clientes.end(), descriptor));
+    close(descriptor);
+    servicio.avisoClientes.notify_all();
+}
+
+// Función del hilo que publica los cambios: espera a que haya alguno, junta los que lleguen durante
+// 'intervaloPublicacion' y publica una versión nueva copiando solo las particiones que cambiaron
+void publicarCambios(ServicioAgenda &servicio)
+{
+    unique_lock<mutex> bloqueo(servicio.candadoEscritura);
+    while (true)
+    {
+        servicio.avisoCambios.wait(bloqueo, [&]()
+                                   { return servicio.hayCambios || servicio.terminando; });
+        if (servicio.terminando)
+        {
+            break;
+        }
+        bloqueo.unlock();
+        this_thread::sleep_for(servicio.intervaloPublicacion);
+        bloqueo.lock();
+
+        servicio.publicador.publicar(servicio.agenda, servicio.nombresCambiados, servicio.todoCambio);
+        servicio.nombresCambiados.clear();
+        servicio.todoCambio = false;
+        servicio.hayCambios = false;
+    }
+}
+
+// Indica que se pidió terminar el modo servicio (Ctrl+C o SIGTERM)
+volatile sig_atomic_t terminarServicio = 0;
+
+void pedirTerminarServicio(int) { terminarServicio = 1; }
+
+// Función para ejecutar la agenda en modo servicio: atiende a muchos clientes a la vez por un socket local
+// (Unix) en 'rutaSocket'. Cada cliente envía comandos como los del modo por lotes, uno por línea, y recibe las
+// respuestas en el mismo orden. Las consultas (find, num y prefix) se responden con la última versión
+// publicada; los cambios se aplican a la agenda de inmediato y los ven las consultas desde la siguiente
+// publicación (unos milisegundos después). Termina con Ctrl+C o SIGTERM.
+void ejecutarServicio(AgendaContactos &agenda, const string &rutaSocket)
+{
+    int servidor = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (servidor < 0)
+    {
+        throw runtime_error("No se pudo crear el socket del servicio.");
+    }
+    sockaddr_un direccion{};
+    direccion.sun_family = AF_UNIX;
+    if (rutaSocket.size() >= sizeof(direccion.sun_path))
+    {
+        close(servidor);
+        throw runtime_error("La ruta del socket es demasiado larga.");
+    }
+    strcpy(direccion.sun_path, rutaSocket.c_str());
+    unlink(rutaSocket.c_str()); // Un socket que quedó de una ejecución anterior
+    if (bind(servidor, reinterpret_cast<sockaddr *>(&direccion), sizeof(direccion)) != 0 || listen(servidor, 128) != 0)
+    {
+        close(servidor);
+        throw runtime_error("No se pudo escuchar en el socket " + rutaSocket + ".");
+    }
+
+    // Un cliente que cierra la conexión no debe terminar el programa al escribirle
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, pedirTerminarServicio);
+    signal(SIGTERM, pedirTerminarServicio);
+
+    ServicioAgenda servicio(agenda);
+    thread hiloPublicacion(publicarCambios, ref(servicio));
+    cerr << "Atendiendo en " << rutaSocket << " (Ctrl+C para terminar)." << endl;
+
+    // Se revisa cada 200 ms si se pidió terminar
+    while (!terminarServicio)
+    {
+        pollfd espera{servidor, POLLIN, 0};
+        if (poll(&espera, 1, 200) <= 0)
+        {
+            continue;
+        }
+        int cliente = accept(servidor, nullptr, nullptr);
+        if (cliente < 0)
+        {
+            continue;
+        }
+        {
+            lock_guard<mutex> bloqueo(servicio.candadoClientes);
+            servicio.clientes.push_back(cliente);
+        }
+        thread(atenderCliente, ref(servicio), cliente).detach();
+    }
+    close(servidor);
+    unlink(rutaSocket.c_str());
+
+    // Se cortan las conexiones abiertas y se espera a que terminen sus hilos
+    {
+        unique_lock<mutex> bloqueo(servicio.candadoClientes);
+        for (int cliente : servicio.clientes)
+        {
+            shutdown(cliente, SHUT_RDWR);
+        }
+        servicio.avisoClientes.wait(bloqueo, [&]()
+                                    { return servicio.clientes.empty(); });
+    }
+    {
+        lock_guard<mutex> bloqueo(servicio.candadoEscritura);
+        servicio.terminando = true;
+    }
+    servicio.avisoCambios.notify_one();
+    hiloPublicacion.join();
+    cerr << "Servicio terminado." << endl;
+}
+#endif
+
+// Función principal
+// Con "--lote [archivo]" ejecuta los comandos del archivo (o de la entrada estándar) en lugar del menú, y con
+// "--servicio [socket]" atiende los comandos de muchos clientes por un socket local (por omisión "agenda.sock")
+// Antes del modo (o solas, para el menú) pueden ir estas opciones:
+//   --comprimir     el archivo binario se guarda en el formato comprimido
+//   --disco         los contactos están en el árbol en disco ("contactos.arbol") en lugar de en memoria
+//   --memoria MB    memoria para las páginas del árbol en disco (por omisión 256 MB)
+int main(int argc, char *argv[])
+{
+    // Agenda con el almacén de contactos y sus particiones por rangos de nombres
+    AgendaContactos agenda;
+    int opcion; // Variable que almacena la opción seleccionada por el usuario
+
+    // Las opciones del modo se leen a partir de la siguiente a las opciones generales
+    ConfiguracionDiario configuracion;
+    bool enDisco = false;
+    size_t megabytesMemoria = 256;
+    while (argc >= 2)
+    {
+        string opcionGeneral = argv[1];
+        if (opcionGeneral == "--comprimir")
+        {
+            configuracion.comprimirInstantanea = true;
+        }
+        else if (opcionGeneral == "--disco")
+        {
+            enDisco = true;
+        }
+        else if (opcionGeneral == "--memoria" && argc >= 3)
+        {
+            megabytesMemoria = strtoul(argv[2], nullptr, 10);
+            argv++;
+            argc--;
+        }
+        else
+        {
+            break;
+        }
+        argv++;
+        argc--;
+    }
+
+    // MODO EN DISCO
+    if (enDisco)
+    {
+        return ejecutarModoDisco(configuracion.comprimirInstantanea, megabytesMemoria << 20, argc, argv);
+    }
+
+    // MODO POR LOTES Y MODO SERVICIO
+    if (argc >= 2 && (string(argv[1]) == "--lote" || string(argv[1]) == "--servicio"))
+    {
+        string modo = argv[1];
+        try
+        {
+            // Los mensajes de la carga van a la salida de errores para no mezclarse con los resultados
+            streambuf *salidaOriginal = cout.rdbuf(cerr.rdbuf());
+            uint64_t ultimaSecuencia = recuperarAgenda(agenda, configuracion.comprimirInstantanea);
+            cout.rdbuf(salidaOriginal);
+
+            // Sin nadie esperando cada respuesta, el diario confirma grupos más grandes que en el menú
+            configuracion.entradasPorGrupo = 4096;
+            DiarioCambios diario("contactos.diario", "contactos.agdb", ultimaSecuencia + 1, configuracion);
+            agenda.diario = &diario;
+
+            if (modo == "--lote")
+            {
+                ejecutarLote(argc >= 3 ? argv[2] : "-", [&](string_view linea, SalidaLote &salida)
+                             { ejecutarComandoLote(agenda, linea, salida); });
+            }
+            else
+            {
+#ifndef _WIN32
+                ejecutarServicio(agenda, argc >= 3 ? argv[2] : "agenda.sock");
+#else
+                cerr << "El modo servicio no está disponible en Windows." << endl;
+                return 1;
+#endif
+            }
+        }
+        catch (const exception &errorGeneral)
+        {
+            cerr << "Error inesperado: " << errorGeneral.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // try-catch para manejar errores, como problemas al guardar el archivo o errores inesperados
+    try
+    {
+        // Recupera los contactos guardados en ejecuciones anteriores y abre el diario donde se anotan los cambios
+        // El diario confirma lo pendiente al salir del bloque, incluso si ocurre una excepción
+        uint64_t ultimaSecuencia = recuperarAgenda(agenda, configuracion.comprimirInstantanea);
+        DiarioCambios diario("contactos.diario", "contactos.agdb", ultimaSecuencia + 1, configuracion);
+        agenda.diario = &diario;
+
+        // El ciclo se repite hasta que el usuario seleccione la opción 12 (Salir)
+        do
+        {
+            // Muestra el menú de opciones para el usuario
+            cout << endl;
+            cout << "MENU AGENDA DE CONTACTOS " << endl;
+            cout << "1. Agregar contacto. " << endl;
+            cout << "2. Buscar contacto. " << endl;
+            cout << "3. Editar contacto. " << endl;
+            cout << "4. Eliminar contacto. " << endl;
+            cout << "5. Guardar contacto. " << endl;
+            cout << "6. Buscar contacto por numero. " << endl;
+            cout << "7. Buscar contacto por inicio del nombre. " << endl;
+            cout << "8. Buscar contacto por nombre aproximado. " << endl;
+            cout << "9. Ver estadisticas. " << endl;
+            cout << "10. Buscar contactos por apellido o dominio del email. " << endl;
+            cout << "11. Buscar y fusionar contactos duplicados. " << endl;
+            cout << "12. Salir. " << endl;
+
+            // Solicita al usuario que elija una opción
+            cout << "Elegir una opcion: ";
+            cin >> opcion;
+
+            // VALIDACIÓN DE ENTRADA AL USUARIO
+            // Verifica si la entrada es válida. Si no, muestra un mensaje de error y repite el ciclo
+            if (cin.fail())
+            {
+                cin.clear();                                         // Limpia el estado de error y vuelve a funcionar
+                cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Descarta la entrada incorrecta
+                cout << endl;
+                cout << "Opcion no valida. Por favor, ingrese un número entero entre 1 y 12." << endl;
+                continue; // Vuelve a mostrar el menú si la entrada es incorrecta
+            }
+
+            // Limpia el buffer de entrada para evitar problemas con el getline posterior
+            cin.ignore();
+
+            // Ejecuta la opción correspondiente según la elección del usuario
+            switch (opcion)
+            {
+            case 1: // Agregar un nuevo contacto
+                agregarContacto(agenda);
+                break;
+            case 2: // Buscar un contacto por nombre
+                buscarContacto(agenda);
+                break;
+            case 3: // Editar un contacto existente
+                editarContacto(agenda);
+                break;
+            case 4: // Eliminar un contacto
+                eliminarContacto(agenda);
+                break;
+            case 5: // Guardar los contactos en un archivo
+                guardarContacto(agenda);
+                break;
+            case 6: // Buscar un contacto por número de celular
+                buscarContactoPorNumero(agenda);
+                break;
+            case 7: // Buscar contactos por el comienzo del nombre
+                buscarContactoPorPrefijo(agenda);
+                break;
+            case 8: // Buscar contactos con nombres parecidos (errores de escritura)
+                buscarContactoAproximado(agenda);
+                break;
+            case 9: // Mostrar las estadísticas de las operaciones y de las particiones
+                mostrarEstadisticas(agenda);
+                break;
+            case 10: // Buscar contactos por apellido, por dominio del email o por los dos
+                buscarContactoPorGrupo(agenda);
+                break;
+            case 11: // Buscar contactos duplicados y fusionarlos
+                fusionarContactosDuplicados(agenda);
+                break;
+            case 12: // Salir del programa
+                cout << "Gracias por usar la agenda de contactos. ¡Hasta pronto!" << endl;
+                break;
+            default: // Si la opción no es válida
+                cout << "Opción no válida. " << endl;
+            }
+        } while (opcion != 12); // Repite el ciclo hasta que el usuario elija salir (opción 12)
     }
     catch (const runtime_error &errorArchivo) // Captura errores relacionados con la apertura o manejo de archivos
     {